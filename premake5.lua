@@ -108,6 +108,10 @@ workspace 'Doom'
 			'data/shaders/**.glsl',
 		}
 
+		removefiles {
+			'source/doom/**_null.cpp',
+		}
+
 		vpaths {
 			["source/*"] = 'source/doom/**',
 			["shaders"] = 'data/shaders/**',
@@ -139,6 +143,45 @@ workspace 'Doom'
 			'ws2_32',
 		}
 
+	-- Same game, with null video/audio/network backends instead of the window, WGL context,
+	-- WASAPI device and sockets, for running -timedemo -benchreport on machines without a GPU.
+	project_common 'doom_headless'
+		kind 'ConsoleApp'
+		system (os.target())
+
+		debugdir '.'
+
+		defines { 'DOOM_HEADLESS' }
+
+		files {
+            'source/doom/**',
+		}
+
+		removefiles {
+			'source/doom/system/**',
+			'source/doom/i_video.cpp',
+			'source/doom/i_sound_wasapi.cpp',
+			'source/doom/i_net.cpp',
+		}
+
+		vpaths {
+			["source/*"] = 'source/doom/**',
+		}
+
+		includedirs {
+			'source/doom',
+			'source',
+		}
+
+		links {
+			'nstd',
+		}
+
+		filter 'system:linux'
+			links { 'pthread' }
+
+		filter {}
+
 	project_common 'tests'
 		kind 'ConsoleApp'
 
@@ -154,6 +197,8 @@ workspace 'Doom'
 
 		files {
             'source/tests/**',
+			'source/doom/video/spans.ixx',
+			'source/doom/jobs/jobs.ixx',
 		}
 
 		vpaths {
@@ -168,6 +213,43 @@ workspace 'Doom'
 			'nstd'
 		}
 
+	-- Micro-benchmarks for individual engine pieces, built from the same sources as the game.
+	project_common 'benchmarks'
+		kind 'ConsoleApp'
+		system (os.target())
+
+		debugdir '.'
+
+		filter 'Debug'
+			debugcommand ('bin/benchmarks_d.exe')
+
+		filter 'Release'
+			debugcommand ('bin/benchmarks.exe')
+
+		filter {}
+
+		files {
+			'source/benchmarks/**',
+			'source/doom/audio/mixer.ixx',
+			'source/doom/net/transport.ixx',
+			'source/doom/play/traverse.ixx',
+			'source/doom/video/blit.ixx',
+			'source/doom/wad/lumptable.ixx',
+		}
+
+		vpaths {
+			["source/*"] = { 'source/benchmarks/**', 'source/doom/**' },
+		}
+
+		includedirs {
+			'source/doom',
+			'source',
+		}
+
+		links {
+			'nstd',
+		}
+
 	project 'ipx_driver'
 		kind 'None'
 		characterset 'unicode'
@@ -0,0 +1,143 @@
+#include "m_fixed.h"
+
+import std;
+import nstd;
+
+void FixedDivOverflow()
+{
+    std::cerr << "FixedDiv: divide by zero\n";
+    std::abort();
+}
+
+namespace {
+
+// FixedMul and FixedDiv as they were: out of line in m_fixed.cpp, so every call was a call, and
+// FixedDiv dividing in double. Called through pointers here so they stay calls.
+fixed_t OldFixedMul(fixed_t a, fixed_t b)
+{
+    return ((long long)a * (long long)b) >> FRACBITS;
+}
+
+fixed_t OldFixedDiv(fixed_t a, fixed_t b)
+{
+    if ((std::abs(a) >> 14) >= std::abs(b))
+        return (a ^ b) < 0 ? std::numeric_limits<fixed_t>::min() : std::numeric_limits<fixed_t>::max();
+
+    double c = ((double)a) / ((double)b) * FRACUNIT;
+    if (c >= 2147483648.0 || c < -2147483648.0)
+        FixedDivOverflow();
+    return (fixed_t)c;
+}
+
+fixed_t (*volatile oldMul)(fixed_t, fixed_t) = OldFixedMul;
+fixed_t (*volatile oldDiv)(fixed_t, fixed_t) = OldFixedDiv;
+
+struct old_math
+{
+    static constexpr string_view name = "old";
+    static fixed_t mul(fixed_t a, fixed_t b) { return oldMul(a, b); }
+    static fixed_t div(fixed_t a, fixed_t b) { return oldDiv(a, b); }
+};
+
+struct inline_math
+{
+    static constexpr string_view name = "inline";
+    static fixed_t mul(fixed_t a, fixed_t b) { return FixedMul(a, b); }
+    static fixed_t div(fixed_t a, fixed_t b) { return FixedDiv(a, b); }
+};
+
+struct inputs
+{
+    vector<fixed_t> a;
+    vector<fixed_t> b;
+    vector<fixed_t> c;
+};
+
+// R_ScaleFromGlobalAngle, once per wall column.
+template<typename M>
+uint32 wall_scales(const inputs& in)
+{
+    uint32 sum = 0;
+    for (int32 n = 0; n < in.a.size(); ++n)
+    {
+        auto num = M::mul(160 * FRACUNIT, in.a[n]);
+        auto den = M::mul(in.b[n], in.c[n]);
+        auto scale = 64 * FRACUNIT;
+        if (den > num >> 16)
+            scale = std::clamp(M::div(num, den), 256, 64 * FRACUNIT);
+        sum += scale;
+    }
+    return sum;
+}
+
+// R_MapPlane, once per flat span.
+template<typename M>
+uint32 plane_spans(const inputs& in)
+{
+    uint32 sum = 0;
+    for (int32 n = 0; n < in.a.size(); ++n)
+    {
+        auto distance = M::mul(in.a[n], in.b[n]);
+        auto xstep = M::mul(distance, in.c[n]);
+        auto ystep = M::mul(distance, in.b[n]);
+        auto length = M::mul(distance, in.c[n] | FRACUNIT);
+        sum += xstep ^ ystep ^ length;
+    }
+    return sum;
+}
+
+// P_InterceptVector, once per line crossed by a trace.
+template<typename M>
+uint32 intercepts(const inputs& in)
+{
+    uint32 sum = 0;
+    for (int32 n = 0; n < in.a.size(); ++n)
+    {
+        auto den = M::mul(in.a[n] >> 8, in.b[n]) - M::mul(in.b[n] >> 8, in.c[n]);
+        if (den == 0)
+            continue;
+
+        auto num = M::mul(in.c[n] >> 8, in.a[n]) + M::mul(in.b[n] >> 8, in.c[n]);
+        sum += M::div(num, den);
+    }
+    return sum;
+}
+
+} // namespace
+
+// The fixed point math in the shape of the renderer's and the playsim's hottest loops, with the
+// old out of line FixedMul/FixedDiv and with the inline ones. For the whole game before and
+// after, -timedemo with -benchreport and -slaughter with -slaughterview.
+void bench_fixed([[maybe_unused]] const vector<string_view>& args)
+{
+    std::mt19937 random{1993};
+
+    constexpr int32 Count = 1 << 20;
+    inputs in;
+    for (auto* v : {&in.a, &in.b, &in.c})
+    {
+        v->resize(Count);
+        for (auto& n : *v)
+            n = static_cast<fixed_t>(random() % (2048u * FRACUNIT)) - 1024 * FRACUNIT;
+    }
+
+    auto run = [&]<typename M>(string_view kernel, uint32 (*f)(const inputs&), M)
+    {
+        constexpr int32 Repeats = 20;
+        uint32 check = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int32 r = 0; r < Repeats; ++r)
+            check += f(in);
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::format("  {:<12} {:<8} {:8.3f} ns/item ({:08x})\n",
+            kernel, M::name, ns / (static_cast<double>(Count) * Repeats), check);
+    };
+
+    run("walls", wall_scales<old_math>, old_math{});
+    run("walls", wall_scales<inline_math>, inline_math{});
+    run("planes", plane_spans<old_math>, old_math{});
+    run("planes", plane_spans<inline_math>, inline_math{});
+    run("intercepts", intercepts<old_math>, old_math{});
+    run("intercepts", intercepts<inline_math>, inline_math{});
+}
@@ -0,0 +1,182 @@
+import std;
+import nstd;
+import lumptable;
+
+namespace {
+
+struct lump_entry
+{
+    string name;
+    LumpNamespace ns = LumpNamespace::Global;
+};
+
+struct lookup
+{
+    string name;
+    LumpNamespace ns = LumpNamespace::Global;
+};
+
+// Reads the lump directory of a WAD, tracking the marker namespaces like WadManager does, and
+// the names in PNAMES.
+bool read_wad(const filesys::path& path, vector<lump_entry>& lumps, vector<string>& pnames)
+{
+    std::ifstream file{path, std::ios_base::binary};
+    if (!file.is_open())
+        return false;
+
+    char tag[4];
+    int32 count = 0;
+    int32 offset = 0;
+    file.read(tag, 4);
+    file.read(reinterpret_cast<char*>(&count), 4);
+    file.read(reinterpret_cast<char*>(&offset), 4);
+
+    struct header { int32 offset; int32 size; char name[8]; };
+    vector<header> directory(count);
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(directory.data()), count * sizeof(header));
+
+    auto ns = LumpNamespace::Global;
+    for (auto& entry : directory)
+    {
+        string_view raw{entry.name, 8};
+        string name = raw.trim().to_upper();
+        auto marker = true;
+        if (name == "S_START" || name == "SS_START") ns = LumpNamespace::Sprites;
+        else if (name == "F_START" || name == "FF_START") ns = LumpNamespace::Flats;
+        else if (name == "P_START" || name == "PP_START") ns = LumpNamespace::Patches;
+        else if (name == "S_END" || name == "SS_END" || name == "F_END" || name == "FF_END" || name == "P_END" || name == "PP_END") ns = LumpNamespace::Global;
+        else marker = false;
+
+        lumps.push_back({name, marker ? LumpNamespace::Global : ns});
+
+        if (name == "PNAMES")
+        {
+            vector<char> data(entry.size);
+            auto at = file.tellg();
+            file.seekg(entry.offset);
+            file.read(data.data(), entry.size);
+            file.seekg(at);
+
+            auto patches = *reinterpret_cast<const int32*>(data.data());
+            for (int32 n = 0; n < patches; ++n)
+                pnames.emplace_back(data.data() + 4 + n * 8, 8);
+        }
+    }
+    return true;
+}
+
+// Something shaped like doom2.wad: sprites, flats and patches between markers, and a PNAMES
+// list referring to the patches.
+void make_wad(vector<lump_entry>& lumps, vector<string>& pnames)
+{
+    lumps.push_back({"PLAYPAL"});
+    lumps.push_back({"COLORMAP"});
+    lumps.push_back({"TEXTURE1"});
+    lumps.push_back({"PNAMES"});
+    for (int32 n = 0; n < 32; ++n)
+        lumps.push_back({std::format("MAP{:02}", n + 1)});
+    for (int32 n = 0; n < 100; ++n)
+        lumps.push_back({std::format("DSSND{:03}", n)});
+
+    lumps.push_back({"S_START"});
+    for (int32 n = 0; n < 1400; ++n)
+        lumps.push_back({std::format("SP{:02}{}{}", n / 52, static_cast<char>('A' + n % 26), n % 2 ? "1" : "2D8"), LumpNamespace::Sprites});
+    lumps.push_back({"S_END"});
+
+    lumps.push_back({"P_START"});
+    for (int32 n = 0; n < 470; ++n)
+    {
+        lumps.push_back({std::format("WALL{:04}", n), LumpNamespace::Patches});
+        pnames.push_back(std::format("wall{:04}", n));
+    }
+    lumps.push_back({"P_END"});
+
+    lumps.push_back({"F_START"});
+    for (int32 n = 0; n < 150; ++n)
+        lumps.push_back({std::format("FLAT{:04}", n), LumpNamespace::Flats});
+    lumps.push_back({"F_END"});
+}
+
+} // namespace
+
+// Lump name lookups as done while loading: R_InitData resolves every PNAMES entry and the
+// markers, R_InitSprites every sprite lump of a modified game, P_Init and P_LoadSectors the flat
+// names, and S_Init every sound. Compares the old std::map<string, int32> directory with the
+// hashed one.
+void bench_lumps(const vector<string_view>& args)
+{
+    vector<lump_entry> lumps;
+    vector<string> pnames;
+
+    auto fromWad = !args.empty() && read_wad(filesys::path{args[0]}, lumps, pnames);
+    if (!fromWad)
+    {
+        lumps.clear();
+        pnames.clear();
+        make_wad(lumps, pnames);
+    }
+
+    std::map<string, int32> tree;
+    LumpTable table;
+    for (int32 n = 0; n < lumps.size(); ++n)
+    {
+        tree[lumps[n].name] = n;
+        auto key = PackLumpName(lumps[n].name);
+        table.Add(key, LumpNamespace::Global, n);
+        if (lumps[n].ns != LumpNamespace::Global)
+            table.Add(key, lumps[n].ns, n);
+    }
+
+    vector<lookup> lookups;
+    for (auto& name : pnames)
+        lookups.push_back({name, LumpNamespace::Patches});
+    for (auto& lump : lumps)
+    {
+        if (lump.ns == LumpNamespace::Sprites || lump.ns == LumpNamespace::Flats || lump.name.starts_with("DS"))
+            lookups.push_back({lump.name, lump.ns});
+    }
+    for (auto marker : {"S_START", "S_END", "F_START", "F_END", "PNAMES", "TEXTURE1", "TEXTURE2", "COLORMAP", "PLAYPAL"})
+        lookups.push_back({marker});
+
+    constexpr int32 Passes = 200;
+    int64 found = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int32 pass = 0; pass < Passes; ++pass)
+    {
+        for (auto& l : lookups)
+        {
+            // What GetLumpId used to do: build an upper cased string and search the tree.
+            string key = string_view{l.name}.trim().to_upper();
+            auto it = tree.find(key);
+            found += it != tree.end();
+        }
+    }
+    auto treeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int32 pass = 0; pass < Passes; ++pass)
+    {
+        for (auto& l : lookups)
+        {
+            // What WadManager::GetLumpId(name, ns) does: the last lump of the name, unless it's in
+            // another namespace.
+            auto key = PackLumpName(l.name);
+            auto id = table.Get(key);
+            if (id != INVALID_ID && l.ns != LumpNamespace::Global && lumps[id].ns != LumpNamespace::Global && lumps[id].ns != l.ns)
+            {
+                if (auto nsid = table.Get(key, l.ns); nsid != INVALID_ID)
+                    id = nsid;
+            }
+            found += id != INVALID_ID;
+        }
+    }
+    auto tableNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    auto total = static_cast<double>(lookups.size()) * Passes;
+    std::cout << std::format("  {} lumps, {} lookups per load ({})\n", lumps.size(), lookups.size(), fromWad ? args[0] : string_view{"synthetic"});
+    std::cout << std::format("  std::map    {:8.1f} ns/lookup\n", treeNs / total);
+    std::cout << std::format("  LumpTable   {:8.1f} ns/lookup\n", tableNs / total);
+    std::cout << std::format("  ({} found)\n", found);
+}
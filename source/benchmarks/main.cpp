@@ -0,0 +1,50 @@
+import std;
+import nstd;
+
+extern void bench_palette(const vector<string_view>& args);
+extern void bench_lumps(const vector<string_view>& args);
+extern void bench_mixer(const vector<string_view>& args);
+extern void bench_traverse(const vector<string_view>& args);
+extern void bench_walls(const vector<string_view>& args);
+extern void bench_net(const vector<string_view>& args);
+extern void bench_fixed(const vector<string_view>& args);
+
+struct benchmark
+{
+    string_view name;
+    void (*run)(const vector<string_view>& args);
+};
+
+static const benchmark benchmarks[] =
+{
+    {"palette", bench_palette},
+    {"lumps", bench_lumps},
+    {"mixer", bench_mixer},
+    {"traverse", bench_traverse},
+    {"walls", bench_walls},
+    {"net", bench_net},
+    {"fixed", bench_fixed},
+};
+
+// Runs every benchmark, or only the ones named on the command line. Any other arguments are
+// passed on to the benchmarks, e.g. the WAD to use.
+int main(int argc, char** argv)
+{
+    vector<string_view> selected;
+    vector<string_view> args;
+    for (int n = 1; n < argc; ++n)
+    {
+        string_view arg = argv[n];
+        auto isName = std::any_of(std::begin(benchmarks), std::end(benchmarks), [&](auto& b){ return b.name == arg; });
+        (isName ? selected : args).push_back(arg);
+    }
+
+    for (auto& b : benchmarks)
+    {
+        if (!selected.empty() && !selected.has(b.name))
+            continue;
+
+        std::cout << "[" << b.name << "]\n";
+        b.run(args);
+    }
+}
@@ -0,0 +1,160 @@
+import std;
+import nstd;
+import mixer;
+
+namespace {
+
+constexpr int32 BlockFrames = 512;
+constexpr int32 DeviceRepeat = 4;
+
+struct sound
+{
+    vector<uint8> data;
+    int32 length = 0;
+};
+
+// The mixer as it was: every output frame loops over every channel, through 8 bit to 16 bit
+// volume lookup tables, clamps to int16, and the device write converts back to float.
+struct reference_mixer
+{
+    vector<int32> volumes = vector<int32>(128 * 256);
+    vector<const uint8*> position;
+    vector<const uint8*> end;
+    vector<uint32> step;
+    vector<uint32> remainder;
+    vector<const int32*> left;
+    vector<const int32*> right;
+    int16 block[BlockFrames * 2];
+
+    reference_mixer()
+    {
+        for (int32 v = 0; v < 128; ++v)
+            for (int32 s = 0; s < 256; ++s)
+                volumes[v * 256 + s] = (v * (s - 128) * 256) / 127;
+    }
+
+    void mix(float* device)
+    {
+        for (int32 n = 0; n < BlockFrames; ++n)
+        {
+            int32 dl = 0;
+            int32 dr = 0;
+            for (int32 c = 0; c < position.size(); ++c)
+            {
+                if (!position[c])
+                    continue;
+
+                uint32 sample = *position[c];
+                dl += left[c][sample];
+                dr += right[c][sample];
+                remainder[c] += step[c];
+                position[c] += remainder[c] >> 16;
+                remainder[c] &= 65536 - 1;
+                if (position[c] >= end[c])
+                    position[c] = nullptr;
+            }
+            block[n * 2] = static_cast<int16>(std::clamp(dl, -0x8000, 0x7fff));
+            block[n * 2 + 1] = static_cast<int16>(std::clamp(dr, -0x8000, 0x7fff));
+        }
+
+        auto to_float = [](int16 n){ return static_cast<float>(n) / std::numeric_limits<int16>::max(); };
+        for (int32 n = 0; n < BlockFrames; ++n)
+        {
+            for (int32 r = 0; r < DeviceRepeat; ++r)
+            {
+                *device++ = to_float(block[n * 2]);
+                *device++ = to_float(block[n * 2 + 1]);
+            }
+        }
+    }
+};
+
+} // namespace
+
+// Sound effect mixing cost per output frame (one 11025 Hz stereo frame, written to a 44100 Hz
+// float device buffer), with every channel busy, for the old per-frame mixer and each mixer
+// kernel.
+void bench_mixer([[maybe_unused]] const vector<string_view>& args)
+{
+    std::mt19937 random{1993};
+
+    // Long enough that channels rarely run out, any that do are restarted.
+    vector<sound> sounds(16);
+    for (auto& s : sounds)
+    {
+        s.length = 32 * BlockFrames;
+        s.data.resize(s.length + mixer::Padding, 128);
+        for (int32 n = 0; n < s.length; ++n)
+            s.data[n] = static_cast<uint8>(128 + static_cast<int32>(std::sin(n * 0.05 * (1 + random() % 8)) * 100));
+    }
+
+    vector<float> device(BlockFrames * DeviceRepeat * 2);
+    constexpr int32 Blocks = 2000;
+
+    for (int32 channels : {8, 32, 128})
+    {
+        vector<int32> picks(channels), steps(channels), lefts(channels), rights(channels);
+        for (int32 c = 0; c < channels; ++c)
+        {
+            picks[c] = random() % sounds.size();
+            steps[c] = static_cast<int32>(std::pow(2.0, (static_cast<int32>(random() % 32) - 16) / 64.0) * 65536.0);
+            lefts[c] = random() % 128;
+            rights[c] = random() % 128;
+        }
+
+        reference_mixer reference;
+        reference.position.resize(channels);
+        reference.end.resize(channels);
+        reference.step.resize(channels);
+        reference.remainder.resize(channels);
+        reference.left.resize(channels);
+        reference.right.resize(channels);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int32 block = 0; block < Blocks; ++block)
+        {
+            for (int32 c = 0; c < channels; ++c)
+            {
+                if (reference.position[c])
+                    continue;
+
+                auto& s = sounds[picks[c]];
+                reference.position[c] = s.data.data();
+                reference.end[c] = s.data.data() + s.length;
+                reference.step[c] = steps[c];
+                reference.remainder[c] = 0;
+                reference.left[c] = &reference.volumes[lefts[c] * 256];
+                reference.right[c] = &reference.volumes[rights[c] * 256];
+            }
+            reference.mix(device.data());
+        }
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::format("  {:3} channels {:<9} {:8.2f} ns/frame\n", channels, "per-frame", ns / (Blocks * BlockFrames));
+
+        for (auto k : {mixer::kernel::scalar, mixer::kernel::avx2})
+        {
+            if (k > mixer::best_kernel())
+                continue;
+
+            vector<mixer::voice> voices(channels);
+            vector<float> bus(BlockFrames * 2);
+
+            start = std::chrono::steady_clock::now();
+            for (int32 block = 0; block < Blocks; ++block)
+            {
+                for (int32 c = 0; c < channels; ++c)
+                {
+                    if (voices[c].data)
+                        continue;
+
+                    auto& s = sounds[picks[c]];
+                    voices[c] = {s.data.data(), s.data.data() + s.length, static_cast<uint32>(steps[c]), 0, mixer::gain(lefts[c]), mixer::gain(rights[c])};
+                }
+                mixer::mix(k, voices, bus.data(), BlockFrames);
+                mixer::write_float(bus.data(), device.data(), BlockFrames, DeviceRepeat, 2);
+            }
+            ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            std::cout << std::format("  {:3} channels {:<9} {:8.2f} ns/frame\n", channels, mixer::name(k), ns / (Blocks * BlockFrames));
+        }
+    }
+}
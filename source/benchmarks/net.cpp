@@ -0,0 +1,72 @@
+import std;
+import nstd;
+import net;
+
+// Packet traffic of a 4 player netgame over the loopback transport, time stepped along one tic
+// at a time: every node sends every other node a packet with a few ticcmds each tic and takes
+// what arrived. Sent once per tic as a batch, and flushed after every packet the way the old
+// one datagram per I_NetCmd path went, on a clean link and a bad one. Latency is counted to when
+// a packet is taken, so it comes in whole tics.
+void bench_net([[maybe_unused]] const vector<string_view>& args)
+{
+    using namespace std::chrono_literals;
+
+    constexpr int32 Nodes = 4;
+    constexpr int32 Tics = 35 * 60 * 10;
+    constexpr int32 PacketLength = 8 + 3 * 8;
+    constexpr auto Tic = std::chrono::microseconds{1'000'000 / 35};
+
+    struct link { string_view name; net::link_conditions conditions; };
+    const link links[] =
+    {
+        {"lan", {}},
+        {"wan", {.latency = 60ms, .jitter = 20ms, .loss = 3}},
+    };
+
+    for (auto& [name, conditions] : links)
+    {
+        for (auto batched : {true, false})
+        {
+            net::loopback network{Nodes, conditions};
+            auto time = net::loopback::clock::time_point{};
+
+            int64 received = 0;
+            uint32 check = 0;
+
+            auto start = std::chrono::steady_clock::now();
+            for (int32 tic = 0; tic < Tics; ++tic)
+            {
+                time += Tic;
+                network.set_time(time);
+
+                for (int32 n = 0; n < Nodes; ++n)
+                {
+                    auto& endpoint = network.endpoint(n);
+                    for (int32 node = 1; node < Nodes; ++node)
+                    {
+                        auto& datagram = endpoint.prepare(node);
+                        datagram.length = PacketLength;
+                        std::fill_n(datagram.data.begin(), PacketLength, static_cast<byte>(tic + n));
+                        if (!batched)
+                            endpoint.flush();
+                    }
+                    endpoint.flush();
+
+                    while (auto* datagram = endpoint.receive())
+                    {
+                        check += datagram->data[0] + datagram->node;
+                        ++received;
+                    }
+                }
+            }
+            auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            auto& stats = network.stats();
+            auto latency = stats.delivered ? std::chrono::duration<double, std::milli>(stats.latency).count() / stats.delivered : 0.0;
+            std::cout << std::format("  {} {:<8} {:8.1f} ns/datagram {:6.2f} datagrams/batch {:6.2f}% lost {:6.1f} ms latency ({:x})\n",
+                name, batched ? "batched" : "single", ns / stats.sent,
+                static_cast<double>(stats.sent) / stats.batches,
+                100.0 * stats.lost / stats.sent, latency, check);
+        }
+    }
+}
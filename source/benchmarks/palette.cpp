@@ -0,0 +1,48 @@
+import std;
+import nstd;
+import blit;
+
+// Palette to RGBA conversion throughput, per kernel, at the original and the largest supported
+// resolution.
+void bench_palette([[maybe_unused]] const vector<string_view>& args)
+{
+    std::mt19937 random{1993};
+
+    uint32 palette[256];
+    for (auto& color : palette)
+        color = random() | 0xff'00'00'00;
+
+    struct resolution { int32 width; int32 height; };
+    for (auto [width, height] : {resolution{320, 200}, resolution{1120, 832}})
+    {
+        vector<byte> screen(width * height);
+        for (auto& index : screen)
+            index = static_cast<byte>(random());
+
+        vector<uint32> expected(width * height);
+        blit::convert_scalar(screen.data(), palette, expected.data(), width * height);
+
+        auto kernels = {blit::kernel::scalar, blit::kernel::avx2};
+        for (auto k : kernels)
+        {
+            if (k > blit::best_kernel())
+                continue;
+
+            vector<uint32> output(width * height);
+            constexpr int32 Frames = 500;
+
+            auto start = std::chrono::steady_clock::now();
+            for (int32 frame = 0; frame < Frames; ++frame)
+            {
+                for (int32 y = 0; y < height; ++y)
+                    blit::convert(k, screen.data() + y * width, palette, output.data() + y * width, width);
+            }
+            auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            auto pixels = static_cast<double>(width) * height * Frames;
+            std::cout << std::format("  {}x{} {:<8} {:8.3f} pixels/ns {:8.3f} ms/frame{}\n",
+                width, height, blit::name(k), pixels / ns, ns / Frames / 1'000'000.0,
+                output == expected ? "" : "  MISMATCH");
+        }
+    }
+}
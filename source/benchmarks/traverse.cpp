@@ -0,0 +1,119 @@
+import std;
+import nstd;
+import traverse;
+
+namespace {
+
+constexpr int32 FracUnit = 1 << 16;
+
+struct intercept
+{
+    int32 frac;
+    bool solid;
+};
+
+struct segment
+{
+    double x1, y1, x2, y2;
+    bool solid;
+};
+
+// Where along the trace it crosses the segment, in 16.16, or -1 if it doesn't.
+int32 crossing(double x, double y, double dx, double dy, const segment& s)
+{
+    auto sx = s.x2 - s.x1;
+    auto sy = s.y2 - s.y1;
+    auto den = dx * sy - dy * sx;
+    if (den == 0)
+        return -1;
+
+    auto t = ((s.x1 - x) * sy - (s.y1 - y) * sx) / den;
+    auto u = ((s.x1 - x) * dy - (s.y1 - y) * dx) / den;
+    if (t < 0 || t > 1 || u < 0 || u > 1)
+        return -1;
+
+    return static_cast<int32>(t * FracUnit);
+}
+
+} // namespace
+
+// The intercept ordering of P_PathTraverse over 10000 random traces through a large synthetic
+// map, lines of 64 to 512 units scattered over 16384 units square with one in eight one sided.
+// Traces are up to MISSILERANGE (2048 units) long. Hitscan stops at the first solid line, the
+// autoaim style traverser looks at everything in range. Compares the old rescan with the heap.
+void bench_traverse([[maybe_unused]] const vector<string_view>& args)
+{
+    std::mt19937 random{1993};
+    auto uniform = [&](double lo, double hi){ return std::uniform_real_distribution<double>{lo, hi}(random); };
+
+    constexpr double MapSize = 16384;
+    vector<segment> segments(40000);
+    for (auto& s : segments)
+    {
+        auto angle = uniform(0, 2 * std::numbers::pi);
+        auto length = uniform(64, 512);
+        s.x1 = uniform(0, MapSize);
+        s.y1 = uniform(0, MapSize);
+        s.x2 = s.x1 + std::cos(angle) * length;
+        s.y2 = s.y1 + std::sin(angle) * length;
+        s.solid = random() % 8 == 0;
+    }
+
+    constexpr int32 Traces = 10000;
+    vector<vector<intercept>> traces(Traces);
+    int64 total = 0;
+    int32 longest = 0;
+    for (auto& trace : traces)
+    {
+        auto x = uniform(0, MapSize);
+        auto y = uniform(0, MapSize);
+        auto angle = uniform(0, 2 * std::numbers::pi);
+        auto dx = std::cos(angle) * 2048;
+        auto dy = std::sin(angle) * 2048;
+
+        // Added in the order P_PathTraverse would: not sorted, so shuffle what the geometry gives.
+        for (auto& s : segments)
+        {
+            auto frac = crossing(x, y, dx, dy, s);
+            if (frac >= 0)
+                trace.push_back({frac, s.solid});
+        }
+        std::ranges::shuffle(trace, random);
+
+        total += trace.size();
+        longest = std::max(longest, trace.size());
+    }
+
+    std::cout << std::format("  {} traces, {:.1f} intercepts on average, {} at most\n", Traces, static_cast<double>(total) / Traces, longest);
+
+    constexpr int32 Passes = 20;
+    vector<intercept> work;
+    vector<uint64> heap;
+
+    auto run = [&](string_view name, bool hitscan, auto traverse)
+    {
+        int64 visited = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int32 pass = 0; pass < Passes; ++pass)
+        {
+            for (auto& trace : traces)
+            {
+                // Both get a fresh copy, the scan overwrites the fracs.
+                work.assign(trace.begin(), trace.end());
+                traverse(work.data(), work.data() + work.size(), [&](intercept* in)
+                {
+                    ++visited;
+                    return !(hitscan && in->solid);
+                });
+            }
+        }
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::format("  {:<8} {:<6} {:8.1f} ns/trace ({} visited)\n", hitscan ? "hitscan" : "autoaim", name, ns / (Passes * Traces), visited);
+    };
+
+    for (auto hitscan : {true, false})
+    {
+        run("scan", hitscan, [&](intercept* first, intercept* last, auto visit){ return TraverseByScan(first, last, FracUnit, visit); });
+        run("heap", hitscan, [&](intercept* first, intercept* last, auto visit){ return TraverseInOrder(first, last, FracUnit, heap, visit); });
+    }
+}
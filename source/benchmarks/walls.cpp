@@ -0,0 +1,187 @@
+import std;
+import nstd;
+
+namespace {
+
+constexpr int32 Width = 320;
+constexpr int32 Height = 200;
+constexpr int32 TextureSize = 128;
+constexpr int32 AtlasColumn = 128;
+
+// Wall textures laid out the way R_GenerateLookup leaves them: columns covered by one patch point
+// into the patch lump past the post header, columns covered by several into the composite.
+struct texture_set
+{
+    vector<vector<uint8>> lumps;          // one patch per lump, one 128 pixel post per column
+    vector<vector<int16>> columnlump;     // -1 for composite columns
+    vector<vector<uint16>> columnofs;
+    vector<vector<uint8>> composites;
+    vector<vector<uint8>> atlas;          // the same texture, AtlasColumn bytes per column
+};
+
+texture_set make_textures(int32 count, std::mt19937& random)
+{
+    texture_set set;
+
+    // Every patch column is a 3 byte post header, the pixels, a pad byte and the 0xff end marker.
+    constexpr int32 PostSize = 3 + TextureSize + 1 + 1;
+    for (int32 n = 0; n < count * 2; ++n)
+    {
+        auto& lump = set.lumps.emplace_back(8 + TextureSize * 4 + TextureSize * PostSize);
+        for (int32 x = 0; x < TextureSize; ++x)
+        {
+            auto offset = 8 + TextureSize * 4 + x * PostSize;
+            std::memcpy(&lump[8 + x * 4], &offset, 4);
+            for (int32 y = 0; y < TextureSize; ++y)
+                lump[offset + 3 + y] = static_cast<uint8>(random());
+        }
+    }
+
+    for (int32 t = 0; t < count; ++t)
+    {
+        // Two patches, overlapping over part of the width, like most multi-patch walls.
+        auto overlapStart = static_cast<int32>(random() % TextureSize);
+        auto overlapEnd = std::min(TextureSize, overlapStart + 16 + static_cast<int32>(random() % 48));
+
+        auto& lumps = set.columnlump.emplace_back(TextureSize);
+        auto& ofs = set.columnofs.emplace_back(TextureSize);
+        auto& composite = set.composites.emplace_back();
+        for (int32 x = 0; x < TextureSize; ++x)
+        {
+            auto lump = t * 2 + (x >= TextureSize / 2);
+            if (x >= overlapStart && x < overlapEnd)
+            {
+                lumps[x] = -1;
+                ofs[x] = static_cast<uint16>(composite.size());
+                composite.insert(composite.end(), TextureSize, static_cast<uint8>(random()));
+            }
+            else
+            {
+                int32 offset;
+                std::memcpy(&offset, &set.lumps[lump][8 + x * 4], 4);
+                lumps[x] = static_cast<int16>(lump + 1);
+                ofs[x] = static_cast<uint16>(offset + 3);
+            }
+        }
+
+        auto& block = set.atlas.emplace_back(TextureSize * AtlasColumn);
+        for (int32 x = 0; x < TextureSize; ++x)
+        {
+            auto* source = lumps[x] > 0 ? set.lumps[lumps[x] - 1].data() + ofs[x] : composite.data() + ofs[x];
+            std::memcpy(&block[x * AtlasColumn], source, AtlasColumn);
+        }
+    }
+    return set;
+}
+
+// What R_GetColumn does for a wall column.
+const uint8* get_column(const texture_set& set, int32 tex, int32 col)
+{
+    col &= TextureSize - 1;
+    auto lump = set.columnlump[tex][col];
+    auto ofs = set.columnofs[tex][col];
+    if (lump > 0)
+        return set.lumps[lump - 1].data() + ofs;
+
+    return set.composites[tex].data() + ofs;
+}
+
+const uint8* get_atlas_column(const texture_set& set, int32 tex, int32 col)
+{
+    return set.atlas[tex].data() + (col & (TextureSize - 1)) * AtlasColumn;
+}
+
+struct wall_column
+{
+    int32 tex;
+    int32 col;
+    int32 yl;
+    int32 yh;
+    uint32 frac;
+    uint32 step;
+};
+
+// R_DrawColumn's inner loop.
+void draw_column(const wall_column& w, const uint8* source, const uint8* colormap, uint8* screen, int32 x)
+{
+    auto* dest = screen + w.yl * Width + x;
+    auto frac = w.frac;
+    for (int32 y = w.yl; y <= w.yh; ++y)
+    {
+        *dest = colormap[source[(frac >> 16) & 127]];
+        dest += Width;
+        frac += w.step;
+    }
+}
+
+} // namespace
+
+// Wall drawing through R_GetColumn and through the -texatlas atlas, over frames where every
+// screen column has an upper and a lower wall, each from a short run of one of 300 textures. That
+// is busier than any real frame, to make the lookups stand out. Reports the time per frame for
+// the lookups alone and for lookups plus drawing.
+void bench_walls([[maybe_unused]] const vector<string_view>& args)
+{
+    std::mt19937 random{1993};
+    auto set = make_textures(300, random);
+
+    vector<uint8> colormap(256);
+    std::iota(colormap.begin(), colormap.end(), uint8{0});
+    vector<uint8> screen(Width * Height);
+
+    constexpr int32 Frames = 200;
+    vector<vector<wall_column>> frames(Frames);
+    for (auto& frame : frames)
+    {
+        for (int32 tier = 0; tier < 2; ++tier)
+        {
+            for (int32 x = 0; x < Width; )
+            {
+                // One wall segment: a run of screen columns stepping through the texture.
+                auto tex = static_cast<int32>(random() % set.atlas.size());
+                auto run = 8 + static_cast<int32>(random() % 56);
+                auto col = static_cast<int32>(random() % TextureSize);
+                auto colStep = 1 + static_cast<int32>(random() % 3);
+                auto yl = tier ? Height / 2 + static_cast<int32>(random() % 20) : static_cast<int32>(random() % 20);
+                auto yh = tier ? Height - 1 - static_cast<int32>(random() % 20) : Height / 2 - 1 - static_cast<int32>(random() % 20);
+                for (int32 n = 0; n < run && x < Width; ++n, ++x, col += colStep)
+                    frame.push_back({tex, col, yl, yh, static_cast<uint32>(random() % 65536), 0xc000u + static_cast<uint32>(random() % 0x8000)});
+            }
+        }
+    }
+
+    std::cout << std::format("  {} textures, {} KB atlas\n", set.atlas.size(), set.atlas.size() * TextureSize * AtlasColumn / 1024);
+
+    uint64 checksum = 0;
+    auto run = [&](string_view name, bool draw, auto lookup)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int32 pass = 0; pass < 5; ++pass)
+        {
+            for (auto& frame : frames)
+            {
+                for (int32 n = 0; n < frame.size(); ++n)
+                {
+                    auto& w = frame[n];
+                    auto* source = lookup(set, w.tex, w.col);
+                    if (draw)
+                        draw_column(w, source, colormap.data(), screen.data(), n % Width);
+                    else
+                        checksum += source[w.frac >> 16 & 127];
+                }
+            }
+        }
+        auto us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::format("  {:<7} {:<6} {:9.2f} us/frame\n", name, draw ? "draw" : "lookup", us / (5 * Frames));
+    };
+
+    for (auto draw : {false, true})
+    {
+        run("columns", draw, get_column);
+        run("atlas", draw, get_atlas_column);
+    }
+
+    for (auto pixel : screen)
+        checksum += pixel;
+    std::cout << std::format("  (checksum {})\n", checksum);
+}
@@ -0,0 +1,233 @@
+module;
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC lets any function use AVX2 intrinsics, GCC and Clang want it enabled per function.
+#if defined(__GNUC__)
+#define MIXER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MIXER_TARGET_AVX2
+#endif
+
+export module mixer;
+
+import std;
+import nstd;
+
+// Mixes 8 bit unsigned sound effects into a float stereo bus a whole block at a time, one voice
+// after the other, and writes the bus out clamped for the audio device.
+export namespace mixer {
+
+// Sound data has to be readable this far past a voice's end, the gather kernel loads a whole
+// int32 for its last sample.
+constexpr int32 Padding = 4;
+
+// One playing sound. The position is data plus frac, stepped by step per output frame, both
+// 16.16 fixed point.
+struct voice
+{
+    const uint8* data = nullptr; // nullptr while the voice is idle
+    const uint8* end = nullptr;
+    uint32 step = 1 << 16;
+    uint32 frac = 0;
+
+    // Gain per unit of (sample - 128), in int16 units.
+    float left = 0.0f;
+    float right = 0.0f;
+};
+
+// The gains the original vol_lookup tables had built in: volume 0..127 maps a full scale 8 bit
+// sample to a full scale 16 bit one.
+constexpr float gain(int32 volume)
+{
+    return volume * 256.0f / 127.0f;
+}
+
+enum class kernel : uint8
+{
+    scalar,
+    avx2,
+};
+
+constexpr string_view name(kernel k)
+{
+    switch (k)
+    {
+    case kernel::avx2: return "avx2";
+    case kernel::scalar:
+    default: return "scalar";
+    }
+}
+
+// The fastest kernel the CPU (and OS) supports.
+kernel best_kernel()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return kernel::scalar;
+
+    // AVX state has to be enabled by the OS too.
+    __cpuid(info, 1);
+    auto osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6)
+        return kernel::scalar;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) ? kernel::avx2 : kernel::scalar;
+#elif defined(__GNUC__)
+    return __builtin_cpu_supports("avx2") ? kernel::avx2 : kernel::scalar;
+#else
+    return kernel::scalar;
+#endif
+}
+
+// Adds count frames of the voice, starting at its current position, into the bus.
+void accumulate_scalar(const voice& v, float* bus, int32 count)
+{
+    for (int32 n = 0; n < count; ++n)
+    {
+        auto sample = static_cast<float>(v.data[(v.frac + n * v.step) >> 16]) - 128.0f;
+        bus[n * 2] += sample * v.left;
+        bus[n * 2 + 1] += sample * v.right;
+    }
+}
+
+// Steps 8 frames at a time: the positions are worked out in a vector, the samples fetched with
+// a byte offset gather, and the left and right products interleaved into the bus.
+MIXER_TARGET_AVX2 void accumulate_avx2(const voice& v, float* bus, int32 count)
+{
+    auto* source = reinterpret_cast<const int*>(v.data);
+    auto lanes = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(v.step)));
+    auto left = _mm256_set1_ps(v.left);
+    auto right = _mm256_set1_ps(v.right);
+    auto bias = _mm256_set1_epi32(128);
+    auto low = _mm256_set1_epi32(0xff);
+
+    int32 n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        auto position = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(v.frac + n * v.step)), lanes);
+        auto index = _mm256_srli_epi32(position, 16);
+        auto raw = _mm256_and_si256(_mm256_i32gather_epi32(source, index, 1), low);
+        auto sample = _mm256_cvtepi32_ps(_mm256_sub_epi32(raw, bias));
+
+        auto l = _mm256_mul_ps(sample, left);
+        auto r = _mm256_mul_ps(sample, right);
+        auto lo = _mm256_unpacklo_ps(l, r); // l0 r0 l1 r1 | l4 r4 l5 r5
+        auto hi = _mm256_unpackhi_ps(l, r); // l2 r2 l3 r3 | l6 r6 l7 r7
+
+        auto* out = bus + n * 2;
+        _mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_permute2f128_ps(lo, hi, 0x20)));
+        _mm256_storeu_ps(out + 8, _mm256_add_ps(_mm256_loadu_ps(out + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+    }
+
+    for (; n < count; ++n)
+    {
+        auto sample = static_cast<float>(v.data[(v.frac + n * v.step) >> 16]) - 128.0f;
+        bus[n * 2] += sample * v.left;
+        bus[n * 2 + 1] += sample * v.right;
+    }
+}
+
+// Clears the bus and mixes frames of every active voice into it, interleaved left and right.
+// Voices are advanced past the block, the ones that reach their end go idle.
+void mix(kernel k, std::span<voice> voices, float* bus, int32 frames)
+{
+    std::fill(bus, bus + frames * 2, 0.0f);
+
+    for (auto& v : voices)
+    {
+        if (!v.data || !v.step)
+            continue;
+
+        // The voice plays while its position is before the end.
+        auto length = static_cast<uint64>(v.end - v.data) << 16;
+        auto remaining = (length - v.frac + v.step - 1) / v.step;
+        auto count = static_cast<int32>(std::min<uint64>(frames, remaining));
+
+        if (k == kernel::avx2)
+            accumulate_avx2(v, bus, count);
+        else
+            accumulate_scalar(v, bus, count);
+
+        auto position = v.frac + static_cast<uint64>(count) * v.step;
+        v.data += position >> 16;
+        v.frac = position & 0xffff;
+        if (v.data >= v.end)
+            v.data = nullptr;
+    }
+}
+
+// Rounds and saturates the bus to 16 bit stereo, packs does the clamping.
+void write_int16(const float* bus, int16* dest, int32 frames)
+{
+    int32 n = 0;
+    for (; n + 4 <= frames; n += 4)
+    {
+        auto a = _mm_cvtps_epi32(_mm_loadu_ps(bus + n * 2));
+        auto b = _mm_cvtps_epi32(_mm_loadu_ps(bus + n * 2 + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + n * 2), _mm_packs_epi32(a, b));
+    }
+
+    for (n *= 2; n < frames * 2; ++n)
+        dest[n] = static_cast<int16>(std::clamp(std::lrint(bus[n]), -32768l, 32767l));
+}
+
+// Scales the bus to [-1, 1] float, clamped, and writes each frame repeat times to a device
+// buffer with the given number of channels, upsampling by repetition. Stereo devices take the
+// SSE path, anything else gets left on even and right on odd channels.
+void write_float(const float* bus, float* dest, int32 frames, int32 repeat, int32 channels)
+{
+    constexpr float Scale = 1.0f / 32767.0f;
+
+    if (channels == 2)
+    {
+        auto scale = _mm_set1_ps(Scale);
+        auto minimum = _mm_set1_ps(-1.0f);
+        auto maximum = _mm_set1_ps(1.0f);
+
+        int32 n = 0;
+        for (; n + 2 <= frames; n += 2)
+        {
+            auto v = _mm_mul_ps(_mm_loadu_ps(bus + n * 2), scale);
+            v = _mm_min_ps(_mm_max_ps(v, minimum), maximum);
+
+            auto first = _mm_movelh_ps(v, v);  // l0 r0 l0 r0
+            auto second = _mm_movehl_ps(v, v); // l1 r1 l1 r1
+            for (int32 r = 0; r + 2 <= repeat; r += 2, dest += 4)
+                _mm_storeu_ps(dest, first);
+            if (repeat & 1)
+            {
+                _mm_storel_pi(reinterpret_cast<__m64*>(dest), first);
+                dest += 2;
+            }
+            for (int32 r = 0; r + 2 <= repeat; r += 2, dest += 4)
+                _mm_storeu_ps(dest, second);
+            if (repeat & 1)
+            {
+                _mm_storel_pi(reinterpret_cast<__m64*>(dest), second);
+                dest += 2;
+            }
+        }
+        bus += n * 2;
+        frames -= n;
+    }
+
+    for (int32 n = 0; n < frames; ++n)
+    {
+        auto left = std::clamp(bus[n * 2] * Scale, -1.0f, 1.0f);
+        auto right = std::clamp(bus[n * 2 + 1] * Scale, -1.0f, 1.0f);
+        for (int32 r = 0; r < repeat; ++r)
+        {
+            for (int32 c = 0; c < channels; ++c)
+                *dest++ = c & 1 ? right : left;
+        }
+    }
+}
+
+} // export namespace mixer
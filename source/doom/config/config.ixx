@@ -28,8 +28,9 @@ public:
             return false;
 
         auto start = arg + 1;
-        while (arg != args.end() && arg->front() != '-') ++ arg;
-        out.insert(out.end(), start, arg);
+        auto stop = start;
+        while (stop != args.end() && stop->front() != '-') ++stop;
+        out.insert(out.end(), start, stop);
 
         return true;
     }
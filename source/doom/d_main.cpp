@@ -44,6 +44,7 @@
 #include "wi_stuff.h"
 #include "z_zone.h"
 #include "r_draw.h"
+#include "r_pipeline.h"
 
 //#include <cstdio>
 
@@ -51,6 +52,7 @@ import std;
 import config;
 import log;
 import input;
+import bench;
 
 
 #define BGCOLOR 7
@@ -308,7 +310,8 @@ void Doom::Main()
             "        You will not receive technical support for modified games.\n"
             "                      press enter to continue\n"
             "===========================================================================\n");
-        std::getchar();
+        if (!Video::IsHeadless)
+            std::getchar();
     }
 
     // Check and print which version is executed.
@@ -376,6 +379,12 @@ void Doom::Main()
         autostart = true;
     }
 
+    // keyframes every interval tics written next to the demo, and a tic to start it at
+    if (int32 interval; CommandLine::TryGetValues("-demoindex", interval))
+        G_DemoIndex(interval);
+    if (int32 tic; CommandLine::TryGetValues("-demoseek", tic))
+        G_DemoSeek(tic);
+
     if (string demo; CommandLine::TryGetValues("-playdemo", demo))
     {
         singledemo = true; // quit after one demo
@@ -385,11 +394,26 @@ void Doom::Main()
 
     if (string demo; CommandLine::TryGetValues("-timedemo", demo))
     {
+        // per-frame / per-tic timings and a final state checksum, written when the demo ends
+        if (string_view report; CommandLine::TryGetValues("-benchreport", report))
+            bench::enable(report);
+
         noDrawers = CommandLine::HasArg("-nodraw");
         G_TimeDemo(demo.c_str());
         Loop(); // never returns
     }
 
+    if (int32 monsters; CommandLine::TryGetValues("-slaughter", monsters))
+    {
+        // playsim throughput on the -warp level packed with monsters, -slaughtertics long,
+        // with -slaughterview drawing the crowd every tic as well
+        if (string_view report; CommandLine::TryGetValues("-benchreport", report))
+            bench::enable(report);
+
+        G_InitNew(startskill, startepisode, startmap);
+        G_SlaughterBench(monsters, CommandLine::GetValue<int32>("-slaughtertics", 35 * 30), CommandLine::HasArg("-slaughterview"));
+    }
+
     if (int32 load; CommandLine::TryGetValues("-loadgame", load))
         game->LoadGame(Game::GetSaveFilePath(load));
 
@@ -420,13 +444,26 @@ void Doom::Loop()
         debugfile.open(fileName, std::ios_base::out);
     }
 
+    // Draws as often as it can, the view between the last two tics.
+    isUncapped = CommandLine::HasArg("-uncapped") && !useSingleTicks;
+    interpolating = isUncapped;
+
     for (;;)
     {
+        bench::scoped_sample frameSample("frame");
+
         // frame synchronous IO operations
         video->StartFrame();
 
         // process one or more tics
-        if (useSingleTicks)
+        auto ranTics = true;
+        if (G_DemoPaused())
+        {
+            video->StartTick();
+            ProcessEvents();
+            ranTics = false;
+        }
+        else if (useSingleTicks)
         {
             video->StartTick();
             ProcessEvents();
@@ -438,15 +475,43 @@ void Doom::Loop()
             gametic++;
             maketic++;
         }
+        else if (isUncapped && !TicsAvailable())
+        {
+            ranTics = false; // nothing to run yet, draw the view further along instead
+        }
         else
         {
             TryRunTics(); // will run at least one tic
         }
 
+        // Seeks asked for by the events just taken.
+        if (G_DemoSeekPending())
+        {
+            G_DoDemoSeek();
+            ranTics = true;
+        }
+
+        auto now = bench::clock::now();
+        if (ranTics)
+            ticsDone = now;
+
+        // How far from the previous tic to the last one the view is drawn, all the way unless
+        // uncapped, and never past the last.
+        ticFrac = FRACUNIT;
+        if (isUncapped)
+            ticFrac = static_cast<fixed_t>(std::min(1.0, std::chrono::duration<double>(now - ticsDone).count() * TICRATE) * FRACUNIT);
+
+        // With -pipeline the render thread starts on the view of these tics right away.
+        if (gameState == GameState::Level && gametic)
+            R_PublishSnapshot(&players[displayplayer], ticFrac);
+
         S_UpdateSounds(players[consoleplayer].mo); // move positional sounds
 
         // Update display, next frame, with current state.
-        Display();
+        {
+            bench::scoped_sample renderSample("render");
+            Display();
+        }
 
         // Sound mixing for the buffer is snychronous.
         Sound::Update();
@@ -624,9 +689,9 @@ void Doom::Display()
         borderDrawCount = 3;
     }
 
-    // save the current screen if about to wipe
+    // save the current screen if about to wipe, the headless build has nobody to show it to
     bool wipe = false;
-    if (gameState != wipegamestate)
+    if (gameState != wipegamestate && !Video::IsHeadless)
     {
         wipe = true;
         wipe_StartScreen(0, 0, SCREENWIDTH, SCREENHEIGHT);
@@ -645,12 +710,12 @@ void Doom::Display()
             break;
         if (automapactive)
             AM_Drawer();
-        if (wipe || (viewheight != 200 && fullScreen))
+        if (wipe || (scaledviewheight != SCREENHEIGHT && fullScreen))
             redrawStatusBar = true;
         if (inHelpScreensState && !inhelpscreens)
             redrawStatusBar = true; // just put away the help screen
-        ST_Drawer(viewheight == 200, redrawStatusBar);
-        fullScreen = viewheight == 200;
+        ST_Drawer(scaledviewheight == SCREENHEIGHT, redrawStatusBar);
+        fullScreen = scaledviewheight == SCREENHEIGHT;
         break;
 
     case GameState::Intermission:
@@ -669,9 +734,26 @@ void Doom::Display()
     // draw buffered stuff to screen
     video->UpdateNoBlit();
 
-    // draw the view directly
+    // draw the view directly, or put up the one the render thread finished last
     if (gameState == GameState::Level && !automapactive && gametic)
-        R_RenderPlayerView(&players[displayplayer]);
+    {
+        auto start = bench::clock::now();
+        if (renderpipeline)
+            viewTic = R_PresentView();
+        else
+        {
+            if (isUncapped)
+                R_RenderInterpolatedView(&players[displayplayer], ticFrac);
+            else
+                R_RenderPlayerView(&players[displayplayer]);
+            viewTic = ticsDone;
+        }
+        CountMapFrame(start);
+    }
+    else if (gameState != GameState::Level)
+    {
+        ReportMapFrames();
+    }
 
     if (gameState == GameState::Level && gametic)
         HU_Drawer();
@@ -723,6 +805,7 @@ void Doom::Display()
     if (!wipe)
     {
         video->FinishUpdate(); // page flip or blit buffer
+        RecordPresent();
         return;
     }
 
@@ -751,6 +834,64 @@ void Doom::Display()
         video->FinishUpdate(); // page flip or blit buffer
     }
     while (!done);
+
+    RecordPresent();
+}
+
+// -uncapped keeps count of the views drawn on each map, and of the time the main thread spent
+// on them. Without -pipeline that's the renderer alone, so the second rate it reports is as fast
+// as the view could be drawn on the map.
+void Doom::CountMapFrame(bench::clock::time_point viewStart)
+{
+    if (!isUncapped)
+        return;
+
+    auto now = bench::clock::now();
+    if (mapFrames && mapStartTic != levelstarttic)
+        ReportMapFrames();
+
+    if (!mapFrames)
+    {
+        mapStart = now;
+        mapStartTic = levelstarttic;
+        mapName = gameMode == GameMode::Doom2Commercial ? std::format("MAP{:02d}", gamemap) : std::format("E{}M{}", gameepisode, gamemap);
+    }
+
+    ++mapFrames;
+    mapViewMs += std::chrono::duration<double, std::milli>(now - viewStart).count();
+}
+
+void Doom::ReportMapFrames()
+{
+    if (!mapFrames)
+        return;
+
+    auto seconds = std::chrono::duration<double>(bench::clock::now() - mapStart).count();
+    std::cout << std::format("{}: {} frames in {:.1f} s, {:.1f} fps", mapName, mapFrames, seconds, mapFrames / seconds);
+
+    // With -pipeline the main thread only puts up views, the render thread's time isn't here.
+    auto viewMs = mapViewMs / mapFrames;
+    if (!renderpipeline)
+        std::cout << std::format(", view {:.3f} ms, {:.1f} fps ceiling", viewMs, 1000.0 / viewMs);
+    std::cout << "\n";
+
+    mapFrames = 0;
+    mapViewMs = 0.0;
+}
+
+// The time between frames going out, and how old the game state the view shows was by then.
+void Doom::RecordPresent()
+{
+    auto now = bench::clock::now();
+    auto ms = [](auto duration){ return std::chrono::duration<double, std::milli>(duration).count(); };
+
+    if (lastPresent != bench::clock::time_point{})
+        bench::sample("frame_interval", ms(now - lastPresent));
+    lastPresent = now;
+
+    if (viewTic)
+        bench::sample("input_latency", ms(now - *viewTic));
+    viewTic.reset();
 }
 
 void Doom::PageDraw()
@@ -93,6 +93,9 @@ private:
 
     void Display();
     void PageDraw();
+    void RecordPresent();
+    void CountMapFrame(std::chrono::steady_clock::time_point viewStart);
+    void ReportMapFrames();
 
     Video* video = nullptr;
     bool viewActiveState = false;
@@ -120,4 +123,20 @@ private:
 
     // debug flag to cancel adaptiveness
     bool useSingleTicks = false;
+
+    // For the frame pacing and input latency series, when the last frame
+    // went out and when the tics the view on screen shows were done.
+    std::chrono::steady_clock::time_point ticsDone;
+    std::chrono::steady_clock::time_point lastPresent;
+    std::optional<std::chrono::steady_clock::time_point> viewTic;
+
+    // -uncapped: the view is drawn ticFrac (a fixed_t) of the way from the
+    // previous tic to the last, and the frame rate is reported per map.
+    bool isUncapped = false;
+    int32 ticFrac = 1 << 16;
+    std::chrono::steady_clock::time_point mapStart;
+    int32 mapStartTic = -1;
+    int32 mapFrames = 0;
+    double mapViewMs = 0.0;
+    string mapName;
 };
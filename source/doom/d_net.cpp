@@ -26,12 +26,16 @@
 #include "d_main.h"
 
 import std;
+import nstd;
+import config;
+import net;
 
 
 extern Doom* g_doom;
 
 
 void G_BuildTiccmd(ticcmd_t* cmd);
+extern short consistancy[MAXPLAYERS][BACKUPTICS];
 
 int32 Net::ticks[Net::MaxNodes] = {0};
 
@@ -43,6 +47,7 @@ int32 Net::ticks[Net::MaxNodes] = {0};
 
 doomcom_t* doomcom;
 doomdata_t* netbuffer;		// points inside doomcom
+net::transport* nettransport;
 
 // NETWORKING
 
@@ -77,46 +82,142 @@ doomdata_t	reboundstore;
 //
 //
 //
+intptr_t PacketSize(const doomdata_t& packet)
+{
+    return reinterpret_cast<intptr_t>(&static_cast<doomdata_t*>(nullptr)->cmds[packet.numtics]);
+}
+
 intptr_t NetbufferSize()
 {
-    return reinterpret_cast<intptr_t>(&static_cast<doomdata_t*>(nullptr)->cmds[netbuffer->numtics]);
-    //return (int)&(((doomdata_t*)0)->cmds[netbuffer->numtics]); 
+    return PacketSize(*netbuffer);
 }
 
 //
 // Checksum 
 //
-unsigned NetbufferChecksum()
+unsigned PacketChecksum(const doomdata_t& packet)
 {
     uint32_t c = 0x1234567;
 
-    auto l = (NetbufferSize() - reinterpret_cast<intptr_t>(&(((doomdata_t*)0)->retransmitfrom)) / 4);
+    auto l = (PacketSize(packet) - reinterpret_cast<intptr_t>(&(((doomdata_t*)0)->retransmitfrom))) / 4;
     for (int i = 0; i < l; i++)
-        c += ((unsigned*)&netbuffer->retransmitfrom)[i] * (i + 1);
+        c += ((const unsigned*)&packet.retransmitfrom)[i] * (i + 1);
 
     return c & NCMD_CHECKSUM;
 }
 
+unsigned NetbufferChecksum()
+{
+    return PacketChecksum(*netbuffer);
+}
+
 //
+// Packets go out in network byte order, written straight
+// into the next slot of the transport's send batch.
 //
+template<typename T>
+T NetOrder(T value)
+{
+    if constexpr (std::endian::native == std::endian::little)
+        return std::byteswap(value);
+    else
+        return value;
+}
+
+void WritePacket(const doomdata_t& packet, net::datagram& datagram)
+{
+    auto* sw = reinterpret_cast<doomdata_t*>(datagram.data.data());
+    sw->checksum = NetOrder(packet.checksum);
+    sw->player = packet.player;
+    sw->retransmitfrom = packet.retransmitfrom;
+    sw->starttic = packet.starttic;
+    sw->numtics = packet.numtics;
+    for (int32 c = 0; c < packet.numtics; ++c)
+    {
+        sw->cmds[c].forwardmove = packet.cmds[c].forwardmove;
+        sw->cmds[c].sidemove = packet.cmds[c].sidemove;
+        sw->cmds[c].angleturn = NetOrder(packet.cmds[c].angleturn);
+        sw->cmds[c].consistancy = NetOrder(packet.cmds[c].consistancy);
+        sw->cmds[c].chatchar = packet.cmds[c].chatchar;
+        sw->cmds[c].buttons = packet.cmds[c].buttons;
+    }
+    datagram.length = static_cast<int32>(PacketSize(packet));
+}
+
+// False for a datagram too short to hold a packet,
+// or with more tics than one can have.
+bool ReadPacket(const net::datagram& datagram, doomdata_t& packet)
+{
+    auto* sw = reinterpret_cast<const doomdata_t*>(datagram.data.data());
+    if (datagram.length < reinterpret_cast<intptr_t>(&static_cast<doomdata_t*>(nullptr)->cmds[0])
+        || sw->numtics > BACKUPTICS)
+        return false;
+
+    packet.checksum = NetOrder(sw->checksum);
+    packet.player = sw->player;
+    packet.retransmitfrom = sw->retransmitfrom;
+    packet.starttic = sw->starttic;
+    packet.numtics = sw->numtics;
+    for (int32 c = 0; c < packet.numtics; ++c)
+    {
+        packet.cmds[c].forwardmove = sw->cmds[c].forwardmove;
+        packet.cmds[c].sidemove = sw->cmds[c].sidemove;
+        packet.cmds[c].angleturn = NetOrder(sw->cmds[c].angleturn);
+        packet.cmds[c].consistancy = NetOrder(sw->cmds[c].consistancy);
+        packet.cmds[c].chatchar = sw->cmds[c].chatchar;
+        packet.cmds[c].buttons = sw->cmds[c].buttons;
+    }
+    return true;
+}
+
 //
-int ExpandTics(int low)
+// The bytes of a packet for the debugfile, formatted
+// into one line and written at once.
+//
+void DebugPacketBytes(const doomdata_t* packet, int32 length)
+{
+    static string line;
+    line.clear();
+
+    auto* bytes = reinterpret_cast<const byte*>(packet);
+    for (int32 i = 0; i < length; ++i)
+    {
+        char digits[4];
+        auto end = std::to_chars(digits, digits + 3, bytes[i]).ptr;
+        line.append(digits, end);
+        line += ' ';
+    }
+    line += '\n';
+
+    debugfile << line;
+}
+
+//
+// Tic numbers go out as their low byte, base is a
+// tic number near the one that was sent.
+//
+int ExpandTics(int low, int base)
 {
     int	delta;
 
-    delta = low - (maketic & 0xff);
+    delta = low - (base & 0xff);
 
     if (delta >= -64 && delta <= 64)
-        return (maketic & ~0xff) + low;
+        return (base & ~0xff) + low;
     if (delta > 64)
-        return (maketic & ~0xff) - 256 + low;
+        return (base & ~0xff) - 256 + low;
     if (delta < -64)
-        return (maketic & ~0xff) + 256 + low;
+        return (base & ~0xff) + 256 + low;
 
-    I_Error("ExpandTics: strange value {} at maketic {}", low, maketic);
+    I_Error("ExpandTics: strange value {} at tic {}", low, base);
     return 0;
 }
 
+int ExpandTics(int low)
+{
+    return ExpandTics(low, maketic);
+}
+
 
 
 //
@@ -139,7 +240,6 @@ void HSendPacket(int node, int	flags)
     if (!netgame)
         I_Error("Tried to transmit to another node");
 
-    doomcom->command = CMD_SEND;
     doomcom->remotenode = static_cast<short>(node);
     doomcom->datalength = static_cast<short>(NetbufferSize());
 
@@ -153,15 +253,21 @@ void HSendPacket(int node, int	flags)
             ExpandTics(netbuffer->starttic),
             netbuffer->numtics, realretrans, doomcom->datalength);
 
-        for (int32 i = 0; i < doomcom->datalength; ++i)
-            debugfile << std::format("{} ", ((byte*)netbuffer)[i]);
-
-        debugfile << "\n";
+        DebugPacketBytes(netbuffer, doomcom->datalength);
     }
 
-    I_NetCmd();
+    WritePacket(*netbuffer, nettransport->prepare(node));
+}
+
+// Sends the packets HSendPacket queued up.
+void HFlushPackets()
+{
+    if (nettransport)
+        nettransport->flush();
 }
 
+void D_RunDrones();
+
 // Returns false if no packet is waiting
 bool HGetPacket()
 {
@@ -179,13 +285,16 @@ bool HGetPacket()
     if (demoplayback)
         return false;
 
-    doomcom->command = CMD_GET;
-    I_NetCmd();
+    D_RunDrones();
 
-    if (doomcom->remotenode == -1)
+    auto* datagram = nettransport->receive();
+    if (!datagram)
         return false;
 
-    if (doomcom->datalength != NetbufferSize())
+    doomcom->remotenode = static_cast<short>(datagram->node);
+    doomcom->datalength = static_cast<short>(datagram->length);
+
+    if (!ReadPacket(*datagram, *netbuffer) || doomcom->datalength != NetbufferSize())
     {
         if (debugfile.is_open())
             debugfile << std::format("bad packet length {}\n", doomcom->datalength);
@@ -202,7 +311,6 @@ bool HGetPacket()
     if (debugfile.is_open())
     {
         int		realretrans;
-        int	i;
 
         if (netbuffer->checksum & NCMD_SETUP)
             debugfile << "setup packet\n";
@@ -218,9 +326,7 @@ bool HGetPacket()
                 ExpandTics(netbuffer->starttic),
                 netbuffer->numtics, realretrans, doomcom->datalength);
 
-            for (i = 0; i < doomcom->datalength; i++)
-                debugfile << std::format("{} ", ((byte*)netbuffer)[i]);
-            debugfile << "\n";
+            DebugPacketBytes(netbuffer, doomcom->datalength);
         }
     }
     return true;
@@ -369,7 +475,8 @@ void NetUpdate()
     for (int i = 0; i < doomcom->numnodes; i++)
         if (nodeingame[i])
         {
-            auto realstart = netbuffer->starttic = static_cast<byte>(resendto[i]);
+            auto realstart = resendto[i];
+            netbuffer->starttic = static_cast<byte>(realstart);
             netbuffer->numtics = static_cast<byte>(maketic - realstart);
             if (netbuffer->numtics > BACKUPTICS)
                 I_Error("NetUpdate: netbuffer->numtics > BACKUPTICS");
@@ -391,6 +498,7 @@ void NetUpdate()
                 HSendPacket(i, 0);
             }
         }
+    HFlushPackets();
 
     // listen for other packets
 listen:
@@ -461,6 +569,7 @@ void D_ArbitrateNetStart()
                 netbuffer->numtics = 0;
                 HSendPacket(i, NCMD_SETUP);
             }
+            HFlushPackets();
 
 #if 1
             for (i = 10; i && HGetPacket(); --i)
@@ -482,6 +591,166 @@ void D_ArbitrateNetStart()
     }
 }
 
+//
+// -netloopback <players> [latency ms] [loss %] [jitter ms]
+// A netgame against drones in this process, over a loopback
+// network that delays and drops packets as given, to play and
+// time netgames on one machine without sockets. The drones stand
+// still, but keep up their end of the protocol like another node
+// would: they answer the setup, make a ticcmd whenever a tic is
+// due, ask for the tics they missed and resend the ones asked for.
+//
+struct netdrone_t
+{
+    net::transport* transport;
+    int		player;
+    bool	started;
+    int		maketic;
+    int		nettic;		// tics in from the key player
+    bool	remoteresend;
+    int		resendto;
+    int		resendcount;
+    time_t	gametime;
+    ticcmd_t	cmds[BACKUPTICS];
+};
+
+std::unique_ptr<net::loopback> loopback;
+vector<netdrone_t> netdrones;
+
+// Node 1 is the key player as a drone sees it.
+#define DRONE_KEYNODE	1
+
+void D_InitLoopback()
+{
+    vector<string_view> settings;
+    if (!CommandLine::GetValueList("-netloopback", settings) || settings.empty())
+        return;
+
+    auto players = std::clamp(nstd::convert<int32>(settings[0]), 2, MAXPLAYERS);
+
+    net::link_conditions conditions;
+    if (settings.size() > 1)
+        conditions.latency = std::chrono::milliseconds{nstd::convert<int32>(settings[1])};
+    if (settings.size() > 2)
+        conditions.loss = std::clamp(nstd::convert<int32>(settings[2]), 0, 100);
+    if (settings.size() > 3)
+        conditions.jitter = std::chrono::milliseconds{nstd::convert<int32>(settings[3])};
+
+    std::cout << std::format("loopback netgame, {} players, {} ms latency, {}% loss\n",
+        players, conditions.latency.count() / 1000, conditions.loss);
+
+    loopback = std::make_unique<net::loopback>(players, conditions);
+    nettransport = &loopback->endpoint(0);
+
+    netgame = true;
+    doomcom->consoleplayer = 0;
+    doomcom->numnodes = doomcom->numplayers = static_cast<short>(players);
+
+    netdrones.clear();
+    for (int32 i = 1; i < players; ++i)
+        netdrones.push_back({.transport = &loopback->endpoint(i), .player = i});
+}
+
+void D_DroneGetPackets(netdrone_t& drone)
+{
+    doomdata_t packet;
+    while (auto* datagram = drone.transport->receive())
+    {
+        if (datagram->node != DRONE_KEYNODE
+            || !ReadPacket(*datagram, packet)
+            || datagram->length != PacketSize(packet)
+            || PacketChecksum(packet) != (packet.checksum & NCMD_CHECKSUM))
+            continue;
+
+        if (packet.checksum & NCMD_SETUP)
+        {
+            if (!drone.started)
+            {
+                drone.started = true;
+                drone.gametime = I_GetTime() / doomcom->ticdup;
+            }
+            continue;
+        }
+
+        if (!drone.started || (packet.checksum & (NCMD_EXIT | NCMD_KILL)))
+            continue;
+
+        if (drone.resendcount <= 0 && (packet.checksum & NCMD_RETRANSMIT))
+        {
+            drone.resendto = ExpandTics(packet.retransmitfrom, drone.maketic);
+            drone.resendcount = RESENDCOUNT;
+        }
+        else
+            drone.resendcount--;
+
+        auto realstart = ExpandTics(packet.starttic, drone.maketic);
+        auto realend = realstart + packet.numtics;
+        if (realend <= drone.nettic)
+            continue;
+
+        // wait for the key player to resend the missed tics
+        drone.remoteresend = realstart > drone.nettic;
+        if (!drone.remoteresend)
+            drone.nettic = realend;
+    }
+}
+
+void D_DroneUpdate(netdrone_t& drone)
+{
+    auto nowtime = I_GetTime() / doomcom->ticdup;
+    auto newtics = nowtime - drone.gametime;
+    if (newtics <= 0)
+        return;
+    drone.gametime = nowtime;
+
+    // The consistancy check is the one the key player keeps for the
+    // drone's player, it's the same on every node.
+    for (int i = 0; i < newtics; i++)
+    {
+        if (drone.maketic - gametic / doomcom->ticdup >= BACKUPTICS / 2 - 1)
+            break;
+
+        auto& cmd = drone.cmds[drone.maketic % BACKUPTICS];
+        cmd = {};
+        cmd.consistancy = consistancy[drone.player][drone.maketic % BACKUPTICS];
+        drone.maketic++;
+    }
+
+    doomdata_t packet;
+    packet.player = static_cast<byte>(drone.player);
+    packet.starttic = static_cast<byte>(drone.resendto);
+    packet.numtics = static_cast<byte>(drone.maketic - drone.resendto);
+    if (packet.numtics > BACKUPTICS)
+        I_Error("D_DroneUpdate: numtics > BACKUPTICS");
+
+    for (int j = 0; j < packet.numtics; j++)
+        packet.cmds[j] = drone.cmds[(drone.resendto + j) % BACKUPTICS];
+    drone.resendto = drone.maketic - doomcom->extratics;
+
+    unsigned flags = 0;
+    packet.retransmitfrom = 0;
+    if (drone.remoteresend)
+    {
+        packet.retransmitfrom = static_cast<byte>(drone.nettic);
+        flags = NCMD_RETRANSMIT;
+    }
+    packet.checksum = PacketChecksum(packet) | flags;
+
+    WritePacket(packet, drone.transport->prepare(DRONE_KEYNODE));
+    drone.transport->flush();
+}
+
+// Lets every drone take its packets and send its own.
+void D_RunDrones()
+{
+    for (auto& drone : netdrones)
+    {
+        D_DroneGetPackets(drone);
+        if (drone.started)
+            D_DroneUpdate(drone);
+    }
+}
+
 // Works out player numbers among the net participants
 void Net::CheckGame()
 {
@@ -493,8 +762,9 @@ void Net::CheckGame()
         resendto[i] = 0;		// which tic to start sending
     }
 
-    // I_InitNetwork sets doomcom and netgame
+    // I_InitNetwork sets doomcom, netgame and nettransport
     I_InitNetwork();
+    D_InitLoopback();
     if (doomcom->id != DOOMCOM_ID)
         I_Error("Doomcom buffer invalid!");
 
@@ -521,6 +791,20 @@ void Net::CheckGame()
     std::cout << std::format("player {} of {} ({} nodes)\n", consoleplayer + 1, doomcom->numplayers, doomcom->numnodes);
 }
 
+// Only for a game of one, a demo, the other nodes would have to seek too.
+void Net::ResetTics()
+{
+    maketic = gametic / ticdup;
+    for (int i = 0; i < doomcom->numnodes; i++)
+    {
+        Net::ticks[i] = maketic;
+        resendto[i] = maketic;
+    }
+
+    gametime = I_GetTime() / ticdup;
+    skiptics = 0;
+}
+
 // Called before quitting to leave a net game
 // without hanging the other players
 void D_QuitNetGame()
@@ -539,6 +823,7 @@ void D_QuitNetGame()
         for (int j = 1; j < doomcom->numnodes; j++)
             if (nodeingame[j])
                 HSendPacket(j, NCMD_EXIT);
+        HFlushPackets();
         I_WaitVBL(1);
     }
 }
@@ -553,6 +838,20 @@ int	oldnettics;
 
 extern	bool	advancedemo;
 
+bool TicsAvailable()
+{
+    NetUpdate();
+
+    auto lowtic = std::numeric_limits<time_t>::max();
+    for (int32 i = 0; i < doomcom->numnodes; i++)
+    {
+        if (nodeingame[i] && Net::ticks[i] < lowtic)
+            lowtic = Net::ticks[i];
+    }
+
+    return lowtic > gametic / ticdup;
+}
+
 void TryRunTics()
 {
     static time_t oldentertics = 0;
@@ -113,6 +113,10 @@ void D_QuitNetGame();
 //? how many ticks to run?
 void TryRunTics();
 
+// Whether every node's ticcmds for the next tic are in, so TryRunTics
+//  wouldn't have to wait for them (-uncapped draws instead).
+bool TicsAvailable();
+
 class Net
 {
 public:
@@ -120,4 +124,7 @@ public:
     static int32 ticks[Net::MaxNodes];
 
     static void CheckGame();
+
+    // Starts counting tics again from gametic, after a demo seek moved it.
+    static void ResetTics();
 };
@@ -70,6 +70,8 @@ struct player_t
     //  including viewpoint bobbing during movement.
     // Focal origin above r.z
     fixed_t		viewz;
+    // viewz before this tic, for -uncapped.
+    fixed_t		oldviewz;
     // Base height above floor for viewz.
     fixed_t		viewheight;
     // Bob/squat speed.
@@ -142,21 +144,6 @@ struct player_t
 
     // True if secret level has been done.
     bool		didsecret;
-
-    byte* GetSaveData() const
-    {
-        auto* out = new player_t;
-        //memcpy(out, this, sizeof(player_t));
-        std::copy(this, this + sizeof(player_t), out);
-
-        for (int32 n = 0; n < NUMSPRITES; ++n)
-        {
-            if (out->psprites[n].state)
-                *reinterpret_cast<intptr_t*>(out->psprites[n].state) = out->psprites[n].state - states;
-        }
-
-        return reinterpret_cast<byte*>(out);
-    }
 };
 
 // INTERMISSION
@@ -0,0 +1,229 @@
+export module bench;
+
+import std;
+import nstd;
+
+// Timing and counter collection for benchmark runs (-benchreport). Everything here is a no-op
+// until bench::enable() is called, so the hooks can stay in the hot paths permanently. The hooks
+// can be hit from the render thread too (-pipeline), so the collections are behind a mutex.
+export namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+// A named list of timing samples, in milliseconds.
+class series
+{
+public:
+    void add(double ms) { samples.push_back(ms); total += ms; }
+
+    int32 count() const { return samples.size(); }
+    double sum() const { return total; }
+    double avg() const { return samples.empty() ? 0.0 : total / samples.size(); }
+    double min() const { return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end()); }
+    double max() const { return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end()); }
+
+    // Nearest-rank percentile, p in [0, 100].
+    double percentile(double p) const
+    {
+        if (samples.empty())
+            return 0.0;
+
+        vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        auto rank = static_cast<int32>(std::ceil(p / 100.0 * sorted.size()));
+        return sorted[std::clamp(rank - 1, 0, sorted.size() - 1)];
+    }
+
+    const vector<double>& get_samples() const { return samples; }
+
+private:
+    vector<double> samples;
+    double total = 0.0;
+};
+
+namespace detail {
+
+inline bool enabled = false;
+inline filesys::path reportPath;
+inline std::map<string, series, std::less<>> allSeries;
+inline std::map<string, int64, std::less<>> peaks;
+inline std::map<string, int64, std::less<>> totals;
+inline std::mutex mutex;
+
+} // namespace detail
+
+inline bool is_enabled() { return detail::enabled; }
+
+inline void enable(const filesys::path& report)
+{
+    detail::enabled = true;
+    detail::reportPath = report;
+}
+
+// The caller has to hold detail::mutex.
+inline series& get(string_view name)
+{
+    auto it = detail::allSeries.find(name);
+    if (it == detail::allSeries.end())
+        it = detail::allSeries.emplace(string(name), series{}).first;
+    return it->second;
+}
+
+inline void sample(string_view name, double ms)
+{
+    if (!detail::enabled)
+        return;
+
+    std::scoped_lock lock{detail::mutex};
+    get(name).add(ms);
+}
+
+// The sum of the named series so far, 0 when there's none.
+inline double total(string_view name)
+{
+    std::scoped_lock lock{detail::mutex};
+    auto it = detail::allSeries.find(name);
+    return it == detail::allSeries.end() ? 0.0 : it->second.sum();
+}
+
+// Keeps the largest value ever reported for the counter, e.g. per-frame peak usage.
+inline void peak(string_view name, int64 value)
+{
+    if (!detail::enabled)
+        return;
+
+    std::scoped_lock lock{detail::mutex};
+    auto it = detail::peaks.find(name);
+    if (it == detail::peaks.end())
+        detail::peaks.emplace(string(name), value);
+    else
+        it->second = std::max(it->second, value);
+}
+
+// Accumulates the counter over the whole run.
+inline void count(string_view name, int64 value = 1)
+{
+    if (!detail::enabled)
+        return;
+
+    std::scoped_lock lock{detail::mutex};
+    auto it = detail::totals.find(name);
+    if (it == detail::totals.end())
+        detail::totals.emplace(string(name), value);
+    else
+        it->second += value;
+}
+
+// Adds the lifetime of the object to the named series.
+class scoped_sample
+{
+public:
+    scoped_sample(string_view name) : name{name}, start{detail::enabled ? clock::now() : clock::time_point{}} {}
+    ~scoped_sample()
+    {
+        if (detail::enabled)
+            sample(name, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+    }
+
+    scoped_sample(const scoped_sample&) = delete;
+    scoped_sample& operator=(const scoped_sample&) = delete;
+
+private:
+    string_view name;
+    clock::time_point start;
+};
+
+// Writes everything collected so far. A ".csv" report gets one row per frame plus a summary
+// section; anything else is written as JSON.
+inline bool write_report(uint32 checksum, int32 gametics)
+{
+    if (!detail::enabled)
+        return false;
+
+    std::scoped_lock lock{detail::mutex};
+    std::ofstream out(detail::reportPath, std::ios_base::out | std::ios_base::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "bench::write_report: can't open " << detail::reportPath << "\n";
+        return false;
+    }
+
+    auto& frames = get("frame");
+    auto to_fps = [](double ms){ return ms > 0.0 ? 1000.0 / ms : 0.0; };
+    auto minFps = to_fps(frames.max());
+    auto avgFps = to_fps(frames.avg());
+    auto p99Fps = to_fps(frames.percentile(99.0));
+
+    if (detail::reportPath.extension() == ".csv")
+    {
+        auto& render = get("render");
+        auto& tic = get("tic");
+        out << "frame,frame_ms,render_ms,tic_ms\n";
+        for (int32 n = 0; n < frames.count(); ++n)
+        {
+            out << std::format("{},{:.4f},{:.4f},{:.4f}\n", n,
+                frames.get_samples()[n],
+                n < render.count() ? render.get_samples()[n] : 0.0,
+                n < tic.count() ? tic.get_samples()[n] : 0.0);
+        }
+
+        out << "\nseries,count,min_ms,avg_ms,p99_ms,max_ms,total_ms\n";
+        for (auto& [name, s] : detail::allSeries)
+            out << std::format("{},{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f}\n", name, s.count(), s.min(), s.avg(), s.percentile(99.0), s.max(), s.sum());
+
+        out << "\ncounter,kind,value\n";
+        for (auto& [name, value] : detail::peaks)
+            out << std::format("{},peak,{}\n", name, value);
+        for (auto& [name, value] : detail::totals)
+            out << std::format("{},total,{}\n", name, value);
+
+        out << std::format("\ngametics,{}\nmin_fps,{:.2f}\navg_fps,{:.2f}\np99_fps,{:.2f}\nchecksum,{:#010x}\n",
+            gametics, minFps, avgFps, p99Fps, checksum);
+        return true;
+    }
+
+    out << "{\n";
+    out << std::format("  \"gametics\": {},\n", gametics);
+    out << std::format("  \"checksum\": \"{:#010x}\",\n", checksum);
+    out << std::format("  \"fps\": {{ \"min\": {:.2f}, \"avg\": {:.2f}, \"p99\": {:.2f} }},\n", minFps, avgFps, p99Fps);
+
+    out << "  \"series\": {";
+    auto first = true;
+    for (auto& [name, s] : detail::allSeries)
+    {
+        out << std::format("{}\n    \"{}\": {{ \"count\": {}, \"min_ms\": {:.4f}, \"avg_ms\": {:.4f}, \"p99_ms\": {:.4f}, \"max_ms\": {:.4f}, \"total_ms\": {:.4f} }}",
+            first ? "" : ",", name, s.count(), s.min(), s.avg(), s.percentile(99.0), s.max(), s.sum());
+        first = false;
+    }
+    out << "\n  },\n";
+
+    auto write_counters = [&out](string_view label, const auto& counters)
+    {
+        out << std::format("  \"{}\": {{", label);
+        auto first = true;
+        for (auto& [name, value] : counters)
+        {
+            out << std::format("{}\n    \"{}\": {}", first ? "" : ",", name, value);
+            first = false;
+        }
+        out << "\n  },\n";
+    };
+    write_counters("peaks", detail::peaks);
+    write_counters("totals", detail::totals);
+
+    auto write_samples = [&out](string_view label, const series& s, bool last)
+    {
+        out << std::format("  \"{}\": [", label);
+        for (int32 n = 0; n < s.count(); ++n)
+            out << std::format("{}{:.4f}", n ? ", " : "", s.get_samples()[n]);
+        out << (last ? "]\n" : "],\n");
+    };
+    write_samples("frame_ms", frames, false);
+    write_samples("render_ms", get("render"), false);
+    write_samples("tic_ms", get("tic"), true);
+
+    out << "}\n";
+    return true;
+}
+
+} // export namespace bench
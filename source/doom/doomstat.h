@@ -112,6 +112,7 @@ extern	int		viewwindowy;
 extern	int		viewheight;
 extern	int		viewwidth;
 extern	int		scaledviewwidth;
+extern	int		scaledviewheight;
 
 // This one is related to the 3-screen display mode.
 // ANG90 = left side, ANG270 = right
@@ -134,6 +135,10 @@ extern	int	totalsecret;
 extern  int	levelstarttic;	// gametic at level start
 extern  int	leveltime;	// tics in game play for par
 
+// -uncapped draws between the last two tics, so only then does
+//  P_Ticker keep where everything was before each one.
+extern  bool	interpolating;
+
 
 
 // --------------------------------------
@@ -195,6 +200,9 @@ extern  bool         precache;
 
 extern  int32             mouseSensitivity;
 
+#define	BODYQUESIZE	32
+
+extern  mobj_t*         bodyque[BODYQUESIZE];
 extern  int             bodyqueslot;
 
 // Needed to store the number of the dummy sky flat.
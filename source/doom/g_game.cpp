@@ -41,12 +41,14 @@
 #include "wi_stuff.h"
 #include "z_zone.h"
 #include "r_draw.h"
+#include "r_pipeline.h"
 
 import std;
 import config;
 import log;
 import input;
 import nstd;
+import bench;
 
 extern Doom* g_doom;
 
@@ -68,6 +70,9 @@ void	G_DoCompleted();
 void	G_DoVictory();
 void	G_DoWorldDone();
 
+static void G_DemoKeyframe();
+static bool G_DemoResponder(const input::event& event);
+
 
 gameaction_t    gameaction;
 skill_t         gameskill;
@@ -101,9 +106,6 @@ bool         demoplayback;
 bool		netdemo;
 const byte* demo_ibuffer;
 const byte* demo_g;
-byte* demo_obuffer;
-byte* demo_p;
-const byte* demoend;
 bool         singledemo;            	// quit after playing a demo from cmdline 
 
 bool         precache = true;        // if true, load all graphics at start 
@@ -161,8 +163,6 @@ int		savegameslot;
 string saveDescription(24, '\0');
 
 
-#define	BODYQUESIZE	32
-
 mobj_t* bodyque[BODYQUESIZE];
 int		bodyqueslot;
 
@@ -375,6 +375,9 @@ extern  GameState wipegamestate;
 
 void G_DoLoadLevel()
 {
+    // The render thread reads the old level until it's paused.
+    R_PausePipeline(true);
+
     // Set the sky map.
     // First thing, we have a dummy sky texture name,
     //  a flat. The data is in the WAD only because
@@ -409,6 +412,7 @@ void G_DoLoadLevel()
     }
 
     P_SetupLevel(gameepisode, gamemap, 0, gameskill);
+    R_ResumePipeline();
     displayplayer = consoleplayer;		// view the guy you are playing    
     starttime = I_GetTime();
     gameaction = ga_nothing;
@@ -440,6 +444,10 @@ bool G_Responder(const input::event& event)
         return true;
     }
 
+    // seeking about a demo played from the command line
+    if (demoplayback && singledemo && event.is_keyboard() && event.down() && G_DemoResponder(event))
+        return true;
+
     // any other key pops up menu if in demos
     if (gameaction == ga_nothing && !singledemo &&
         (demoplayback || g_doom->GetGameState() == GameState::Demo)
@@ -513,6 +521,8 @@ bool G_Responder(const input::event& event)
 // Make ticcmd_ts for the players.
 void Game::Ticker()
 {
+    bench::scoped_sample ticSample("tic");
+
     // do player reborns if needed
     for (int32 i = 0; i < MAXPLAYERS; ++i)
         if (playeringame[i] && players[i].playerstate == PST_REBORN)
@@ -556,6 +566,9 @@ void Game::Ticker()
         }
     }
 
+    if (demoplayback)
+        G_DemoKeyframe();
+
     // get commands, check consistancy,
     // and build new consistancy check
     int32 buf = (gametic / ticdup) % BACKUPTICS;
@@ -777,46 +790,58 @@ void G_DeathMatchSpawnPlayer(int playernum)
     P_SpawnPlayer(&playerstarts[playernum]);
 }
 
-void G_DoReborn(int playernum)
+// Puts the player at a start, in a netgame.
+static void G_RespawnPlayer(int playernum)
 {
-    if (!netgame)
+    // respawn at the start
+
+    // first dissasociate the corpse 
+    players[playernum].mo->player = nullptr;
+
+    // spawn at random spot if in death match 
+    if (deathmatch)
     {
-        // reload the level from scratch
-        gameaction = ga_loadlevel;
+        G_DeathMatchSpawnPlayer(playernum);
+        return;
     }
-    else
-    {
-        // respawn at the start
 
-        // first dissasociate the corpse 
-        players[playernum].mo->player = nullptr;
+    if (G_CheckSpot(playernum, &playerstarts[playernum]))
+    {
+        P_SpawnPlayer(&playerstarts[playernum]);
+        return;
+    }
 
-        // spawn at random spot if in death match 
-        if (deathmatch)
+    // try to spawn at one of the other players spots 
+    for (int32 i = 0; i < MAXPLAYERS; ++i)
+    {
+        if (G_CheckSpot(playernum, &playerstarts[i]))
         {
-            G_DeathMatchSpawnPlayer(playernum);
+            playerstarts[i].type = static_cast<short>(playernum + 1);	// fake as other player 
+            P_SpawnPlayer(&playerstarts[i]);
+            playerstarts[i].type = static_cast<short>(i + 1);		// restore 
             return;
         }
+        // he's going to be inside something.  Too bad.
+    }
+    P_SpawnPlayer(&playerstarts[playernum]);
+}
 
-        if (G_CheckSpot(playernum, &playerstarts[playernum]))
-        {
-            P_SpawnPlayer(&playerstarts[playernum]);
-            return;
-        }
+void G_DoReborn(int playernum)
+{
+    if (!netgame)
+    {
+        // reload the level from scratch
+        gameaction = ga_loadlevel;
+    }
+    else
+    {
+        G_RespawnPlayer(playernum);
 
-        // try to spawn at one of the other players spots 
-        for (int32 i = 0; i < MAXPLAYERS; ++i)
-        {
-            if (G_CheckSpot(playernum, &playerstarts[i]))
-            {
-                playerstarts[i].type = static_cast<short>(playernum + 1);	// fake as other player 
-                P_SpawnPlayer(&playerstarts[i]);
-                playerstarts[i].type = static_cast<short>(i + 1);		// restore 
-                return;
-            }
-            // he's going to be inside something.  Too bad.
-        }
-        P_SpawnPlayer(&playerstarts[playernum]);
+        // The view starts over at the new body, -uncapped doesn't
+        //  draw it rising from the corpse.
+        auto* player = &players[playernum];
+        player->viewz = player->mo->z + player->viewheight;
+        player->oldviewz = player->viewz;
     }
 }
 
@@ -1021,53 +1046,29 @@ void Game::DoLoadGame()
 {
     gameaction = ga_nothing;
 
-    auto inFile = std::ifstream{loadFileName, std::ifstream::binary};
+    auto inFile = std::ifstream{loadFileName, std::ifstream::binary | std::ifstream::ate};
     if (!inFile.is_open())
     {
         logger::write(logger::Verbosity::Error, "Failed to open load file: ", loadFileName);
         return;
     }
 
-    // skip the description field
-    inFile.seekg(SaveStringSize, std::ios_base::beg);
-
-    string versionCheck(VersionSize, '\0');
-    inFile.read(versionCheck.data(), VersionSize);
-    if (versionCheck != std::format("version {}", Doom::Version))
+    // The whole file in one read, the description and then the snapshot.
+    static vector<byte> buffer;
+    buffer.resize(static_cast<size_t>(inFile.tellg()));
+    inFile.seekg(0);
+    inFile.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    if (!inFile || buffer.size() < SaveStringSize)
+    {
+        logger::write(logger::Verbosity::Error, "Failed to read load file: ", loadFileName);
         return;
+    }
 
-    auto read_byte = [&inFile](auto* val){
-        using T = nstd::int_rep<nstd::rm_ptr<decltype(val)>>;
-        *reinterpret_cast<T*>(val) = nstd::zero<T>;
-        inFile.read(reinterpret_cast<char*>(val), 1);
-    };
-
-    read_byte(&gameskill);
-    read_byte(&gameepisode);
-    read_byte(&gamemap);
-
-    for (int32 i = 0; i < MAXPLAYERS; ++i)
-        read_byte(playeringame + i);
-
-    // load a base level 
-    G_InitNew(gameskill, gameepisode, gamemap);
-
-    // get the times
-    leveltime = 0;
-    inFile.read(reinterpret_cast<char*>(&leveltime) + 2, 1);
-    inFile.read(reinterpret_cast<char*>(&leveltime) + 1, 1);
-    inFile.read(reinterpret_cast<char*>(&leveltime) + 0, 1);
-
-    // dearchive all the modifications
-    P_UnArchivePlayers(inFile);
-    P_UnArchiveWorld(inFile);
-    P_UnArchiveThinkers(inFile);
-    P_UnArchiveSpecials(inFile);
-
-    SaveFileMarker check;
-    read_byte(&check);
-    if (check != SaveFileMarker::End)
-        I_Error("Bad savegame");
+    if (!G_LoadSnapshot(std::span{buffer}.subspan(SaveStringSize)))
+    {
+        logger::write(logger::Verbosity::Error, "Load file is not a valid savegame: ", loadFileName);
+        return;
+    }
 
     g_doom->GetRender()->CheckSetViewSize();
 
@@ -1094,27 +1095,13 @@ void Game::DoSaveGame()
         return;
     }
 
-    outFile << std::setfill('\0')
-        << std::setw(SaveStringSize) << saveDescription
-        << std::setw(VersionSize) << std::format("version {}", Doom::Version)
-
-        << static_cast<byte>(gameskill)
-        <<static_cast<byte>(gameepisode)
-        << static_cast<byte>(gamemap);
-
-    for (int32 i = 0; i < MAXPLAYERS; ++i)
-        outFile << playeringame[i];
-
-    outFile << static_cast<byte>(leveltime >> 16)
-        << static_cast<byte>(leveltime >> 8)
-        << static_cast<byte>(leveltime);
-
-    P_ArchivePlayers(outFile);
-    P_ArchiveWorld(outFile);
-    P_ArchiveThinkers(outFile);
-    P_ArchiveSpecials(outFile);
-
-    outFile << static_cast<uint8>(SaveFileMarker::End);
+    // The description and the snapshot go in one buffer, kept for the
+    // next save, and out in one write.
+    static vector<byte> buffer;
+    buffer.assign(SaveStringSize, 0);
+    std::copy_n(saveDescription.begin(), std::min<size_t>(saveDescription.size(), SaveStringSize), reinterpret_cast<char*>(buffer.data()));
+    G_SaveSnapshot(buffer);
+    outFile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
 
     gameaction = ga_nothing;
     saveDescription = "";
@@ -1125,6 +1112,46 @@ void Game::DoSaveGame()
     R_FillBackScreen();
 }
 
+//
+// G_SaveSnapshot
+//
+void G_SaveSnapshot(vector<byte>& buffer)
+{
+    P_SaveSnapshot(buffer);
+}
+
+//
+// G_LoadSnapshot
+//
+bool G_LoadSnapshot(std::span<const byte> snapshot)
+{
+    auto info = P_SnapshotInfo(snapshot);
+    if (!info)
+        return false;
+
+    auto samelevel = g_doom->GetGameState() == GameState::Level
+        && gameskill == info->skill && gameepisode == info->episode && gamemap == info->map
+        && std::equal(playeringame, playeringame + MAXPLAYERS, info->playeringame);
+
+    if (samelevel)
+    {
+        // The render thread's views are of things that are gone.
+        R_PausePipeline(true);
+        S_StopSounds();
+        P_LoadSnapshot(snapshot);
+        R_ResumePipeline();
+    }
+    else
+    {
+        std::copy_n(info->playeringame, MAXPLAYERS, playeringame);
+        G_InitNew(info->skill, info->episode, info->map);
+        P_LoadSnapshot(snapshot);
+    }
+
+    P_ResetInterpolation();
+    return true;
+}
+
 // Can be called by the startup code or the menu task,
 // consoleplayer, displayplayer, playeringame[] should be set. 
 skill_t	d_skill;
@@ -1212,7 +1239,12 @@ void G_InitNew(skill_t skill, int32 episode, int32 map)
     else
         respawnmonsters = false;
 
-    if (fastparm || (skill == sk_nightmare && gameskill != sk_nightmare))
+    // Fast monsters are switched on and off rather than on every new
+    // game, which would make them faster each time a demo seek goes
+    // back to an earlier level of a -fast demo.
+    static bool fastmonsters = false;
+    auto fast = fastparm || skill == sk_nightmare;
+    if (fast && !fastmonsters)
     {
         for (i = S_SARG_RUN1; i <= S_SARG_PAIN2; i++)
             states[i].tics >>= 1;
@@ -1220,7 +1252,7 @@ void G_InitNew(skill_t skill, int32 episode, int32 map)
         mobjinfo[MT_HEADSHOT].speed = 20 * FRACUNIT;
         mobjinfo[MT_TROOPSHOT].speed = 20 * FRACUNIT;
     }
-    else if (skill != sk_nightmare && gameskill == sk_nightmare)
+    else if (!fast && fastmonsters)
     {
         for (i = S_SARG_RUN1; i <= S_SARG_PAIN2; i++)
             states[i].tics <<= 1;
@@ -1228,6 +1260,7 @@ void G_InitNew(skill_t skill, int32 episode, int32 map)
         mobjinfo[MT_HEADSHOT].speed = 10 * FRACUNIT;
         mobjinfo[MT_TROOPSHOT].speed = 10 * FRACUNIT;
     }
+    fastmonsters = fast;
 
 
     // force players to be initialized upon first level load         
@@ -1279,6 +1312,10 @@ void G_InitNew(skill_t skill, int32 episode, int32 map)
 
 #define DEMOMARKER		0x80
 
+// version, skill, episode, map, deathmatch, respawn, fast, nomonsters,
+// consoleplayer and playeringame, before the ticcmds
+constexpr int32 DEMOHEADERSIZE = 9 + MAXPLAYERS;
+
 
 void G_ReadDemoTiccmd(ticcmd_t* cmd)
 {
@@ -1295,23 +1332,111 @@ void G_ReadDemoTiccmd(ticcmd_t* cmd)
 }
 
 
+// The ticcmds are written out as the demo is recorded, DEMOCHUNKTICS
+// tics at a time by a thread of its own, so recording takes the same
+// memory however long it goes on and there's next to nothing left to
+// write when it ends. Each chunk goes over the marker that ended the
+// one before and brings its own, so whatever happens to the game the
+// file is a whole demo of everything up to the last chunk written.
+
+constexpr int32 DEMOCHUNKTICS = 4 * TICRATE;
+constexpr int32 DEMOCHUNKS = 4;             // the one being filled and the ones being written
+
+static std::ofstream demofile;
+static int32 demochunksize;                 // bytes of whole tics
+static vector<byte> demochunk;              // being filled
+static std::deque<vector<byte>> demoqueue;  // to be written
+static vector<vector<byte>> demospare;      // written, to be filled again
+static bool democlosing;
+static std::mutex demomutex;
+static std::condition_variable_any demowake; // for the writer, a chunk or the end
+static std::condition_variable demowritten; // for the recorder, a spare chunk
+static std::jthread demowriter;
+
+// Stopped by G_EndRecording, or by the thread's stop token if the
+// game goes without ending the recording, when what's queued is out.
+static void G_DemoWriter(std::stop_token stop)
+{
+    std::unique_lock lock{demomutex};
+    for (;;)
+    {
+        demowake.wait(lock, stop, []{ return !demoqueue.empty() || democlosing; });
+        if (demoqueue.empty())
+            return;
+
+        auto chunk = std::move(demoqueue.front());
+        demoqueue.pop_front();
+        lock.unlock();
+
+        chunk.push_back(DEMOMARKER);
+        demofile.seekp(-1, std::ios_base::end);
+        demofile.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+        demofile.flush();
+        chunk.clear();
+
+        lock.lock();
+        demospare.push_back(std::move(chunk));
+        demowritten.notify_one();
+    }
+}
+
+// Only waits if the disk is that far behind.
+static void G_QueueDemoChunk()
+{
+    {
+        std::unique_lock lock{demomutex};
+        demowritten.wait(lock, []{ return !demospare.empty(); });
+        demoqueue.push_back(std::move(demochunk));
+        demochunk = std::move(demospare.back());
+        demospare.pop_back();
+    }
+    demowake.notify_one();
+}
+
+void G_EndRecording()
+{
+    if (!demowriter.joinable())
+    {
+        demofile.close();
+        g_doom->SetDemoRecording(false);
+        return;
+    }
+
+    if (!demochunk.empty())
+        G_QueueDemoChunk();
+
+    {
+        std::scoped_lock lock{demomutex};
+        democlosing = true;
+    }
+    demowake.notify_one();
+    demowriter.join();
+    demofile.close();
+    g_doom->SetDemoRecording(false);
+}
+
 void G_WriteDemoTiccmd(ticcmd_t* cmd)
 {
     if (gamekeydown['q'])           // press q to end demo recording 
         G_CheckDemoStatus(g_doom);
-    *demo_p++ = cmd->forwardmove;
-    *demo_p++ = cmd->sidemove;
-    *demo_p++ = (cmd->angleturn + 128) >> 8;
-    *demo_p++ = cmd->buttons;
-    demo_p -= 4;
-    if (demo_p > demoend - 16)
-    {
-        // no more space 
-        G_CheckDemoStatus(g_doom);
-        return;
-    }
 
-    G_ReadDemoTiccmd(cmd);         // make SURE it is exactly the same 
+    byte bytes[] = {
+        static_cast<byte>(cmd->forwardmove),
+        static_cast<byte>(cmd->sidemove),
+        static_cast<byte>((cmd->angleturn + 128) >> 8),
+        static_cast<byte>(cmd->buttons),
+    };
+    demochunk.insert(demochunk.end(), std::begin(bytes), std::end(bytes));
+
+    // The last player's ticcmd ends a tic.
+    if (demochunk.size() >= demochunksize)
+        G_QueueDemoChunk();
+
+    // make SURE it is exactly the same 
+    cmd->forwardmove = static_cast<signed char>(bytes[0]);
+    cmd->sidemove = static_cast<signed char>(bytes[1]);
+    cmd->angleturn = bytes[2] << 8;
+    cmd->buttons = bytes[3];
 }
 
 void G_RecordDemo(Doom* doom, string_view name)
@@ -1319,20 +1444,21 @@ void G_RecordDemo(Doom* doom, string_view name)
     usergame = false;
     demoname = name;
     demoname += ".lmp";
-    int maxsize = 0x20000;
-
-    if (CommandLine::TryGetValues("-maxdemo", maxsize))
-        maxsize *= 1024;
 
-    demo_obuffer = static_cast<byte*>(Z_Malloc(maxsize, PU_STATIC, nullptr));
-    demoend = demo_obuffer + maxsize;
+    demofile.open(demoname, std::ios_base::binary);
+    if (!demofile.is_open())
+    {
+        I_Error("Couldn't open {} to record to", demoname);
+        return;
+    }
 
     doom->SetDemoRecording(true);
 }
 
 void G_BeginRecording()
 {
-    demo_p = demo_obuffer;
+    byte header[DEMOHEADERSIZE + 1];
+    auto* demo_p = header;
 
     *demo_p++ = Doom::Version;
     *demo_p++ = static_cast<byte>(gameskill);
@@ -1346,6 +1472,331 @@ void G_BeginRecording()
 
     for (int i = 0; i < MAXPLAYERS; i++)
         *demo_p++ = playeringame[i];
+
+    // An empty demo until the first chunk is written.
+    *demo_p++ = DEMOMARKER;
+    demofile.write(reinterpret_cast<const char*>(header), sizeof(header));
+    demofile.flush();
+
+    // Room for the marker too, so a chunk is never grown.
+    auto players = static_cast<int32>(std::count(playeringame, playeringame + MAXPLAYERS, true));
+    demochunksize = DEMOCHUNKTICS * 4 * players;
+    demochunk.reserve(demochunksize + 1);
+    demospare.resize(DEMOCHUNKS - 1);
+    for (auto& chunk : demospare)
+        chunk.reserve(demochunksize + 1);
+
+    democlosing = false;
+    demowriter = std::jthread(G_DemoWriter);
+}
+
+// DEMO SEEKING
+//
+// A demo played from the command line keeps keyframes, snapshots of
+// the game every so many tics of it, taken as it plays. Seeking loads
+// the last keyframe at or before the tic asked for and plays the demo
+// on from there without drawing, so going anywhere costs a snapshot
+// load and at most an interval of tics, backwards included. With
+// -demoindex the keyframes are written next to the demo when it ends
+// and read back the next time it's played, so seeking ahead doesn't
+// have to play all the way there first. A long demo keeps no more than
+// MAXDEMOKEYFRAMES, further apart.
+
+struct demokeyframe_t
+{
+    int32 tic;          // ticcmds of the demo played
+    int32 gametic;      // A_Tracer goes by gametic
+    vector<byte> snapshot;
+};
+
+static bool demokeyframing;         // keeping keyframes for this demo
+static bool demoindexing;           // write them out when it ends
+static int32 demokeyinterval = 10 * TICRATE;
+static vector<demokeyframe_t> demokeyframes;
+static string demoindexname;
+static std::span<const byte> demolump;
+static int32 demoticsize;           // bytes of ticcmds per tic
+static int32 demotics;              // tics in the demo
+static int32 demoseektic = -1;      // seek there between frames
+static bool demopaused;
+
+constexpr int32 MAXDEMOKEYFRAMES = 64;
+constexpr uint32 DEMOINDEXVERSION = 1;
+
+struct demoindexheader_t
+{
+    char magic[4];
+    uint32 version;
+    uint32 demosize;
+    uint32 demohash;
+    int32 interval;
+    int32 keyframes;
+};
+
+struct demoindexentry_t
+{
+    int32 tic;
+    int32 gametic;
+    uint32 size;
+};
+
+// Tics of the demo played. Only between tics, mid tic some of the
+// players' ticcmds have been read.
+static int32 G_DemoTic()
+{
+    return static_cast<int32>(demo_g - demo_ibuffer - DEMOHEADERSIZE) / demoticsize;
+}
+
+// So an index is only read back for the demo it was made from.
+static uint32 G_DemoHash(std::span<const byte> demo)
+{
+    uint32 hash = 2166136261u;
+    for (auto b : demo)
+        hash = (hash ^ b) * 16777619u;
+    return hash;
+}
+
+static void G_ReadDemoIndex()
+{
+    auto file = M_ReadFile(demoindexname);
+    if (file.empty())
+        return;
+
+    size_t offset = 0;
+    auto read = [&](void* value, size_t size)
+    {
+        if (file.size() - offset < size)
+            return false;
+        memcpy(value, file.data() + offset, size);
+        offset += size;
+        return true;
+    };
+
+    demoindexheader_t header;
+    if (!read(&header, sizeof(header)) || memcmp(header.magic, "DIDX", 4) != 0 || header.version != DEMOINDEXVERSION
+        || header.demosize != demolump.size() || header.demohash != G_DemoHash(demolump) || header.interval <= 0)
+    {
+        std::cerr << std::format("{} is not an index of this demo\n", demoindexname);
+        return;
+    }
+
+    // A keyframe that doesn't load ends the index there, the demo
+    // plays on to the rest.
+    vector<demokeyframe_t> keyframes;
+    for (int32 i = 0; i < std::min(header.keyframes, MAXDEMOKEYFRAMES); ++i)
+    {
+        demoindexentry_t entry;
+        if (!read(&entry, sizeof(entry)) || file.size() - offset < entry.size
+            || (!keyframes.empty() && entry.tic <= keyframes.back().tic))
+            break;
+
+        auto& keyframe = keyframes.emplace_back(entry.tic, entry.gametic);
+        keyframe.snapshot.resize(entry.size);
+        read(keyframe.snapshot.data(), entry.size);
+        if (!P_SnapshotInfo(keyframe.snapshot))
+        {
+            keyframes.pop_back();
+            break;
+        }
+    }
+
+    demokeyinterval = header.interval;
+    demokeyframes = std::move(keyframes);
+    std::cout << std::format("{}: {} keyframes every {} tics\n", demoindexname, demokeyframes.size(), demokeyinterval);
+}
+
+static void G_WriteDemoIndex()
+{
+    demoindexheader_t header{{'D', 'I', 'D', 'X'}, DEMOINDEXVERSION, static_cast<uint32>(demolump.size()),
+        G_DemoHash(demolump), demokeyinterval, demokeyframes.size()};
+
+    vector<byte> file;
+    auto write = [&file](const void* value, size_t size)
+    {
+        auto* bytes = static_cast<const byte*>(value);
+        file.insert(file.end(), bytes, bytes + size);
+    };
+
+    write(&header, sizeof(header));
+    for (auto& keyframe : demokeyframes)
+    {
+        demoindexentry_t entry{keyframe.tic, keyframe.gametic, static_cast<uint32>(keyframe.snapshot.size())};
+        write(&entry, sizeof(entry));
+        write(keyframe.snapshot.data(), keyframe.snapshot.size());
+    }
+
+    if (M_WriteFile(demoindexname, reinterpret_cast<const char*>(file.data()), static_cast<uint32>(file.size())))
+        std::cout << std::format("{}: {} keyframes every {} tics, {} KB\n", demoindexname, demokeyframes.size(), demokeyinterval, file.size() / 1024);
+}
+
+// Called by G_DoPlayDemo once the header has been read.
+static void G_StartDemoSeeking(string_view name, const LumpInfo& lump)
+{
+    // A seek asked for before the demo started (-demoseek) is left to
+    // be done once it has.
+    demokeyframes.clear();
+    demopaused = false;
+
+    // The title screen's demos loop forever, only a demo played from
+    // the command line keeps keyframes.
+    demokeyframing = singledemo || demoindexing;
+    if (!demokeyframing)
+        return;
+
+    demolump = {lump.as<byte>(), static_cast<size_t>(lump.size)};
+    demoticsize = 4 * static_cast<int32>(std::count(playeringame, playeringame + MAXPLAYERS, true));
+
+    // The reader stops at the first ticcmd starting with the marker.
+    demotics = 0;
+    for (auto offset = DEMOHEADERSIZE; offset < lump.size && demolump[offset] != DEMOMARKER; offset += demoticsize)
+        ++demotics;
+
+    demoindexname = std::format("{}.idx", name);
+    if (!demoindexing)
+        G_ReadDemoIndex();
+}
+
+// Called by Game::Ticker between reading the game actions and the
+// ticcmds, which is where a keyframe is loaded back to.
+static void G_DemoKeyframe()
+{
+    if (!demokeyframing || g_doom->GetGameState() != GameState::Level)
+        return;
+
+    // Intermissions push a keyframe on to the next level.
+    auto tic = G_DemoTic();
+    if (!demokeyframes.empty() && tic < demokeyframes.back().tic + demokeyinterval)
+        return;
+
+    // When there are too many, every other one goes and the interval
+    // doubles, so the ones kept stay evenly spread over the demo.
+    if (demokeyframes.size() == MAXDEMOKEYFRAMES)
+    {
+        for (int32 i = 1; i < MAXDEMOKEYFRAMES / 2; ++i)
+            demokeyframes[i] = std::move(demokeyframes[2 * i]);
+        demokeyframes.resize(MAXDEMOKEYFRAMES / 2);
+        demokeyinterval *= 2;
+    }
+
+    auto& keyframe = demokeyframes.emplace_back(tic, gametic);
+    G_SaveSnapshot(keyframe.snapshot);
+}
+
+void G_DemoIndex(int32 interval)
+{
+    demoindexing = true;
+    demokeyinterval = std::max(interval, 1);
+}
+
+void G_DemoSeek(int32 tic)
+{
+    demoseektic = std::max(tic, 0);
+}
+
+bool G_DemoSeekPending()
+{
+    return demoseektic >= 0 && demoplayback && demokeyframing;
+}
+
+bool G_DemoPaused()
+{
+    return demopaused && demoplayback;
+}
+
+void G_DoDemoSeek()
+{
+    auto start = bench::clock::now();
+    auto from = G_DemoTic();
+    auto target = std::min(demoseektic, demotics);
+    demoseektic = -1;
+
+    // Back to the last keyframe before the tic, unless it's closer to
+    // play on from where the demo is.
+    auto keyframe = std::upper_bound(demokeyframes.begin(), demokeyframes.end(), target,
+        [](int32 tic, auto& keyframe){ return tic < keyframe.tic; });
+    auto loaded = -1;
+    if (keyframe != demokeyframes.begin() && (target < from || std::prev(keyframe)->tic > from))
+    {
+        --keyframe;
+
+        // A keyframe on another level starts it over, which ends the
+        // demo as far as the game is concerned.
+        precache = false;
+        G_LoadSnapshot(keyframe->snapshot);
+        precache = true;
+        usergame = false;
+        demoplayback = true;
+
+        demo_g = demo_ibuffer + DEMOHEADERSIZE + keyframe->tic * demoticsize;
+        gametic = keyframe->gametic;
+        gameaction = ga_nothing;
+        loaded = keyframe->tic;
+    }
+
+    // Play the rest of the way without drawing, like -timedemo.
+    auto played = 0;
+    for (; G_DemoTic() < target && demoplayback; ++played)
+    {
+        g_doom->GetGame()->Ticker();
+        gametic++;
+    }
+
+    // Nothing of what was played should be heard, and real time picks
+    // up from here rather than trying to catch up with the seek.
+    S_StopSounds();
+    P_ResetInterpolation();
+    Net::ResetTics();
+    if (loaded < 0 && played == 0)
+        return;
+
+    auto ms = std::chrono::duration<double, std::milli>(bench::clock::now() - start).count();
+    bench::sample("demoseek", ms);
+    if (loaded >= 0)
+        std::cout << std::format("demo: tic {} to {} from the keyframe at {}, {} tics played in {:.2f} ms\n", from, target, loaded, played, ms);
+    else
+        std::cout << std::format("demo: tic {} to {}, {} tics played in {:.2f} ms\n", from, target, played, ms);
+
+    players[consoleplayer].message = std::format("TIC {} OF {}", target, demotics);
+}
+
+// PageUp and PageDown go back and ahead ten seconds, Home to the
+// start, Pause holds the demo where it is and Comma and Period step
+// it a tic back or ahead.
+static bool G_DemoResponder(const input::event& event)
+{
+    auto tic = G_DemoTic();
+    if (event.down("Pause"))
+    {
+        demopaused = !demopaused;
+        if (demopaused)
+        {
+            S_PauseSound();
+        }
+        else
+        {
+            S_ResumeSound();
+            G_DemoSeek(tic); // for the real time that went by
+        }
+    }
+    else if (event.down("PageUp"))
+        G_DemoSeek(tic - 10 * TICRATE);
+    else if (event.down("PageDown"))
+        G_DemoSeek(tic + 10 * TICRATE);
+    else if (event.down("Home"))
+        G_DemoSeek(0);
+    else if (event.down("Comma") || event.down("Period"))
+    {
+        if (!demopaused)
+        {
+            demopaused = true;
+            S_PauseSound();
+        }
+        G_DemoSeek(event.down("Comma") ? tic - 1 : tic + 1);
+    }
+    else
+        return false;
+
+    return true;
 }
 
 // G_PlayDemo 
@@ -1364,7 +1815,8 @@ void G_DoPlayDemo()
     int             i, episode, map;
 
     gameaction = ga_nothing;
-    demo_ibuffer = demo_g = WadManager::GetLumpData<byte>(defdemoname.to_upper());
+    auto& lump = WadManager::GetLump(defdemoname.to_upper());
+    demo_ibuffer = demo_g = lump.as<byte>();
     if (*demo_g++ != Doom::Version)
     {
         std::cerr << "Demo is from a different game version!\n";
@@ -1389,6 +1841,8 @@ void G_DoPlayDemo()
         netdemo = true;
     }
 
+    G_StartDemoSeeking(defdemoname, lump);
+
     // don't spend a lot of time in loadlevel 
     precache = false;
     G_InitNew(skill, episode, map);
@@ -1407,6 +1861,125 @@ void G_TimeDemo(const char* name)
     gameaction = ga_playdemo;
 }
 
+//
+// G_SlaughterBench
+// Packs the current level with monsters that are all after the
+// player and runs the playsim flat out, no drawing and no input,
+// then prints tics per second and the final checksum. The player is
+// in god mode so the fight lasts the whole run. With view the
+// player's view is drawn after every tic too, timed apart from the
+// tics, and the time spent in R_DrawMasked on the sprites is printed.
+// Last it times a snapshot saved and loaded back, and checks that the
+// game plays on the same from it.
+//
+void G_SlaughterBench(int32 monsters, int32 tics, bool view)
+{
+    static constexpr mobjtype_t types[] = { MT_POSSESSED, MT_SHOTGUY, MT_TROOP, MT_SERGEANT };
+    constexpr fixed_t spacing = 48 * FRACUNIT;
+
+    auto* player = players[consoleplayer].mo;
+    players[consoleplayer].cheats |= CF_GODMODE;
+
+    auto left = vertexes[0].x, right = vertexes[0].x;
+    auto bottom = vertexes[0].y, top = vertexes[0].y;
+    for (int32 i = 1; i < numvertexes; ++i)
+    {
+        left = std::min(left, vertexes[i].x);
+        right = std::max(right, vertexes[i].x);
+        bottom = std::min(bottom, vertexes[i].y);
+        top = std::max(top, vertexes[i].y);
+    }
+
+    // Walk a grid over the map, keeping the points that are really
+    // inside a subsector (in front of all of its segs) with room for a
+    // monster.
+    int32 spawned = 0;
+    for (auto y = bottom + spacing / 2; y < top && spawned < monsters; y += spacing)
+    {
+        for (auto x = left + spacing / 2; x < right && spawned < monsters; x += spacing)
+        {
+            auto* subsector = R_PointInSubsector(x, y);
+            auto* sector = subsector->sector;
+            if (sector->ceilingheight - sector->floorheight < 64 * FRACUNIT)
+                continue;
+
+            auto inside = true;
+            for (int32 i = 0; i < subsector->numlines && inside; ++i)
+                inside = R_PointOnSegSide(x, y, &segs[subsector->firstline + i]) == 0;
+            if (!inside)
+                continue;
+
+            auto* mo = P_SpawnMobj(x, y, ONFLOORZ, types[spawned % std::size(types)]);
+            if (!P_CheckPosition(mo, x, y))
+            {
+                P_RemoveMobj(mo);
+                continue;
+            }
+
+            mo->target = player;
+            P_SetMobjState(mo, mo->info->seestate);
+            ++spawned;
+        }
+    }
+
+    if (view)
+        g_doom->GetRender()->CheckSetViewSize();
+
+    double ms = 0.0;
+    double viewms = 0.0;
+    for (int32 n = 0; n < tics; ++n)
+    {
+        auto start = bench::clock::now();
+        {
+            bench::scoped_sample ticSample("tic");
+            P_Ticker();
+        }
+        auto ticked = bench::clock::now();
+        ms += std::chrono::duration<double, std::milli>(ticked - start).count();
+
+        if (view)
+        {
+            bench::scoped_sample viewSample("view");
+            R_RenderPlayerView(&players[consoleplayer]);
+            viewms += std::chrono::duration<double, std::milli>(bench::clock::now() - ticked).count();
+        }
+    }
+
+    auto checksum = P_Checksum();
+    std::cout << std::format("slaughter: {} of {} monsters, {} tics in {:.1f} ms, {:.1f} tics/s, checksum {:#010x}\n",
+        spawned, monsters, tics, ms, ms > 0.0 ? tics * 1000.0 / ms : 0.0, checksum);
+    if (view)
+        std::cout << std::format("slaughter: {:.3f} ms/view\n", viewms / tics);
+    if (view && bench::is_enabled())
+        std::cout << std::format("slaughter: {:.3f} ms/view in R_DrawMasked\n", bench::total("masked") / tics);
+
+    // A snapshot of the fight loaded back after another second of it
+    // has to play that second out the same way again. The first save
+    // sizes the buffer, the second is the one timed.
+    vector<byte> snapshot;
+    G_SaveSnapshot(snapshot);
+    snapshot.clear();
+    auto saveStart = bench::clock::now();
+    G_SaveSnapshot(snapshot);
+    auto saveMs = std::chrono::duration<double, std::milli>(bench::clock::now() - saveStart).count();
+
+    for (int32 n = 0; n < TICRATE; ++n)
+        P_Ticker();
+    auto played = P_Checksum();
+
+    auto loadStart = bench::clock::now();
+    G_LoadSnapshot(snapshot);
+    auto loadMs = std::chrono::duration<double, std::milli>(bench::clock::now() - loadStart).count();
+
+    for (int32 n = 0; n < TICRATE; ++n)
+        P_Ticker();
+    std::cout << std::format("slaughter: {} byte snapshot saved in {:.3f} ms, loaded in {:.3f} ms, replay {}\n",
+        snapshot.size(), saveMs, loadMs, P_Checksum() == played ? "matches" : "DIFFERS");
+
+    bench::write_report(checksum, tics);
+    I_Quit();
+}
+
 /*
 ===================
 =
@@ -1419,9 +1992,21 @@ void G_TimeDemo(const char* name)
 
 bool G_CheckDemoStatus(Doom* doom)
 {
+    if (demoplayback && demoindexing)
+    {
+        demoindexing = false;
+        G_WriteDemoIndex();
+    }
+
     if (timingdemo)
     {
         auto endtime = I_GetTime();
+        if (bench::write_report(P_Checksum(), gametic))
+        {
+            std::cout << std::format("timed {} gametics in {} realtics, checksum {:#010x}\n", gametic, endtime - starttime, P_Checksum());
+            I_Quit();
+        }
+
         I_Error("timed {} gametics in {} realtics", gametic, endtime - starttime);
     }
 
@@ -1446,10 +2031,7 @@ bool G_CheckDemoStatus(Doom* doom)
 
     if (doom->IsDemoRecording())
     {
-        *demo_p++ = DEMOMARKER;
-        M_WriteFile(demoname, reinterpret_cast<char*>(demo_obuffer), static_cast<uint32>(demo_p - demo_obuffer));
-        Z_Free(demo_obuffer);
-        doom->SetDemoRecording(false);
+        G_EndRecording();
         I_Error("Demo {} recorded", demoname);
     }
 
@@ -37,12 +37,40 @@ void G_DeferedPlayDemo(const char* demo);
 // Called by M_Responder.
 void G_SaveGame(int slot, string_view description);
 
+// In-memory savegames, for quick saves and for going back a few tics
+// to find where a demo or a netgame went out of sync. Loading goes
+// back to the level the snapshot was taken on first if this isn't it,
+// otherwise it's done in place and takes a fraction of a tic. Returns
+// false if it isn't a snapshot this version can load.
+void G_SaveSnapshot(vector<byte>& buffer);
+bool G_LoadSnapshot(std::span<const byte> snapshot);
+
 // Only called by startup code.
 void G_RecordDemo(Doom* doom, string_view name);
 
 void G_BeginRecording();
 
+// Writes out what's left of the demo being recorded and closes it, so
+// it's a whole demo however the game ends.
+void G_EndRecording();
+
 void G_TimeDemo(const char* name);
+
+// Seeking about a demo played from the command line, through
+// snapshots of it every so many tics. -demoindex keeps one every
+// interval tics and writes them next to the demo when it ends, for
+// the next time it's played. A seek is done by Doom::Loop between
+// frames, G_DoDemoSeek plays the demo to the tic without drawing.
+void G_DemoIndex(int32 interval);
+void G_DemoSeek(int32 tic);
+bool G_DemoSeekPending();
+void G_DoDemoSeek();
+
+// The demo is held on a tic, Doom::Loop only takes events.
+bool G_DemoPaused();
+
+// Only called by startup code, -slaughter. Never returns.
+void G_SlaughterBench(int32 monsters, int32 tics, bool view);
 bool G_CheckDemoStatus(Doom* doom);
 
 void G_ExitLevel();
@@ -75,8 +103,6 @@ private:
     static const filesys::path SavePath;
     static constexpr const char* SaveFileName = "doomsav";
 
-    static const int32 VersionSize = 16;
-
     void DoSaveGame();
     void DoLoadGame();
 
@@ -19,7 +19,9 @@ import std;
 import nstd;
 import config;
 
+#ifndef DOOM_HEADLESS
 #include "system/windows.h"
+#endif
 
 #include "d_main.h"
 
@@ -37,6 +39,26 @@ consteval string_view get_type_name()
     return type_name;
 }
 
+#ifdef DOOM_HEADLESS
+int main(int argc, char** argv)
+{
+    // CommandLine keeps views into the source string, so it has to outlive the game.
+    static string args;
+    for (int32 n = 1; n < argc; ++n)
+    {
+        if (n > 1)
+            args += ' ';
+        args += argv[n];
+    }
+
+    CommandLine::Initialize(args);
+
+    g_doom = new Doom;
+    g_doom->Main();
+
+    return 0;
+}
+#else
 int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR args, int)
 {
     CommandLine::Initialize(args);
@@ -46,3 +68,4 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR args, int)
 
     return 0;
 }
+#endif
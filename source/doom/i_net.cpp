@@ -40,8 +40,6 @@ import config;
 #define htonl(x) ntohl(x)
 #define htons(x) ntohs(x)
 
-void	NetSend();
-
 // NETWORKING
 
 #define IPPORT_USERRESERVED 16384
@@ -52,9 +50,6 @@ SOCKET insocket;
 
 struct	sockaddr_in	sendaddress[Net::MaxNodes];
 
-void	(*netget) ();
-void	(*netsend) ();
-
 SOCKET UDPsocket()
 {
     // allocate a socket
@@ -86,102 +81,72 @@ void BindToLocalPort(SOCKET s, u_short port)
     }
 }
 
-void PacketSend()
-{
-    int		c;
-    doomdata_t	sw;
-
-    // byte swap
-    sw.checksum = htonl(netbuffer->checksum);
-    sw.player = netbuffer->player;
-    sw.retransmitfrom = netbuffer->retransmitfrom;
-    sw.starttic = netbuffer->starttic;
-    sw.numtics = netbuffer->numtics;
-    for (c = 0; c < netbuffer->numtics; c++)
-    {
-        sw.cmds[c].forwardmove = netbuffer->cmds[c].forwardmove;
-        sw.cmds[c].sidemove = netbuffer->cmds[c].sidemove;
-        sw.cmds[c].angleturn = htons(netbuffer->cmds[c].angleturn);
-        sw.cmds[c].consistancy = htons(netbuffer->cmds[c].consistancy);
-        sw.cmds[c].chatchar = netbuffer->cmds[c].chatchar;
-        sw.cmds[c].buttons = netbuffer->cmds[c].buttons;
-    }
-
-    //printf ("sending %i\n",gametic);		
-    c = sendto(
-        sendsocket,
-        reinterpret_cast<char*>(&sw),
-        doomcom->datalength,
-        0,
-        reinterpret_cast<sockaddr*>(&sendaddress[doomcom->remotenode]),
-        sizeof(sendaddress[doomcom->remotenode]));
-
-    //	if (c == -1)
-    //		I_Error ("SendPacket error: %s",strerror(errno));
-}
-
-
 //
-// PacketGet
+// UDP between the -net hosts. Winsock has no sendmmsg/recvmmsg, so a
+// batch is still one call per datagram, but the calls come one right
+// after the other instead of spread over the frame.
 //
-void PacketGet()
+class udp_transport : public net::transport
 {
-    struct sockaddr_in	fromaddress;
-    int32 fromlen = sizeof(fromaddress);
-    doomdata_t sw;
-    auto c = recvfrom(insocket, reinterpret_cast<char*>(&sw), sizeof(sw), 0, (sockaddr*)&fromaddress, &fromlen);
-    if (c == -1)
-    {
-        static char errorBuffer[1024];
-        if (_strerror_s(errorBuffer, nullptr) != EWOULDBLOCK)
-            I_Error("GetPacket: {}", errorBuffer);
-
-        doomcom->remotenode = -1;		// no packet
-        return;
-    }
-
+protected:
+    void send_batch(std::span<const net::datagram> batch) override
     {
-        static int first = 1;
-        if (first)
-            std::cout << std::format("len={}:p=[{:#010x} {:#010x}] \n", c, *(int*)&sw, *((int*)&sw + 1));
-        first = 0;
+        for (auto& datagram : batch)
+        {
+            auto& address = sendaddress[datagram.node];
+            sendto(
+                sendsocket,
+                reinterpret_cast<const char*>(datagram.data.data()),
+                datagram.length,
+                0,
+                reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address));
+        }
     }
 
-    // find remote node number
-    int16 i;
-    for (i = 0; i < doomcom->numnodes; ++i)
-        if (fromaddress.sin_addr.s_addr == sendaddress[i].sin_addr.s_addr)
-            break;
-
-    if (i == doomcom->numnodes)
+    int32 receive_batch(std::span<net::datagram> batch) override
     {
-        // packet is not from one of the players (new game broadcast)
-        doomcom->remotenode = -1;		// no packet
-        return;
-    }
-
-    doomcom->remotenode = i; // good packet from a game player
-    doomcom->datalength = static_cast<int16>(c);
-
-    // byte swap
-    netbuffer->checksum = ntohl(sw.checksum);
-    netbuffer->player = sw.player;
-    netbuffer->retransmitfrom = sw.retransmitfrom;
-    netbuffer->starttic = sw.starttic;
-    netbuffer->numtics = sw.numtics;
+        int32 count = 0;
+        while (count < static_cast<int32>(batch.size()))
+        {
+            auto& datagram = batch[count];
+
+            sockaddr_in fromaddress;
+            int32 fromlen = sizeof(fromaddress);
+            auto c = recvfrom(insocket, reinterpret_cast<char*>(datagram.data.data()), net::MaxDatagram, 0, reinterpret_cast<sockaddr*>(&fromaddress), &fromlen);
+            if (c == SOCKET_ERROR)
+            {
+                auto error = WSAGetLastError();
+                if (error == WSAEWOULDBLOCK)
+                    break;
+
+                // a node that isn't up yet
+                if (error == WSAECONNRESET)
+                    continue;
+
+                I_Error("GetPacket: error {}", error);
+            }
+
+            // find remote node number
+            int32 i;
+            for (i = 0; i < doomcom->numnodes; ++i)
+                if (fromaddress.sin_addr.s_addr == sendaddress[i].sin_addr.s_addr)
+                    break;
+
+            // packet is not from one of the players (new game broadcast)
+            if (i == doomcom->numnodes)
+                continue;
+
+            datagram.node = i;
+            datagram.length = c;
+            ++count;
+        }
 
-    for (c = 0; c < netbuffer->numtics; c++)
-    {
-        netbuffer->cmds[c].forwardmove = sw.cmds[c].forwardmove;
-        netbuffer->cmds[c].sidemove = sw.cmds[c].sidemove;
-        netbuffer->cmds[c].angleturn = ntohs(sw.cmds[c].angleturn);
-        netbuffer->cmds[c].consistancy = ntohs(sw.cmds[c].consistancy);
-        netbuffer->cmds[c].chatchar = sw.cmds[c].chatchar;
-        netbuffer->cmds[c].buttons = sw.cmds[c].buttons;
+        return count;
     }
-}
-
+};
 
+udp_transport udp;
 
 int GetLocalAddress()
 {
@@ -242,8 +207,7 @@ void I_InitNetwork()
         return;
     }
 
-    netsend = PacketSend;
-    netget = PacketGet;
+    nettransport = &udp;
     netgame = true;
 
     // parse player number and host list
@@ -276,17 +240,10 @@ void I_InitNetwork()
     // build message to receive
     insocket = UDPsocket();
     BindToLocalPort(insocket, htons(DOOMPORT));
-    //ioctl (insocket, FIONBIO, &trueval);
 
-    sendsocket = UDPsocket();
-}
+    // the transport takes what's waiting and doesn't wait for more
+    u_long trueval = 1;
+    ioctlsocket(insocket, FIONBIO, &trueval);
 
-void I_NetCmd()
-{
-    if (doomcom->command == CMD_SEND)
-        netsend();
-    else if (doomcom->command == CMD_GET)
-        netget();
-    else
-        I_Error("Bad net cmd: {}\n", doomcom->command);
+    sendsocket = UDPsocket();
 }
@@ -17,5 +17,10 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+import net;
+
+// What the packets of a netgame go through, set up by I_InitNetwork
+// (or -netloopback), nullptr when there's no netgame.
+extern net::transport* nettransport;
+
 void I_InitNetwork();
-void I_NetCmd();
@@ -0,0 +1,48 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Null network interface for the headless build, no sockets.
+//	-netloopback still works, see d_net.cpp.
+//
+//-----------------------------------------------------------------------------
+#include "i_system.h"
+#include "d_net.h"
+#include "doomstat.h"
+#include "i_net.h"
+
+import std;
+import nstd;
+import config;
+
+void I_InitNetwork()
+{
+    doomcom = static_cast<doomcom_t*>(std::malloc(sizeof(*doomcom)));
+    memset(doomcom, 0, sizeof(*doomcom));
+
+    if (CommandLine::TryGetValues("-dup", doomcom->ticdup))
+        doomcom->ticdup = std::clamp<short>(doomcom->ticdup, 1, 9);
+    else
+        doomcom->ticdup = 1;
+
+    doomcom->extratics = CommandLine::HasArg("-extratic") ? 1 : 0;
+
+    if (CommandLine::HasArg("-net"))
+        std::cout << "I_InitNetwork: headless build has no network, -net ignored.\n";
+
+    netgame = false;
+    doomcom->id = DOOMCOM_ID;
+    doomcom->numplayers = doomcom->numnodes = 1;
+    doomcom->deathmatch = false;
+    doomcom->consoleplayer = 0;
+}
@@ -15,11 +15,6 @@
 //	System interface for sound.
 //
 //-----------------------------------------------------------------------------
-#include "system/windows.h"
-
-#include <mmdeviceapi.h>
-#include <Audioclient.h>
-
 #include "z_zone.h"
 #include "i_system.h"
 #include "i_sound.h"
@@ -30,39 +25,31 @@
 import std;
 import nstd;
 import config;
-import log;
+import mixer;
 
 
-// The number of internal mixing channels, the samples calculated for each mixing step, the size
-// of the 16bit, 2 hardware channel (stereo) mixing buffer, and the sample rate of the raw data.
+// The number of internal mixing channels, the samples calculated for each mixing step, and the
+// sample rate of the raw data.
 
 // Needed for calling the actual sound output.
 static constexpr const uint32 SAMPLECOUNT = 512;
 static constexpr const uint32 NUM_CHANNELS = 8;
 
-// It is 2 for 16bit, and 2 for two channels.
-static constexpr const uint32 BUFMUL = 4;
-static constexpr const uint32 MIXBUFFERSIZE = SAMPLECOUNT * BUFMUL;
-
 static constexpr const uint32 SAMPLERATE = 11025;	// Hz
 static constexpr const uint32 SAMPLESIZE = 2;   	// 16bit
 
 // The actual lengths of all sound effects.
 int 		lengths[NUMSFX];
 
-// The global mixing buffer.
+// The global mixing bus, interleaved left and right.
 // Basically, samples from all active internal channels are modifed and added, and stored in the
 // buffer that is submitted to the audio device.
-signed short	mixbuffer[MIXBUFFERSIZE];
+float		mixbus[SAMPLECOUNT * 2];
 
-// The channel step amount...
-unsigned int	channelstep[NUM_CHANNELS];
-// ... and a 0.16 bit remainder of last step.
-unsigned int	channelstepremainder[NUM_CHANNELS];
+// The internal channels: raw data position and end, step and volumes.
+mixer::voice	voices[NUM_CHANNELS];
 
-// The channel data pointers, start and end.
-unsigned char* channels[NUM_CHANNELS];
-unsigned char* channelsend[NUM_CHANNELS];
+static mixer::kernel mixkernel = mixer::kernel::scalar;
 
 
 // Time/gametic that the channel started playing, used to determine oldest, which automatically
@@ -81,13 +68,6 @@ int		channelids[NUM_CHANNELS];
 // Pitch to stepping lookup, unused.
 int		steptable[256];
 
-// Volume lookups.
-int		vol_lookup[128 * 256];
-
-// Hardware left and right channel volume lookup.
-int* channelleftvol_lookup[NUM_CHANNELS];
-int* channelrightvol_lookup[NUM_CHANNELS];
-
 // This function loads the sound data from the WAD lump, for single sound.
 void* getsfx(string_view sfxname, int32* len)
 {
@@ -113,14 +93,14 @@ void* getsfx(string_view sfxname, int32* len)
     // The original realloc would interfere with zone memory.
     auto paddedsize = ((size - 8 + (SAMPLECOUNT - 1)) / SAMPLECOUNT) * SAMPLECOUNT;
 
-    // Allocate from zone memory.
-    auto* paddedsfx = (unsigned char*)Z_Malloc(paddedsize + 8, PU_STATIC, 0);
+    // Allocate from zone memory, with room for the mixer to read past the end.
+    auto* paddedsfx = (unsigned char*)Z_Malloc(paddedsize + 8 + mixer::Padding, PU_STATIC, 0);
     // ddt: (unsigned char *) realloc(sfx, paddedsize+8);
     // This should interfere with zone memory handling, which does not kick in in the soundserver.
 
     // Now copy and pad.
     memcpy(paddedsfx, sfx, size);
-    for (uint32 i = size; i < paddedsize + 8; ++i)
+    for (uint32 i = size; i < paddedsize + 8 + mixer::Padding; ++i)
         paddedsfx[i] = 128;
 
     // Preserve padded length.
@@ -140,7 +120,6 @@ void I_SetChannels()
     // This function sets up internal lookups used during
     //  the mixing process. 
     int		i;
-    int		j;
 
     int* steptablemid = steptable + 128;
 
@@ -155,13 +134,8 @@ void I_SetChannels()
     for (i = -128; i < 128; i++)
         steptablemid[i] = (int)(std::pow(2.0, (i / 64.0)) * 65536.0);
 
-
-    // Generates volume lookup tables
-    //  which also turn the unsigned samples
-    //  into signed samples.
-    for (i = 0; i < 128; i++)
-        for (j = 0; j < 256; j++)
-            vol_lookup[i * 256 + j] = (i * (j - 128) * 256) / 127;
+    // The volume lookup tables that also turned the unsigned samples into signed samples are
+    // gone, the mixer scales (sample - 128) by a float gain per channel instead.
 }
 
 void I_SetSfxVolume(int volume)
@@ -261,95 +235,12 @@ int I_QrySongPlaying(int handle)
     return looping || musicdies > gametic;
 }
 
-IMMDevice* Sound::device = nullptr;
-IAudioClient* Sound::client = nullptr;
-IAudioRenderClient* Sound::renderer = nullptr;
-
-int32 Sound::samplesPerSec = 0;
-int32 Sound::bitsPerSample = 0;
-int32 Sound::numChannels = 0;
-int32 Sound::frameBytes = 0;
-
-size_t Sound::mixBufferSize = 0;
-byte* Sound::mixBuffer = nullptr;
-uint32 Sound::bufferSizeInFrames = 0;
-
-const CLSID CLSID_MMDeviceEnumerator = __uuidof(MMDeviceEnumerator);
-const IID IID_IMMDeviceEnumerator = __uuidof(IMMDeviceEnumerator);
-const IID IID_IAudioClient = __uuidof(::IAudioClient);
-const IID IID_IAudioRenderClient = __uuidof(::IAudioRenderClient);
-const REFERENCE_TIME nsPerSec = 10'000'000; // 1 second
-
 //vector<std::pair<double, Synth::Function*>> Sound::functions;
 vector<uint32> Sound::free;
 
 void Sound::Init()
 {
-    CoInitializeEx(NULL, COINIT_MULTITHREADED);
-
-    IMMDeviceEnumerator* enumerator = nullptr;
-    auto result = CoCreateInstance(
-        CLSID_MMDeviceEnumerator,
-        nullptr,
-        CLSCTX_ALL,
-        IID_IMMDeviceEnumerator,
-        reinterpret_cast<LPVOID*>(&enumerator));
-    if (FAILED(result))
-        I_Error("CoCreateInstance failed: {}", result);
-
-    result = enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &device);
-    if (FAILED(result))
-        I_Error("GetDefaultAudioEndpoint failed: {}", result);
-
-    enumerator->Release();
-
-    result = device->Activate(
-        IID_IAudioClient,
-        CLSCTX_ALL,
-        nullptr,
-        reinterpret_cast<void**>(&client));
-    if (FAILED(result))
-        I_Error("Activate failed: {}", result);
-
-    WAVEFORMATEX* fmt = nullptr;
-    result = client->GetMixFormat(&fmt);
-    if (FAILED(result))
-        I_Error("GetMixFormat failed: {}", result);
-
-    samplesPerSec = fmt->nSamplesPerSec;
-    bitsPerSample = fmt->wBitsPerSample;
-    numChannels = fmt->nChannels;
-
-    frameBytes = numChannels * (bitsPerSample / 8);
-
-    result = client->Initialize(
-        AUDCLNT_SHAREMODE_SHARED,
-        0,
-        std::llround(bufferLengthInSeconds * nsPerSec),
-        0,
-        fmt,
-        nullptr);
-    if (FAILED(result))
-        I_Error("Initialize failed: {}", result);
-
-    result = client->GetBufferSize(&bufferSizeInFrames);
-    if (FAILED(result))
-        I_Error("GetBufferSize failed: {}", result);
-
-    mixBufferSize = bufferSizeInFrames * frameBytes;
-    mixBuffer = new byte[mixBufferSize];
-
-    result = client->GetService(IID_IAudioRenderClient, reinterpret_cast<void**>(&renderer));
-    if (FAILED(result))
-        I_Error("GetService failed: {}", result);
-
-    result = client->Start();
-    if (FAILED(result))
-        I_Error("Start failed: {}", result);
-
-    //std::cout << std::format("Sound::Initialize - buffer frames: {} samples/sec: {} bits/sample: {} channels: {} mixBufferSize: {}\n",
-    //    bufferSizeInFrames, samplesPerSec, bitsPerSample, numChannels, mixBufferSize);
-    logger::info("Sound::Initialize - buffer frames: ",  bufferSizeInFrames, "samples/sec: ", samplesPerSec, " bits/sample: ", bitsPerSample, " channels: ", numChannels, " mixBufferSize: ", mixBufferSize);
+    InitDevice();
 
     for (int32 i = 1; i < NUMSFX; i++)
     {
@@ -369,152 +260,27 @@ void Sound::Init()
 
     std::cout << " pre-cached all sound data\n";
 
+    mixkernel = mixer::best_kernel();
+    std::cout << std::format("Sound::Init: {} mixer\n", mixer::name(mixkernel));
+
     // Finished initialization.
     std::cout << "Sound::Init: sound module ready\n";
 }
 
 void Sound::Update()
 {
-    // This function loops all active (internal) sound channels, retrieves a given number of samples
-    // from the raw sound data, modifies it according to the current (internal) channel parameters,
-    // mixes the per channel samples into the global mixbuffer, clamping it to the allowed range, and
-    // sets up everything for transferring the contents of the mixbuffer to the (two) hardware
-    // channels (left and right, that is).
-    //
-    // This function currently supports only 16bit.
-
-    // Step in mixbuffer, left and right, thus two.
-    int32 step = 2;
-
-    // Left and right channel
-    //  are in global mixbuffer, alternating.
-    auto* leftout = mixbuffer;
-    auto* rightout = mixbuffer + 1;
-
-    // Determine end, for left channel only
-    //  (right channel is implicit).
-    auto* leftend = mixbuffer + SAMPLECOUNT * step;
-
-    // Mix sounds into the mixing buffer.
-    // Loop over step*SAMPLECOUNT,
-    //  that is 512 values for two channels.
-    while (leftout != leftend)
-    {
-        // Mix current sound data.
-        // Data, from raw sound, for right and left.
-
-        // Reset left/right value. 
-        int32 dl = 0;
-        int32 dr = 0;
+    // This function mixes all active (internal) sound channels into the global mixbus, a whole
+    // block of SAMPLECOUNT frames per channel at a time, resampling by the channel step and
+    // scaling by its left and right volume. The audio backend clamps the bus while writing it out
+    // to the (two) hardware channels (left and right, that is).
+    mixer::mix(mixkernel, voices, mixbus, SAMPLECOUNT);
 
-        // Love thy L2 chache - made this a loop.
-        // Now more channels could be set at compile time as well. Thus loop those  channels.
-        for (int32 chan = 0; chan < NUM_CHANNELS; chan++)
-        {
-            // Check channel, if active.
-            if (channels[chan])
-            {
-                // Get the raw data from the channel. 
-                uint32 sample = *channels[chan];
-                // Add left and right part
-                //  for this channel (sound)
-                //  to the current data.
-                // Adjust volume accordingly.
-                dl += channelleftvol_lookup[chan][sample];
-                dr += channelrightvol_lookup[chan][sample];
-                // Increment index ???
-                channelstepremainder[chan] += channelstep[chan];
-                // MSB is next sample???
-                channels[chan] += channelstepremainder[chan] >> 16;
-                // Limit to LSB???
-                channelstepremainder[chan] &= 65536 - 1;
-
-                // Check whether we are done.
-                if (channels[chan] >= channelsend[chan])
-                    channels[chan] = 0;
-            }
-        }
-
-        // Clamp to range. Left hardware channel.
-        // Has been char instead of short.
-        // if (dl > 127) *leftout = 127;
-        // else if (dl < -128) *leftout = -128;
-        // else *leftout = dl;
-
-        // Pointers in global mixbuffer, left, right, end.
-
-        if (dl > 0x7fff)
-            *leftout = 0x7fff;
-        else if (dl < -0x8000)
-            *leftout = -0x8000;
-        else
-            *leftout = static_cast<short>(dl);
-
-        // Same for right hardware channel.
-        if (dr > 0x7fff)
-            *rightout = 0x7fff;
-        else if (dr < -0x8000)
-            *rightout = -0x8000;
-        else
-            *rightout = static_cast<short>(dr);
-
-        // Increment current pointers in mixbuffer.
-        leftout += step;
-        rightout += step;
-    }
-
-    // See how much buffer space is available.
-    uint32 paddingFrames = 0;
-    auto result = client->GetCurrentPadding(&paddingFrames);
-    if (FAILED(result))
-        I_Error("GetCurrentPadding failed: {}", result);
-
-    uint32 numFramesAvailable = bufferSizeInFrames - paddingFrames;
-    //assert(numFramesAvailable / 4 >= SAMPLECOUNT);
-    auto writeFrames = std::min(numFramesAvailable / 4, SAMPLECOUNT);
-
-    // Grab all the available space in the shared buffer.
-    byte* data = nullptr;
-    result = renderer->GetBuffer(writeFrames * 4, &data);
-    if (FAILED(result))
-        I_Error("GetBuffer failed: {}", result);
-
-    auto* fp = reinterpret_cast<float*>(data);
-    auto* mp = mixbuffer;
-    auto to_float = [](int16 n){ return static_cast<float>(n) / std::numeric_limits<int16>::max(); };
-    for (uint32 n = 0; n < writeFrames; ++n)
-    {
-        *fp++ = to_float(*mp);
-        *fp++ = to_float(*mp);
-        *fp++ = to_float(*mp);
-        *fp++ = to_float(*mp++);
-
-        *fp++ = to_float(*mp);
-        *fp++ = to_float(*mp);
-        *fp++ = to_float(*mp);
-        *fp++ = to_float(*mp++);
-    }
-
-    int flags = 0;
-    result = renderer->ReleaseBuffer(writeFrames * 4, flags);
-    if (FAILED(result))
-        I_Error("ReleaseBuffer failed: {}", result);
+    SubmitMix(mixbus, SAMPLECOUNT);
 }
 
 void Sound::Shutdown()
 {
-    delete[] mixBuffer;
-
-    client->Stop();
-
-    renderer->Release();
-    renderer = nullptr;
-
-    client->Release();
-    client = nullptr;
-
-    device->Release();
-    device = nullptr;
+    ShutdownDevice();
 }
 
 int32 Sound::Play(int32 id, int32 volume, int32 seperation, int32 pitch, [[maybe_unused]] int32 priority)
@@ -542,10 +308,10 @@ int32 Sound::Play(int32 id, int32 volume, int32 seperation, int32 pitch, [[maybe
         for (int32 i = 0; i < NUM_CHANNELS; ++i)
         {
             // Active, and using the same SFX?
-            if ((channels[i]) && (channelids[i] == id))
+            if ((voices[i].data) && (channelids[i] == id))
             {
                 // Reset.
-                channels[i] = 0;
+                voices[i].data = nullptr;
                 // We are sure that iff, there will only be one.
                 break;
             }
@@ -556,7 +322,7 @@ int32 Sound::Play(int32 id, int32 volume, int32 seperation, int32 pitch, [[maybe
     int32 oldest = gametic;
     int32 oldestnum = 0;
     int32 i = 0;
-    for (; (i < NUM_CHANNELS) && (channels[i]); ++i)
+    for (; (i < NUM_CHANNELS) && (voices[i].data); ++i)
     {
         if (channelstart[i] < oldest)
         {
@@ -578,9 +344,10 @@ int32 Sound::Play(int32 id, int32 volume, int32 seperation, int32 pitch, [[maybe
     // Okay, in the less recent channel,
     //  we will handle the new SFX.
     // Set pointer to raw data.
-    channels[slot] = (unsigned char*)S_sfx[id].data;
+    auto& voice = voices[slot];
+    voice.data = static_cast<const uint8*>(S_sfx[id].data);
     // Set pointer to end of raw data.
-    channelsend[slot] = channels[slot] + lengths[id];
+    voice.end = voice.data + lengths[id];
 
     // Reset current handle number, limited to 0..100.
     if (!handlenums)
@@ -593,9 +360,9 @@ int32 Sound::Play(int32 id, int32 volume, int32 seperation, int32 pitch, [[maybe
 
     // Set stepping???
     // Kinda getting the impression this is never used.
-    channelstep[slot] = steptable[pitch];
+    voice.step = steptable[pitch];
     // ???
-    channelstepremainder[slot] = 0;
+    voice.frac = 0;
     // Should be gametic, I presume.
     channelstart[slot] = gametic;
 
@@ -617,10 +384,9 @@ int32 Sound::Play(int32 id, int32 volume, int32 seperation, int32 pitch, [[maybe
     if (leftvol < 0 || leftvol > 127)
         I_Error("leftvol out of bounds");
 
-    // Get the proper lookup table piece
-    //  for this volume level???
-    channelleftvol_lookup[slot] = &vol_lookup[leftvol * 256];
-    channelrightvol_lookup[slot] = &vol_lookup[rightvol * 256];
+    // Scale for this volume level.
+    voice.left = mixer::gain(leftvol);
+    voice.right = mixer::gain(rightvol);
 
     // Preserve sound SFX id,
     //  e.g. for avoiding duplicates of chainsaw.
@@ -80,6 +80,13 @@ public:
     static void Stop(int32 handle);
 
 private:
+    // Implemented by the audio backend, i_sound_wasapi.cpp or i_sound_null.cpp for the headless
+    // build. SubmitMix receives the unclamped float stereo bus at 11025 Hz, in 16 bit units, see
+    // the mixer module.
+    static void InitDevice();
+    static void SubmitMix(const float* bus, uint32 frames);
+    static void ShutdownDevice();
+
     static constexpr const double bufferLengthInSeconds = 0.05; //1.0 / 35; //0.05;
 
     static struct IMMDevice* device;
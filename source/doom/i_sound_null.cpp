@@ -0,0 +1,110 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Null audio device for the headless build. The mixer still runs,
+//	the mixed buffer is dropped, or written to a WAV file with
+//	-wavout <file> so the mix can be checked offline. One block is
+//	mixed per frame, so the WAV runs at the frame rate, not in real
+//	time.
+//
+//-----------------------------------------------------------------------------
+#include "i_sound.h"
+#include "i_system.h"
+
+import std;
+import nstd;
+import config;
+import mixer;
+
+IMMDevice* Sound::device = nullptr;
+IAudioClient* Sound::client = nullptr;
+IAudioRenderClient* Sound::renderer = nullptr;
+
+int32 Sound::samplesPerSec = 0;
+int32 Sound::bitsPerSample = 0;
+int32 Sound::numChannels = 0;
+int32 Sound::frameBytes = 0;
+
+size_t Sound::mixBufferSize = 0;
+byte* Sound::mixBuffer = nullptr;
+uint32 Sound::bufferSizeInFrames = 0;
+
+namespace
+{
+
+std::ofstream wavFile;
+uint32 wavFrames = 0;
+vector<int16> wavBlock;
+
+// 16 bit stereo PCM at the mixer's 11025 Hz, the sizes are patched in when the file is closed.
+void WriteWavHeader(uint32 frames)
+{
+    constexpr uint32 Rate = 11025;
+    constexpr uint16 Channels = 2;
+    constexpr uint16 Bits = 16;
+
+    auto put = [](auto value){ wavFile.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    auto dataBytes = frames * Channels * Bits / 8;
+
+    wavFile.write("RIFF", 4);
+    put(uint32{36 + dataBytes});
+    wavFile.write("WAVEfmt ", 8);
+    put(uint32{16});
+    put(uint16{1}); // PCM
+    put(Channels);
+    put(Rate);
+    put(uint32{Rate * Channels * Bits / 8});
+    put(uint16{Channels * Bits / 8});
+    put(Bits);
+    wavFile.write("data", 4);
+    put(dataBytes);
+}
+
+} // namespace
+
+void Sound::InitDevice()
+{
+    std::cout << "Sound::InitDevice: headless, using null audio device.\n";
+
+    if (string path; CommandLine::TryGetValues("-wavout", path))
+    {
+        wavFile.open(path, std::ios_base::binary | std::ios_base::trunc);
+        if (!wavFile.is_open())
+            I_Error("Sound::InitDevice: can't open {}", path);
+
+        WriteWavHeader(0);
+        std::cout << std::format("Sound::InitDevice: writing the mix to {}\n", path);
+    }
+}
+
+void Sound::SubmitMix(const float* bus, uint32 frames)
+{
+    if (!wavFile.is_open())
+        return;
+
+    wavBlock.resize(frames * 2);
+    mixer::write_int16(bus, wavBlock.data(), frames);
+    wavFile.write(reinterpret_cast<const char*>(wavBlock.data()), frames * 2 * sizeof(int16));
+    wavFrames += frames;
+}
+
+void Sound::ShutdownDevice()
+{
+    if (!wavFile.is_open())
+        return;
+
+    wavFile.seekp(0);
+    WriteWavHeader(wavFrames);
+    wavFile.close();
+}
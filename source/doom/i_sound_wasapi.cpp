@@ -0,0 +1,160 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	WASAPI audio device for the sound mixer.
+//
+//-----------------------------------------------------------------------------
+#include "system/windows.h"
+
+#include <mmdeviceapi.h>
+#include <Audioclient.h>
+
+#include "i_system.h"
+#include "i_sound.h"
+
+import std;
+import nstd;
+import log;
+import mixer;
+
+IMMDevice* Sound::device = nullptr;
+IAudioClient* Sound::client = nullptr;
+IAudioRenderClient* Sound::renderer = nullptr;
+
+int32 Sound::samplesPerSec = 0;
+int32 Sound::bitsPerSample = 0;
+int32 Sound::numChannels = 0;
+int32 Sound::frameBytes = 0;
+
+size_t Sound::mixBufferSize = 0;
+byte* Sound::mixBuffer = nullptr;
+uint32 Sound::bufferSizeInFrames = 0;
+
+const CLSID CLSID_MMDeviceEnumerator = __uuidof(MMDeviceEnumerator);
+const IID IID_IMMDeviceEnumerator = __uuidof(IMMDeviceEnumerator);
+const IID IID_IAudioClient = __uuidof(::IAudioClient);
+const IID IID_IAudioRenderClient = __uuidof(::IAudioRenderClient);
+const REFERENCE_TIME nsPerSec = 10'000'000; // 1 second
+
+void Sound::InitDevice()
+{
+    CoInitializeEx(NULL, COINIT_MULTITHREADED);
+
+    IMMDeviceEnumerator* enumerator = nullptr;
+    auto result = CoCreateInstance(
+        CLSID_MMDeviceEnumerator,
+        nullptr,
+        CLSCTX_ALL,
+        IID_IMMDeviceEnumerator,
+        reinterpret_cast<LPVOID*>(&enumerator));
+    if (FAILED(result))
+        I_Error("CoCreateInstance failed: {}", result);
+
+    result = enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &device);
+    if (FAILED(result))
+        I_Error("GetDefaultAudioEndpoint failed: {}", result);
+
+    enumerator->Release();
+
+    result = device->Activate(
+        IID_IAudioClient,
+        CLSCTX_ALL,
+        nullptr,
+        reinterpret_cast<void**>(&client));
+    if (FAILED(result))
+        I_Error("Activate failed: {}", result);
+
+    WAVEFORMATEX* fmt = nullptr;
+    result = client->GetMixFormat(&fmt);
+    if (FAILED(result))
+        I_Error("GetMixFormat failed: {}", result);
+
+    samplesPerSec = fmt->nSamplesPerSec;
+    bitsPerSample = fmt->wBitsPerSample;
+    numChannels = fmt->nChannels;
+
+    frameBytes = numChannels * (bitsPerSample / 8);
+
+    result = client->Initialize(
+        AUDCLNT_SHAREMODE_SHARED,
+        0,
+        std::llround(bufferLengthInSeconds * nsPerSec),
+        0,
+        fmt,
+        nullptr);
+    if (FAILED(result))
+        I_Error("Initialize failed: {}", result);
+
+    result = client->GetBufferSize(&bufferSizeInFrames);
+    if (FAILED(result))
+        I_Error("GetBufferSize failed: {}", result);
+
+    mixBufferSize = bufferSizeInFrames * frameBytes;
+    mixBuffer = new byte[mixBufferSize];
+
+    result = client->GetService(IID_IAudioRenderClient, reinterpret_cast<void**>(&renderer));
+    if (FAILED(result))
+        I_Error("GetService failed: {}", result);
+
+    result = client->Start();
+    if (FAILED(result))
+        I_Error("Start failed: {}", result);
+
+    //std::cout << std::format("Sound::Initialize - buffer frames: {} samples/sec: {} bits/sample: {} channels: {} mixBufferSize: {}\n",
+    //    bufferSizeInFrames, samplesPerSec, bitsPerSample, numChannels, mixBufferSize);
+    logger::info("Sound::Initialize - buffer frames: ",  bufferSizeInFrames, "samples/sec: ", samplesPerSec, " bits/sample: ", bitsPerSample, " channels: ", numChannels, " mixBufferSize: ", mixBufferSize);
+}
+
+void Sound::SubmitMix(const float* bus, uint32 frames)
+{
+    // See how much buffer space is available.
+    uint32 paddingFrames = 0;
+    auto result = client->GetCurrentPadding(&paddingFrames);
+    if (FAILED(result))
+        I_Error("GetCurrentPadding failed: {}", result);
+
+    uint32 numFramesAvailable = bufferSizeInFrames - paddingFrames;
+    //assert(numFramesAvailable / 4 >= SAMPLECOUNT);
+    auto writeFrames = std::min(numFramesAvailable / 4, frames);
+
+    // Grab all the available space in the shared buffer.
+    byte* data = nullptr;
+    result = renderer->GetBuffer(writeFrames * 4, &data);
+    if (FAILED(result))
+        I_Error("GetBuffer failed: {}", result);
+
+    // Every 11025 Hz frame becomes four device frames, left and right on each.
+    mixer::write_float(bus, reinterpret_cast<float*>(data), writeFrames, 4, numChannels);
+
+    int flags = 0;
+    result = renderer->ReleaseBuffer(writeFrames * 4, flags);
+    if (FAILED(result))
+        I_Error("ReleaseBuffer failed: {}", result);
+}
+
+void Sound::ShutdownDevice()
+{
+    delete[] mixBuffer;
+
+    client->Stop();
+
+    renderer->Release();
+    renderer = nullptr;
+
+    client->Release();
+    client = nullptr;
+
+    device->Release();
+    device = nullptr;
+}
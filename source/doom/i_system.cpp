@@ -21,11 +21,22 @@
 #include "g_game.h"
 #include "i_system.h"
 #include "d_main.h"
+#include "r_pipeline.h"
 
 #include <cassert>
 #include <cstdlib>
 #include <ctime>
 
+#ifdef _WIN32
+#include "system/windows.h"
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 import std;
 
 
@@ -79,6 +90,89 @@ time_t I_GetTime()
     return now;
 }
 
+#ifdef _WIN32
+const byte* I_MapFile(const filesys::path& path, int64& size)
+{
+    auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    // The view keeps the mapping, and the mapping the file, open.
+    auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return nullptr;
+
+    auto* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data)
+        return nullptr;
+
+    size = fileSize.QuadPart;
+    return static_cast<const byte*>(data);
+}
+
+void I_UnmapFile(const byte* data, [[maybe_unused]] int64 size)
+{
+    UnmapViewOfFile(data);
+}
+
+int64 I_GetResidentBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+
+    return counters.WorkingSetSize;
+}
+#else
+const byte* I_MapFile(const filesys::path& path, int64& size)
+{
+    auto file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return nullptr;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        close(file);
+        return nullptr;
+    }
+
+    // The mapping keeps the file open.
+    auto* data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    size = info.st_size;
+    return static_cast<const byte*>(data);
+}
+
+void I_UnmapFile(const byte* data, int64 size)
+{
+    munmap(const_cast<byte*>(data), size);
+}
+
+int64 I_GetResidentBytes()
+{
+    std::ifstream statm{"/proc/self/statm"};
+    int64 pages = 0;
+    int64 resident = 0;
+    if (!(statm >> pages >> resident))
+        return 0;
+
+    return resident * sysconf(_SC_PAGESIZE);
+}
+#endif
+
 void I_Init()
 {
     Sound::Init();
@@ -86,10 +180,14 @@ void I_Init()
 
 void I_Quit()
 {
+    if (g_doom->IsDemoRecording())
+        G_EndRecording();
+
     D_QuitNetGame();
     Sound::Shutdown();
     I_ShutdownMusic();
     Settings::Save();
+    R_ShutdownPipeline();
     I_ShutdownGraphics();
     exit(0);
 }
@@ -105,7 +203,7 @@ void I_BeginRead()
 void I_EndRead()
 {}
 
-void I_Error(const string& error)
+[[noreturn]] void I_Error(const string& error)
 {
     std::cerr << "Error: " << error << "\n";
     std::cerr.flush();
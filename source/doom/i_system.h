@@ -39,6 +39,14 @@ byte* I_ZoneBase(intptr_t* size);
 // returns current time in tics.
 std::time_t I_GetTime();
 
+// Maps a whole file read-only into memory, or returns nullptr if it can't. The pages are shared
+// with the OS file cache and only read in when touched.
+const byte* I_MapFile(const filesys::path& path, int64& size);
+void I_UnmapFile(const byte* data, int64 size);
+
+// Physical memory currently used by the process, 0 if unknown.
+int64 I_GetResidentBytes();
+
 // Asynchronous interrupt functions should maintain private queues
 // that are read by the synchronous functions
 // to be converted into events.
@@ -56,8 +64,9 @@ void I_Quit();
 
 void I_Tactile(int on, int off, int total);
 
-void I_Error(const string& error);
-void I_Error(string_view error, auto&& ...args)
+// Prints the error, shuts down and exits.
+[[noreturn]] void I_Error(const string& error);
+[[noreturn]] void I_Error(string_view error, auto&& ...args)
 {
     string msg = std::vformat(error, std::make_format_args(args...));
     I_Error(msg);
@@ -31,6 +31,8 @@ import nstd;
 
 import config;
 import platform;
+import blit;
+import bench;
 
 
 #undef CreateWindow
@@ -104,6 +106,28 @@ void Video::FinishUpdate()
 {
     static time_t lasttic = 0;
 
+    auto width = nstd::size_cast<int32>(windowWidth / screenMultiply);
+    auto height = nstd::size_cast<int32>(windowHeight / screenMultiply);
+
+    // Only rows that changed since the last frame are converted and uploaded, unless the palette
+    // changed, which affects all of them.
+    auto firstDirty = height;
+    auto lastDirty = -1;
+    for (int32 y = 0; y < height; ++y)
+    {
+        auto* src = screens[0] + y * SCREENWIDTH;
+        auto* presented = presentedScreen + y * SCREENWIDTH;
+        if (!isPaletteDirty && std::memcmp(src, presented, width) == 0)
+            continue;
+
+        std::memcpy(presented, src, width);
+        blit::convert(blitKernel, src, palette, screenBuffer + y * screenTextureSize, width);
+
+        firstDirty = std::min(firstDirty, y);
+        lastDirty = y;
+    }
+    isPaletteDirty = false;
+
     // draws little dots on the bottom of the screen
     if (doom->IsDevMode())
     {
@@ -113,9 +137,12 @@ void Video::FinishUpdate()
         if (tics > 20) tics = 20;
 
         for (i = 0; i < tics * 2; i += 2)
-            screenBuffer[((windowHeight/screenMultiply- 1)*screenTextureSize)  + i] = 0xff'ff'ff'ff;
+            screenBuffer[((height - 1)*screenTextureSize)  + i] = 0xff'ff'ff'ff;
         for (; i < 20 * 2; i += 2)
-            screenBuffer[((windowHeight/screenMultiply- 1)*screenTextureSize)  + i] = 0xff'00'00'00;
+            screenBuffer[((height - 1)*screenTextureSize)  + i] = 0xff'00'00'00;
+
+        firstDirty = std::min(firstDirty, height - 1);
+        lastDirty = height - 1;
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -126,13 +153,15 @@ void Video::FinishUpdate()
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, screenTexture);
 
-    for (uint32 y = 0; y < windowHeight / screenMultiply; ++y)
-    for (uint32 x = 0; x < windowWidth / screenMultiply; ++x)
+    if (lastDirty >= firstDirty)
     {
-        screenBuffer[y * screenTextureSize + x] = palette[screens[0][y * SCREENWIDTH + x]];
-    }
+        auto rows = lastDirty - firstDirty + 1;
+        bench::count("present_rows", rows);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, screenTextureSize, screenTextureSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, screenBuffer);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, screenTextureSize);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstDirty, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, screenBuffer + firstDirty * screenTextureSize);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
 
     //glDrawBuffer(GL_COLOR_ATTACHMENT2);
     glBindVertexArray(screenVAO);
@@ -142,15 +171,6 @@ void Video::FinishUpdate()
         window->SwapBuffers();
 }
 
-void Video::SetPalette(const byte* inPalette)
-{
-    auto* p = inPalette;
-    for (int32 n = 0; n < 256; ++n, p += 3)
-    {
-        palette[n] = 0xff'00'00'00 | (*(p + 2) << 16) | (*(p + 1) << 8) | (*(p + 0) << 0);
-    }
-}
-
 void GLAPIENTRY Video::GLErrorCallback(
     [[maybe_unused]] GLenum source,
     [[maybe_unused]] GLenum type,
@@ -319,6 +339,9 @@ void Video::Init()
     }
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, screenTextureSize, screenTextureSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, screenBuffer);
+    presentedScreen = new byte[SCREENWIDTH * SCREENHEIGHT];
+    blitKernel = blit::best_kernel();
+    std::cout << std::format("Video::Init: {} palette conversion\n", blit::name(blitKernel));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
@@ -385,55 +408,6 @@ void Video::DeliverSystemMessages()
     }
 }
 
-// Masks a column based masked pic to the screen. 
-void Video::DrawPatch(int32 x, int32 y, int32 screen, const patch_t* patch)
-{
-    y -= patch->topoffset;
-    x -= patch->leftoffset;
-#ifdef RANGECHECK 
-    if (x<0
-        || x + (patch->width) >SCREENWIDTH
-        || y<0
-        || y + (patch->height)>SCREENHEIGHT
-        || screen > 4)
-    {
-        std::cerr << std::format("Patch at {},{} exceeds LFB\n", x, y);
-        // No I_Error abort - what is up with TNT.WAD?
-        std::cerr << "Video::DrawPatch: bad patch (ignored)\n";
-        return;
-    }
-#endif 
-
-    auto* desttop = screens[screen] + y * SCREENWIDTH + x;
-    auto w = patch->width;
-    for (int32 col = 0; col < w; x++, col++, desttop++)
-    {
-        auto* column = (column_t*)((byte*)patch + (patch->columnofs[col]));
-
-        // step through the posts in a column 
-        while (column->topdelta != 0xff)
-        {
-            auto* source = (byte*)column + 3;
-            auto* dest = desttop + column->topdelta * SCREENWIDTH;
-            auto count = column->length;
-
-            while (count--)
-            {
-                *dest = *source++;
-                dest += SCREENWIDTH;
-            }
-            column = (column_t*)((byte*)column + column->length + 4);
-        }
-    }
-}
-
-byte* Video::CopyScreen(int32 dest) const
-{
-    assert(dest > 0 && dest < std::size(screens));
-    memcpy(screens[dest], screens[0], SCREENWIDTH * SCREENHEIGHT);
-    return screens[dest];
-}
-
 GLuint Video::LoadShader(string_view name)
 {
     std::cout << "Loading shader: " << name << "\n";
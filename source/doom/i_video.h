@@ -18,11 +18,15 @@
 #pragma once
 
 import nstd;
+
+#ifndef DOOM_HEADLESS
 import platform;
+import blit;
 
 #include "system/windows.h"
 
 #include <GL/glew.h>
+#endif
 
 class Doom;
 struct patch_t;
@@ -35,6 +39,7 @@ void I_WaitVBL(int count);
 void I_BeginRead();
 void I_EndRead();
 
+#ifndef DOOM_HEADLESS
 struct SystemEvent
 {
     HWND handle = nullptr;
@@ -49,10 +54,19 @@ struct SystemEvent
         , lParam{lParam}
     {}
 };
+#endif
 
+// The DOOM_HEADLESS build (doom_headless project) swaps the window, GL context and audio device
+// for null backends (i_video_null.cpp, i_sound_null.cpp, i_net_null.cpp) so timedemos can be
+// benchmarked on machines without a GPU or a sound card.
 class Video
 {
 public:
+#ifdef DOOM_HEADLESS
+    static constexpr bool IsHeadless = true;
+#else
+    static constexpr bool IsHeadless = false;
+
     static void GLAPIENTRY GLErrorCallback(
         GLenum source,
         GLenum type,
@@ -61,6 +75,7 @@ public:
         GLsizei length,
         const GLchar* message,
         const void* param);
+#endif
 
     Video() = delete;
     Video(Doom* doom) : doom{doom} {}
@@ -88,7 +103,9 @@ public:
     byte* CopyScreen(int32 dest) const;
 
 private:
+#ifndef DOOM_HEADLESS
     GLuint LoadShader(string_view name);
+#endif
 
     Doom* doom = nullptr;
 
@@ -101,7 +118,9 @@ private:
     bool isBorderless = false;
     bool isResizeable = false;
 
+#ifndef DOOM_HEADLESS
     platform::Window* window = nullptr;
+#endif
 
     //HWND windowHandle = nullptr;
     //HDC deviceContext = nullptr;
@@ -123,6 +142,7 @@ private:
     //DWORD windowStyle = 0;
     //DWORD windowStyleEx = 0;
 
+#ifndef DOOM_HEADLESS
     uint32 screenTextureSize = 0;
     uint32* screenBuffer = nullptr;
     GLuint screenTexture = 0;
@@ -131,6 +151,13 @@ private:
     GLuint screenVBO = GL_INVALID_INDEX;
     GLuint screenVAO = GL_INVALID_INDEX;
 
+    // screens[0] as it was last converted, rows that still match it aren't converted or
+    // uploaded again.
+    byte* presentedScreen = nullptr;
+    blit::kernel blitKernel = blit::kernel::scalar;
+#endif
+
     byte* screens[5] = {nullptr};
     uint32 palette[256] = {0};
+    bool isPaletteDirty = true;
 };
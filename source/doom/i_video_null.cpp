@@ -0,0 +1,61 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Null video backend for the headless build. The software renderer
+//	still draws into screens[], nothing is ever presented.
+//
+//-----------------------------------------------------------------------------
+#include "i_video.h"
+
+#include "doomdef.h"
+#include "z_zone.h"
+#include "st_stuff.h"
+
+import std;
+import nstd;
+
+void I_ShutdownGraphics()
+{
+}
+
+void Video::Init()
+{
+    if (isInitialized)
+        return;
+
+    isInitialized = true;
+
+    byte* base = new byte[SCREENWIDTH * SCREENHEIGHT * 4];
+    for (int32 i = 0; i < 4; ++i)
+        screens[i] = base + i * SCREENWIDTH * SCREENHEIGHT;
+    screens[4] = (byte*)Z_Malloc(ST_WIDTH * ST_HEIGHT, PU_STATIC, 0);
+
+    std::cout << "Video::Init: headless, no window will be created.\n";
+}
+
+void Video::StartFrame()
+{
+}
+
+void Video::StartTick()
+{
+}
+
+void Video::FinishUpdate()
+{
+}
+
+void Video::DeliverSystemMessages()
+{
+}
@@ -0,0 +1,157 @@
+export module jobs;
+
+import std;
+import nstd;
+
+export namespace jobs {
+
+// A fixed set of worker threads that run one batch of indexed work items at a time. The thread
+// that calls run() works on the batch too, so a pool of size 1 has no workers at all and is
+// just a plain loop.
+class thread_pool
+{
+public:
+    explicit thread_pool(int32 size)
+    {
+        for (int32 n = 1; n < size; ++n)
+            workers.emplace_back([this](std::stop_token stop){ work(stop); });
+    }
+
+    ~thread_pool()
+    {
+        {
+            std::scoped_lock lock{mutex};
+            for (auto& worker : workers)
+                worker.request_stop();
+        }
+        wake.notify_all();
+        workers.clear();
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    int32 size() const { return workers.size() + 1; }
+
+    // Calls job(n) for every n in [0, count) and returns once all of them have finished. Items
+    // are handed out one at a time, so uneven items balance out across the threads.
+    void run(int32 count, const std::function<void(int32)>& job)
+    {
+        if (workers.empty() || count <= 1)
+        {
+            for (int32 n = 0; n < count; ++n)
+                job(n);
+            return;
+        }
+
+        {
+            std::scoped_lock lock{mutex};
+            batch = &job;
+            batchCount = count;
+            next = 0;
+            busy = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+
+        drain(job, count);
+
+        std::unique_lock lock{mutex};
+        done.wait(lock, [this]{ return busy == 0; });
+        batch = nullptr;
+    }
+
+private:
+    void drain(const std::function<void(int32)>& job, int32 count)
+    {
+        for (auto n = next.fetch_add(1); n < count; n = next.fetch_add(1))
+            job(n);
+    }
+
+    void work(std::stop_token stop)
+    {
+        uint64 seen = 0;
+        for (;;)
+        {
+            const std::function<void(int32)>* job = nullptr;
+            int32 count = 0;
+            {
+                std::unique_lock lock{mutex};
+                wake.wait(lock, [&]{ return stop.stop_requested() || generation != seen; });
+                if (stop.stop_requested())
+                    return;
+
+                seen = generation;
+                job = batch;
+                count = batchCount;
+            }
+
+            drain(*job, count);
+
+            {
+                std::scoped_lock lock{mutex};
+                --busy;
+            }
+            done.notify_one();
+        }
+    }
+
+    vector<std::jthread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(int32)>* batch = nullptr;
+    int32 batchCount = 0;
+    std::atomic<int32> next = 0;
+    int32 busy = 0;
+    uint64 generation = 0;
+};
+
+// Hands the newest of a stream of values from one producer thread to one consumer thread,
+// without locks and without copying them. Of the three slots the producer owns one and fills
+// it, publish() swaps it with the middle one, and the consumer's update() swaps the middle one
+// with its own when there's something newer in it. Neither side ever waits for the other, a
+// value the consumer doesn't get to in time is simply replaced by the next one.
+template<typename T>
+class triple_buffer
+{
+public:
+    triple_buffer() = default;
+
+    triple_buffer(const triple_buffer&) = delete;
+    triple_buffer& operator=(const triple_buffer&) = delete;
+
+    // Producer side. The slot to fill, the producer's alone until it's published.
+    T& back() { return slots[backIndex]; }
+
+    void publish()
+    {
+        backIndex = middle.exchange(backIndex | Fresh, std::memory_order_acq_rel) & IndexMask;
+    }
+
+    // Consumer side. Takes the newest published value if there's one it hasn't had yet, and
+    // returns whether front() changed.
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & Fresh))
+            return false;
+
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & IndexMask;
+        return true;
+    }
+
+    // The value the consumer has, the consumer's alone until the next update().
+    T& front() { return slots[frontIndex]; }
+
+private:
+    static constexpr uint32 IndexMask = 3;
+    static constexpr uint32 Fresh = 4;
+
+    T slots[3];
+    uint32 backIndex = 0;
+    std::atomic<uint32> middle = 1;
+    uint32 frontIndex = 2;
+};
+
+} // export namespace jobs
@@ -21,39 +21,7 @@
 import std;
 
 
-// Fixme. __USE_C_FIXED__ or something.
-
-fixed_t
-FixedMul
-(fixed_t	a,
-    fixed_t	b)
-{
-    return ((long long)a * (long long)b) >> FRACBITS;
-}
-
-
-fixed_t FixedDiv2(fixed_t a, fixed_t b)
-{
-#if 0
-    long long c;
-    c = ((long long)a << 16) / ((long long)b);
-    return (fixed_t)c;
-#endif
-
-    double c;
-
-    c = ((double)a) / ((double)b) * FRACUNIT;
-
-    if (c >= 2147483648.0 || c < -2147483648.0)
-        I_Error("FixedDiv: divide by zero");
-    return (fixed_t)c;
-}
-
-// FixedDiv, C version.
-fixed_t FixedDiv(fixed_t a, fixed_t b)
+void FixedDivOverflow()
 {
-    if ((std::abs(a) >> 14) >= std::abs(b))
-        return (a ^ b) < 0 ? std::numeric_limits<fixed_t>::min() : std::numeric_limits<fixed_t>::max();
-
-    return FixedDiv2(a, b);
+    I_Error("FixedDiv: divide by zero");
 }
@@ -17,11 +17,73 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+import std;
+import nstd;
+
 // Fixed point, 32bit as 16.16.
 #define FRACBITS		16
 #define FRACUNIT		(1<<FRACBITS)
 
 typedef int fixed_t;
 
-fixed_t FixedMul(fixed_t a, fixed_t b);
-fixed_t FixedDiv(fixed_t a, fixed_t b);
+// The one quotient FixedDiv neither saturates nor can hold, the most
+// negative fixed_t over a tiny divisor. I_Errors, like it always did.
+[[noreturn]] void FixedDivOverflow();
+
+// Both are here and constexpr so they inline into the renderer and
+// playsim loops. The results are bit for bit what the old out of line
+// versions gave, FixedDiv included: it used to divide in double, but
+// truncating the exact integer quotient lands on the same value.
+constexpr fixed_t FixedMul(fixed_t a, fixed_t b)
+{
+    return static_cast<fixed_t>((static_cast<int64>(a) * b) >> FRACBITS);
+}
+
+constexpr fixed_t FixedDiv(fixed_t a, fixed_t b)
+{
+    // std::abs of the most negative fixed_t stays negative, and
+    // that has to keep going the same way through the check below.
+    auto wrapping_abs = [](fixed_t n){ return n < 0 ? static_cast<fixed_t>(0u - static_cast<uint32>(n)) : n; };
+
+    if ((wrapping_abs(a) >> 14) >= wrapping_abs(b))
+        return (a ^ b) < 0 ? std::numeric_limits<fixed_t>::min() : std::numeric_limits<fixed_t>::max();
+
+    // only the most negative a gets past the check with b 0
+    if (b == 0)
+        FixedDivOverflow();
+
+    auto c = (static_cast<int64>(a) << FRACBITS) / b;
+    if (c > std::numeric_limits<fixed_t>::max() || c < std::numeric_limits<fixed_t>::min())
+        FixedDivOverflow();
+
+    return static_cast<fixed_t>(c);
+}
+
+// A fixed_t with the arithmetic as operators, for new code. Same math
+// as the functions above, overflow and saturation included.
+struct fixed
+{
+    fixed_t raw = 0;
+
+    static constexpr fixed from_int(int32 n) { return {n << FRACBITS}; }
+    constexpr int32 to_int() const { return raw >> FRACBITS; }
+
+    constexpr fixed operator-() const { return {static_cast<fixed_t>(0u - static_cast<uint32>(raw))}; }
+    constexpr fixed operator+(fixed b) const { return {static_cast<fixed_t>(static_cast<uint32>(raw) + static_cast<uint32>(b.raw))}; }
+    constexpr fixed operator-(fixed b) const { return {static_cast<fixed_t>(static_cast<uint32>(raw) - static_cast<uint32>(b.raw))}; }
+    constexpr fixed operator*(fixed b) const { return {FixedMul(raw, b.raw)}; }
+    constexpr fixed operator/(fixed b) const { return {FixedDiv(raw, b.raw)}; }
+
+    constexpr fixed& operator+=(fixed b) { return *this = *this + b; }
+    constexpr fixed& operator-=(fixed b) { return *this = *this - b; }
+    constexpr fixed& operator*=(fixed b) { return *this = *this * b; }
+    constexpr fixed& operator/=(fixed b) { return *this = *this / b; }
+
+    constexpr auto operator<=>(const fixed&) const = default;
+};
+
+static_assert(FixedMul(3 * FRACUNIT, FRACUNIT / 2) == 3 * FRACUNIT / 2);
+static_assert(FixedDiv(FRACUNIT, 3 * FRACUNIT) == FRACUNIT / 3);
+static_assert(FixedDiv(FRACUNIT, 0) == std::numeric_limits<fixed_t>::max());
+static_assert(FixedDiv(-FRACUNIT, 0) == std::numeric_limits<fixed_t>::min());
+static_assert((fixed::from_int(6) / fixed::from_int(-4)).raw == -3 * FRACUNIT / 2);
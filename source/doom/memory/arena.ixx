@@ -0,0 +1,98 @@
+export module arena;
+
+import std;
+import nstd;
+
+export {
+
+// Storage for things built up and thrown away every frame (or every trace), drawsegs,
+// vissprites, visplanes and intercepts. The users keep their own end pointer into data() and
+// reset it to the start each frame, so the capacity, once grown, stays for the frames after
+// and nothing is allocated per frame. When the end pointer reaches capacity, grow() doubles
+// the storage and moves every pointer handed to it along with the contents.
+template<typename T>
+class frame_arena
+{
+public:
+    explicit frame_arena(int32 capacity) : items(capacity) {}
+
+    frame_arena(const frame_arena&) = delete;
+    frame_arena& operator=(const frame_arena&) = delete;
+
+    T* data() { return items.data(); }
+    const T* data() const { return items.data(); }
+    T* end() { return items.data() + items.size(); }
+
+    int32 capacity() const { return items.size(); }
+
+    T& operator[](int32 index) { return items[index]; }
+
+    // Pointers that aren't into the arena (nullptr, or a stand-in object) are left alone.
+    void grow(auto*&... pointers)
+    {
+        auto* oldBegin = items.data();
+        auto* oldEnd = oldBegin + items.size();
+
+        vector<T> bigger(items.size() * 2);
+        std::move(items.begin(), items.end(), bigger.begin());
+        items.swap(bigger);
+
+        auto rebase = [&](auto*& pointer)
+        {
+            std::less_equal<> le;
+            if (pointer && le(oldBegin, pointer) && le(pointer, oldEnd))
+                pointer = items.data() + (pointer - oldBegin);
+        };
+        (rebase(pointers), ...);
+    }
+
+private:
+    vector<T> items;
+};
+
+// Hands out runs of T that stay where they are until reset(), for things that are pointed at
+// while the arena is still filling up. The storage comes in fixed size blocks that are kept for
+// the frames after, so reset() just rewinds to the first block.
+template<typename T>
+class block_arena
+{
+public:
+    explicit block_arena(int32 blockSize) : blockSize{blockSize} {}
+
+    block_arena(const block_arena&) = delete;
+    block_arena& operator=(const block_arena&) = delete;
+
+    // count has to fit in a block.
+    T* allocate(int32 count)
+    {
+        if (used + count > blockSize)
+        {
+            ++current;
+            used = 0;
+        }
+
+        if (current == blocks.size())
+            blocks.push_back(std::make_unique<T[]>(blockSize));
+
+        auto* run = blocks[current].get() + used;
+        used += count;
+        return run;
+    }
+
+    void reset()
+    {
+        current = 0;
+        used = 0;
+    }
+
+    // Handed out since reset(), with the ends of the blocks skipped.
+    int32 size() const { return current * blockSize + used; }
+
+private:
+    vector<std::unique_ptr<T[]>> blocks;
+    int32 blockSize;
+    int32 current = 0;
+    int32 used = 0;
+};
+
+} // export
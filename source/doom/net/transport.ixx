@@ -0,0 +1,221 @@
+export module net;
+
+import std;
+import nstd;
+
+export namespace net {
+
+// Room for the biggest packet the game sends, a doomdata_t with BACKUPTICS ticcmds.
+constexpr int32 MaxDatagram = 512;
+
+struct datagram
+{
+    // The node it goes to when sent, the node it came from when received.
+    int32 node = 0;
+    int32 length = 0;
+    alignas(8) std::array<byte, MaxDatagram> data;
+};
+
+// Moves datagrams between this node and the others in batches. A send is written in place into
+// the next slot of the outgoing batch and the whole batch goes out at flush(), so a transport
+// that can hand the system several datagrams in one call (sendmmsg) does, and nothing is copied
+// on the way there. Receiving takes everything waiting in one go (recvmmsg) and hands it out one
+// datagram at a time.
+class transport
+{
+public:
+    explicit transport(int32 batchSize = 64) : outgoing(batchSize), incoming(batchSize) {}
+    virtual ~transport() = default;
+
+    transport(const transport&) = delete;
+    transport& operator=(const transport&) = delete;
+
+    // The slot for the next datagram to node, for the caller to fill in. A full batch is
+    // flushed first.
+    datagram& prepare(int32 node)
+    {
+        if (queued == outgoing.size())
+            flush();
+
+        auto& slot = outgoing[queued++];
+        slot.node = node;
+        slot.length = 0;
+        return slot;
+    }
+
+    void flush()
+    {
+        if (queued > 0)
+            send_batch({outgoing.data(), static_cast<size_t>(queued)});
+        queued = 0;
+    }
+
+    // The next datagram that came in, good until the next call, or nullptr if nothing is
+    // waiting.
+    const datagram* receive()
+    {
+        if (next == received)
+        {
+            next = 0;
+            received = receive_batch({incoming.data(), static_cast<size_t>(incoming.size())});
+            if (received == 0)
+                return nullptr;
+        }
+
+        return &incoming[next++];
+    }
+
+protected:
+    virtual void send_batch(std::span<const datagram> batch) = 0;
+
+    // Fills in as many of batch as there are datagrams waiting, returns how many.
+    virtual int32 receive_batch(std::span<datagram> batch) = 0;
+
+private:
+    vector<datagram> outgoing;
+    int32 queued = 0;
+
+    vector<datagram> incoming;
+    int32 received = 0;
+    int32 next = 0;
+};
+
+// The link between any two endpoints of a loopback network, the same both ways.
+struct link_conditions
+{
+    std::chrono::microseconds latency{};
+
+    // Up to this much more latency, picked at random for every datagram, so datagrams can
+    // overtake each other.
+    std::chrono::microseconds jitter{};
+
+    // Percentage of datagrams dropped.
+    int32 loss = 0;
+
+    uint32 seed = 1;
+};
+
+// A network of endpoints inside one process, for running and timing netgames without sockets.
+// Endpoint n sees the others as though it was started with -net n+1 and the addresses of all
+// the others in order: its node 0 is itself and its other nodes are the other endpoints, in
+// order. Everything happens on the thread calling the endpoints, there are no locks.
+class loopback
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct statistics
+    {
+        int64 sent = 0;
+        int64 lost = 0;
+        int64 delivered = 0;
+        int64 batches = 0;
+        clock::duration latency{}; // summed over the datagrams delivered
+    };
+
+    loopback(int32 endpoints, const link_conditions& conditions, int32 batchSize = 64)
+        : conditions{conditions}, random{conditions.seed}, queues(endpoints)
+    {
+        for (int32 n = 0; n < endpoints; ++n)
+            ports.push_back(std::make_unique<port>(*this, n, batchSize));
+    }
+
+    loopback(const loopback&) = delete;
+    loopback& operator=(const loopback&) = delete;
+
+    int32 size() const { return ports.size(); }
+    transport& endpoint(int32 index) { return *ports[index]; }
+
+    // Datagrams are sent and delivered at clock::now(), or at the time set here for runs that
+    // step time along themselves.
+    void set_time(clock::time_point time) { fixedTime = time; }
+
+    const statistics& stats() const { return totals; }
+
+private:
+    class port : public transport
+    {
+    public:
+        port(loopback& network, int32 index, int32 batchSize) : transport{batchSize}, network{network}, index{index} {}
+
+    protected:
+        void send_batch(std::span<const datagram> batch) override { network.post(index, batch); }
+        int32 receive_batch(std::span<datagram> batch) override { return network.collect(index, batch); }
+
+    private:
+        loopback& network;
+        int32 index;
+    };
+
+    struct in_flight
+    {
+        clock::time_point due;
+        clock::time_point sent;
+        uint64 sequence;
+        datagram packet;
+    };
+
+    // For the heaps, the first due (and of those the first sent) on top.
+    static bool later(const in_flight& a, const in_flight& b)
+    {
+        return a.due != b.due ? a.due > b.due : a.sequence > b.sequence;
+    }
+
+    clock::time_point now() const { return fixedTime ? *fixedTime : clock::now(); }
+
+    void post(int32 from, std::span<const datagram> batch)
+    {
+        auto time = now();
+        ++totals.batches;
+        for (auto& packet : batch)
+        {
+            ++totals.sent;
+            if (static_cast<int32>(random() % 100) < conditions.loss)
+            {
+                ++totals.lost;
+                continue;
+            }
+
+            // Node numbers are as the sender sees them, and become the sender as the receiver
+            // sees it.
+            auto to = packet.node == 0 ? from : packet.node <= from ? packet.node - 1 : packet.node;
+            auto delay = conditions.latency;
+            if (conditions.jitter.count() > 0)
+                delay += std::chrono::microseconds{random() % (conditions.jitter.count() + 1)};
+
+            auto& queue = queues[to];
+            queue.push_back({time + delay, time, sequence++, packet});
+            queue.back().packet.node = from == to ? 0 : from < to ? from + 1 : from;
+            std::push_heap(queue.begin(), queue.end(), later);
+        }
+    }
+
+    int32 collect(int32 to, std::span<datagram> batch)
+    {
+        auto time = now();
+        auto& queue = queues[to];
+        int32 count = 0;
+        while (count < static_cast<int32>(batch.size()) && !queue.empty() && queue.front().due <= time)
+        {
+            std::pop_heap(queue.begin(), queue.end(), later);
+            auto& arrived = queue.back();
+            batch[count++] = arrived.packet;
+            totals.latency += time - arrived.sent;
+            queue.pop_back();
+        }
+
+        totals.delivered += count;
+        return count;
+    }
+
+    link_conditions conditions;
+    std::minstd_rand random;
+    std::optional<clock::time_point> fixedTime;
+    uint64 sequence = 0;
+    statistics totals;
+
+    vector<std::unique_ptr<port>> ports;
+    vector<vector<in_flight>> queues;
+};
+
+} // export namespace net
@@ -179,7 +179,7 @@ EV_DoCeiling
 
         // new door thinker
         rtn = 1;
-        auto ceiling = Z_Malloc<ceiling_t>(sizeof(ceiling_t), PU_LEVSPEC, 0);
+        auto ceiling = P_NewThinker<ceiling_t>();
         P_AddThinker(&ceiling->thinker);
         sec->specialdata = ceiling;
         ceiling->thinker.function.acp1 = (actionf_p1)T_MoveCeiling;
@@ -269,7 +269,7 @@ EV_DoDoor
 
         // new door thinker
         rtn = 1;
-        auto door = Z_Malloc<vldoor_t>(sizeof(vldoor_t), PU_LEVSPEC, 0);
+        auto door = P_NewThinker<vldoor_t>();
         P_AddThinker(&door->thinker);
         sec->specialdata = door;
 
@@ -430,7 +430,7 @@ void EV_VerticalDoor(line_t* line, mobj_t* thing)
 
 
     // new door thinker
-    auto door = Z_Malloc<vldoor_t>(sizeof(vldoor_t), PU_LEVSPEC, 0);
+    auto door = P_NewThinker<vldoor_t>();
     P_AddThinker(&door->thinker);
     sec->specialdata = door;
     door->thinker.function.acp1 = (actionf_p1)T_VerticalDoor;
@@ -478,7 +478,7 @@ void EV_VerticalDoor(line_t* line, mobj_t* thing)
 //
 void P_SpawnDoorCloseIn30(sector_t* sec)
 {
-    auto door = Z_Malloc<vldoor_t>(sizeof(vldoor_t), PU_LEVSPEC, 0);
+    auto door = P_NewThinker<vldoor_t>();
 
     P_AddThinker(&door->thinker);
 
@@ -498,7 +498,7 @@ void P_SpawnDoorCloseIn30(sector_t* sec)
 //
 void P_SpawnDoorRaiseIn5Mins(sector_t* sec, [[maybe_unused]] int secnum)
 {
-    auto door = Z_Malloc<vldoor_t>(sizeof(vldoor_t), PU_LEVSPEC, 0);
+    auto door = P_NewThinker<vldoor_t>();
 
     P_AddThinker(&door->thinker);
 
@@ -258,7 +258,7 @@ EV_DoFloor
 
         // new floor thinker
         rtn = 1;
-        auto floor = Z_Malloc<floormove_t>(sizeof(floormove_t), PU_LEVSPEC, 0);
+        auto floor = P_NewThinker<floormove_t>();
         P_AddThinker(&floor->thinker);
         sec->specialdata = floor;
         floor->thinker.function.acp1 = (actionf_p1)T_MoveFloor;
@@ -459,7 +459,7 @@ EV_BuildStairs
 
         // new floor thinker
         rtn = 1;
-        auto floor = Z_Malloc<floormove_t>(sizeof(floormove_t), PU_LEVSPEC, 0);
+        auto floor = P_NewThinker<floormove_t>();
         P_AddThinker(&floor->thinker);
         sec->specialdata = floor;
         floor->thinker.function.acp1 = (actionf_p1)T_MoveFloor;
@@ -513,7 +513,7 @@ EV_BuildStairs
 
                 sec = tsec;
                 secnum = newsecnum;
-                floor = Z_Malloc<floormove_t>(sizeof(floormove_t), PU_LEVSPEC, 0);
+                floor = P_NewThinker<floormove_t>();
 
                 P_AddThinker(&floor->thinker);
 
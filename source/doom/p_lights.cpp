@@ -52,7 +52,7 @@ void P_SpawnFireFlicker(sector_t* sector)
     // Nothing special about it during gameplay.
     sector->special = 0;
 
-    auto flick = Z_Malloc<fireflicker_t>(sizeof(fireflicker_t), PU_LEVSPEC, 0);
+    auto flick = P_NewThinker<fireflicker_t>();
 
     P_AddThinker(&flick->thinker);
 
@@ -105,7 +105,7 @@ void P_SpawnLightFlash(sector_t* sector)
     // nothing special about it during gameplay
     sector->special = 0;
 
-    auto flash = Z_Malloc<lightflash_t>(sizeof(lightflash_t), PU_LEVSPEC, 0);
+    auto flash = P_NewThinker<lightflash_t>();
 
     P_AddThinker(&flash->thinker);
 
@@ -160,7 +160,7 @@ P_SpawnStrobeFlash
     int		fastOrSlow,
     int		inSync)
 {
-    auto flash = Z_Malloc<strobe_t>(sizeof(strobe_t), PU_LEVSPEC, 0);
+    auto flash = P_NewThinker<strobe_t>();
 
     P_AddThinker(&flash->thinker);
 
@@ -314,7 +314,7 @@ void T_Glow(glow_t* g)
 
 void P_SpawnGlowingLight(sector_t* sector)
 {
-    auto g = Z_Malloc<glow_t>(sizeof(glow_t), PU_LEVSPEC, 0);
+    auto g = P_NewThinker<glow_t>();
 
     P_AddThinker(&g->thinker);
 
@@ -18,6 +18,7 @@
 #pragma once
 
 import std;
+import arena;
 
 #include "r_local.h"
 
@@ -74,6 +75,36 @@ void P_InitThinkers();
 void P_AddThinker(thinker_t* thinker);
 void P_RemoveThinker(thinker_t* thinker);
 
+// Thinkers are carved out of per-type pools of level lifetime slabs
+// instead of one zone block each, so the mobjs a tic walks over sit
+// next to each other. P_ClearThinkerPools forgets the slabs once
+// Z_FreeTags has released them.
+int32 P_RegisterThinkerPool(int32 size);
+void* P_AllocThinker(int32 pool);
+void P_FreeThinker(thinker_t* thinker);
+void P_ReuseFreedThinkers();
+void P_ClearThinkerPools();
+
+// The pool a thinker came from, which tells what type it is even once
+// it has been removed and its function no longer does.
+int32 P_ThinkerPool(const thinker_t* thinker);
+
+// Where -uncapped draws things from between tics, see p_tick.cpp.
+void P_ResetInterpolation();
+
+template<typename T>
+int32 P_ThinkerPoolFor()
+{
+    static const int32 pool = P_RegisterThinkerPool(sizeof(T));
+    return pool;
+}
+
+template<typename T>
+T* P_NewThinker()
+{
+    return static_cast<T*>(P_AllocThinker(P_ThinkerPoolFor<T>()));
+}
+
 
 //
 // P_PSPR
@@ -152,9 +183,10 @@ typedef struct
     }			d;
 } intercept_t;
 
+// Starting capacity, the intercept arena grows past it.
 #define MAXINTERCEPTS	128
 
-extern intercept_t	intercepts[MAXINTERCEPTS];
+extern frame_arena<intercept_t> intercepts;
 extern intercept_t* intercept_p;
 
 typedef bool(*traverser_t) (intercept_t* in);
@@ -206,6 +238,11 @@ bool P_TryMove(mobj_t* thing, fixed_t x, fixed_t y);
 bool P_TeleportMove(mobj_t* thing, fixed_t x, fixed_t y);
 void	P_SlideMove(mobj_t* mo);
 bool P_CheckSight(mobj_t* t1, mobj_t* t2);
+
+// -sightcache remembers P_CheckSight answers for the rest of the tic.
+extern bool	sightcache;
+void P_ClearSightCache();
+void P_NewSightTic();
 void 	P_UseLines(player_t* player);
 
 bool P_ChangeSector(sector_t* sector, bool crunch);
@@ -1230,6 +1230,9 @@ bool P_ChangeSector(sector_t* sector, bool crunch)
     nofit = false;
     crushchange = crunch;
 
+    // the planes that block sight just moved
+    P_ClearSightCache();
+
     // re-check heights for all things near the moving sector
     for (int32 x = sector->blockbox.left; x <= sector->blockbox.right; x++)
         for (int32 y = sector->blockbox.bottom;y <= sector->blockbox.top; y++)
@@ -25,6 +25,8 @@
 #include "r_main.h"
 
 import std;
+import bench;
+import traverse;
 
 
 // Gives an estimation of distance (not exact)
@@ -486,7 +488,7 @@ bool P_BlockThingsIterator(int x, int y, bool(*func)(mobj_t*))
 
 // INTERCEPT ROUTINES
 
-intercept_t	intercepts[MAXINTERCEPTS];
+frame_arena<intercept_t> intercepts{MAXINTERCEPTS};
 intercept_t* intercept_p;
 
 divline_t 	trace;
@@ -534,6 +536,9 @@ bool PIT_AddLineIntercepts(line_t* ld)
     if (earlyout && frac < FRACUNIT && !ld->backsector)
         return false;	// stop checking
 
+    if (intercept_p == intercepts.end())
+        intercepts.grow(intercept_p);
+
     intercept_p->frac = frac;
     intercept_p->isaline = true;
     intercept_p->d.line = ld;
@@ -592,6 +597,9 @@ bool PIT_AddThingIntercepts(mobj_t* thing)
     if (frac < 0)
         return true;		// behind source
 
+    if (intercept_p == intercepts.end())
+        intercepts.grow(intercept_p);
+
     intercept_p->frac = frac;
     intercept_p->isaline = false;
     intercept_p->d.thing = thing;
@@ -600,51 +608,16 @@ bool PIT_AddThingIntercepts(mobj_t* thing)
     return true;		// keep going
 }
 
+// Scratch for TraverseInOrder, kept so it stops allocating once it's big enough.
+static vector<uint64> interceptheap;
+
 // Returns true if the traverser function returns true for all lines.
 bool P_TraverseIntercepts(traverser_t func, fixed_t maxfrac)
 {
-    fixed_t		dist;
-    intercept_t* scan;
-    intercept_t* in;
-
-    intptr_t count = intercept_p - intercepts;
-
-    in = 0;			// shut up compiler warning
-
-    while (count--)
-    {
-        dist = std::numeric_limits<fixed_t>::max();
-        for (scan = intercepts; scan < intercept_p; scan++)
-        {
-            if (scan->frac < dist)
-            {
-                dist = scan->frac;
-                in = scan;
-            }
-        }
-
-        if (dist > maxfrac)
-            return true;	// checked everything in range		
-
-#if 0  // UNUSED
-        {
-            // don't check these yet, there may be others inserted
-            in = scan = intercepts;
-            for (scan = intercepts; scan < intercept_p; scan++)
-                if (scan->frac > maxfrac)
-                    *in++ = *scan;
-            intercept_p = in;
-            return false;
-        }
-#endif
-
-        if (!func(in))
-            return false;	// don't bother going farther
-
-        in->frac = std::numeric_limits<decltype(in->frac)>::max();
-    }
+    bench::peak("intercepts", intercept_p - intercepts.data());
 
-    return true;		// everything was traversed
+    // Same order as the old nearest-first rescan, ties included, so demos stay in sync.
+    return TraverseInOrder(intercepts.data(), intercept_p, maxfrac, interceptheap, func);
 }
 
 // Traces a line from x1,y1 to x2,y2, calling the traverser function for each.
@@ -675,7 +648,7 @@ bool P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2, int flags, b
     earlyout = flags & PT_EARLYOUT;
 
     validcount++;
-    intercept_p = intercepts;
+    intercept_p = intercepts.data();
 
     if (((x1 - bmaporgx) & (MAPBLOCKSIZE - 1)) == 0)
         x1 += FRACUNIT;	// don't side exactly on a line
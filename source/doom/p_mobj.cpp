@@ -456,7 +456,7 @@ mobj_t* P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
     state_t* st;
     mobjinfo_t* info;
 
-    auto mobj = Z_Malloc<mobj_t>(sizeof(mobj_t), PU_LEVEL, nullptr);
+    auto mobj = P_NewThinker<mobj_t>();
     std::memset(mobj, 0, sizeof(*mobj));
     info = &mobjinfo[type];
 
@@ -495,6 +495,7 @@ mobj_t* P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
     else
         mobj->z = z;
 
+    mobj->ResetInterpolation();
     mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
 
     P_AddThinker(&mobj->thinker);
@@ -948,17 +949,3 @@ P_SpawnPlayerMissile
 
     P_CheckMissileSpawn(th);
 }
-
-byte* mobj_t::GetSaveData() const
-{
-	auto* out = new mobj_t;
-    std::memcpy(out, this, sizeof(mobj_t));
-
-	if (out->state)
-		*reinterpret_cast<intptr_t*>(out->state) = out->state - states;
-
-	if (out->player)
-		*reinterpret_cast<intptr_t*>(out->player) = (out->player - players) + 1;
-
-	return reinterpret_cast<byte*>(out);
-}
@@ -270,5 +270,18 @@ struct mobj_t
     // Thing being chased/attacked for tracers.
     mobj_t* tracer;
 
-    byte* GetSaveData() const;
+    // Where it was before this tic, -uncapped draws it in between.
+    fixed_t		oldx;
+    fixed_t		oldy;
+    fixed_t		oldz;
+    angle_t		oldangle;
+
+    // For spawns and teleports, which aren't seen moving there.
+    void ResetInterpolation()
+    {
+        oldx = x;
+        oldy = y;
+        oldz = z;
+        oldangle = angle;
+    }
 };
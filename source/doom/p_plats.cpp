@@ -147,7 +147,7 @@ EV_DoPlat
 
         // Find lowest & highest floors around sector
         rtn = 1;
-        auto plat = Z_Malloc<plat_t>(sizeof(plat_t), PU_LEVSPEC, 0);
+        auto plat = P_NewThinker<plat_t>();
         P_AddThinker(&plat->thinker);
 
         plat->type = type;
@@ -12,7 +12,8 @@
 // for more details.
 //
 // DESCRIPTION:
-//	Archiving: SaveGame I/O.
+//	Archiving: snapshots of the play simulation, and the savegames
+//	made of them.
 //
 //-----------------------------------------------------------------------------
 import std;
@@ -20,364 +21,725 @@ import std;
 import nstd;
 
 #include "i_system.h"
-#include "z_zone.h"
+#include "d_main.h"
 #include "p_local.h"
 #include "doomstat.h"
 #include "r_state.h"
 #include "p_saveg.h"
 
-void P_ArchivePlayers(std::ofstream& outFile)
+extern int prndindex;
+
+extern mobj_t* braintargets[32];
+extern int numbraintargets;
+extern int braintargeton;
+
+namespace
 {
-    for (int32 i = 0; i < MAXPLAYERS; ++i)
-    {
-        if (!playeringame[i])
-            continue;
 
-        nstd::align(4, outFile);
+// "DSNP", at the start of a snapshot and again at its end.
+constexpr uint32 SNAPSHOTMAGIC = 0x504e5344;
 
-        auto* player = players[i].GetSaveData();
-        outFile.write(reinterpret_cast<char*>(player), sizeof(player_t));
-        delete player;
-    }
+// What a thinker is, told by the pool it came from.
+enum class SaveThinker : uint8
+{
+    MapObject,
+    Ceiling,
+    Door,
+    Floor,
+    Plat,
+    Flash,
+    Strobe,
+    Glow,
+    FireFlicker,
+    Count
+};
+
+// What its function was: its type's, none for the plats and ceilings
+// in stasis, or removed and waiting for its turn to be freed.
+enum class SaveThinkerState : uint8
+{
+    Thinking,
+    Stasis,
+    Removed
+};
+
+// Thinker pointers to snapshot indices while saving, an open
+// addressed table with room for twice the thinkers, and indices to
+// the new thinkers while loading. Kept from one snapshot to the next
+// so they're only allocated once.
+vector<std::pair<const void*, int32>> thinkerindices;
+vector<thinker_t*> thinkertable;
+vector<SaveThinker> thinkerclasses;
+
+uint32 ThinkerSlot(const void* thinker)
+{
+    auto hash = (reinterpret_cast<uintptr_t>(thinker) >> 4) * 0x9e3779b97f4a7c15ull;
+    return static_cast<uint32>(hash >> 32) & (thinkerindices.size() - 1);
 }
 
-void P_UnArchivePlayers(std::ifstream& inFile)
+void NumberThinkers(int32 count)
 {
-    for (int32 i = 0; i < MAXPLAYERS; ++i)
-    {
-        if (!playeringame[i])
-            continue;
-
-        auto* player = &players[i];
+    thinkerindices.assign(std::bit_ceil(static_cast<uint32>(count) * 2 + 2), {nullptr, -1});
 
-        nstd::align(4, inFile);
-        inFile.read(reinterpret_cast<char*>(player), sizeof(player_t));
+    int32 n = 0;
+    for (auto* th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        auto slot = ThinkerSlot(th);
+        while (thinkerindices[slot].first)
+            slot = (slot + 1) & (thinkerindices.size() - 1);
+        thinkerindices[slot] = {th, n++};
+    }
+}
 
-        // will be set when unarc thinker
-        player->mo = nullptr;
-        player->message.clear();
-        player->attacker = nullptr;
+// -1 for nullptr and for a thinker that has been freed.
+int32 ThinkerIndex(const void* thinker)
+{
+    if (!thinker)
+        return -1;
 
-        for (int32 j = 0; j < NUMPSPRITES; j++)
-        {
-            if (player->psprites[j].state)
-            {
-                player->psprites[j].state = states + reinterpret_cast<intptr_t>(player->psprites[j].state);
-            }
-        }
+    for (auto slot = ThinkerSlot(thinker); thinkerindices[slot].first; slot = (slot + 1) & (thinkerindices.size() - 1))
+    {
+        if (thinkerindices[slot].first == thinker)
+            return thinkerindices[slot].second;
     }
+    return -1;
 }
 
-void P_ArchiveWorld(std::ofstream& outFile)
+class snapshotwriter
 {
-    // do sectors
-    auto* sector = sectors;
-    for (int32 i = 0; i < numsectors; ++i, ++sector)
+public:
+    static constexpr bool loading = false;
+
+    explicit snapshotwriter(vector<byte>& buffer) : buffer{buffer}, used{static_cast<size_t>(buffer.size())} {}
+
+    template<typename T>
+    void operator()(const T& value)
     {
-        outFile << static_cast<int16>(sector->floorheight >> FRACBITS);
-        outFile << static_cast<int16>(sector->ceilingheight >> FRACBITS);
-        outFile << sector->floorpic;
-        outFile << sector->ceilingpic;
-        outFile << sector->lightlevel;
-        outFile << sector->special;		// needed?
-        outFile << sector->tag;		// needed?
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (used + sizeof(T) > static_cast<size_t>(buffer.size()))
+            buffer.resize(std::max<size_t>(buffer.size() * 2, used + 64 * 1024));
+
+        std::memcpy(buffer.data() + used, &value, sizeof(T));
+        used += sizeof(T);
     }
 
-    // do lines
-    for (int32 i = 0; i < numlines; ++i)
+    template<typename T>
+    void thinker(T* const& object)
     {
-        auto* line = lines + i;
-        outFile
-            << line->flags
-            << line->special
-            << line->tag;
-
-        for (int32 j = 0; j < 2; ++j)
-        {
-            if (line->sidenum[j] == -1)
-                continue;
-
-            auto* side = sides + line->sidenum[j];
-            outFile
-                << static_cast<int16>(side->textureoffset >> FRACBITS)
-                << static_cast<int16>(side->rowoffset >> FRACBITS)
-                << side->toptexture
-                << side->bottomtexture
-                << side->midtexture;
-        }
+        (*this)(ThinkerIndex(object));
     }
-}
 
-void P_UnArchiveWorld(std::ifstream& inFile)
-{
-    // do sectors
-    for (int32 i = 0; i < numsectors; ++i)
+    template<typename T>
+    void index(T* const& object, T* base, [[maybe_unused]] int32 count)
     {
-        auto* sector = sectors + i;
+        (*this)(object ? static_cast<int32>(object - base) : -1);
+    }
 
-        sector->floorheight = 0;
-        inFile.read(reinterpret_cast<char*>(&sector->floorheight), 2);
-        sector->floorheight <<= FRACBITS;
+    // Trims the buffer to what was written.
+    void finish() { buffer.resize(used); }
 
-        sector->ceilingheight = 0;
-        inFile.read(reinterpret_cast<char*>(&sector->ceilingheight), 2);
-        sector->ceilingheight <<= FRACBITS;
+private:
+    vector<byte>& buffer;
+    size_t used;
+};
 
-        inFile.read(reinterpret_cast<char*>(&sector->floorpic), 2);
-        inFile.read(reinterpret_cast<char*>(&sector->ceilingpic), 2);
-        inFile.read(reinterpret_cast<char*>(&sector->lightlevel), 2);
-        inFile.read(reinterpret_cast<char*>(&sector->special), 2);
-        inFile.read(reinterpret_cast<char*>(&sector->tag), 2);
+class snapshotreader
+{
+public:
+    static constexpr bool loading = true;
 
-        sector->specialdata = nullptr;
-        sector->soundtarget = nullptr;
-    }
+    explicit snapshotreader(std::span<const byte> snapshot) : data{snapshot} {}
 
-    // do lines
-    for (int32 i = 0; i < numlines; ++i)
+    template<typename T>
+    void operator()(T& value)
     {
-        auto* line = lines + i;
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (next + sizeof(T) > data.size())
+            I_Error("P_LoadSnapshot: snapshot is cut short");
 
-        inFile.read(reinterpret_cast<char*>(&line->flags), 2);
-        inFile.read(reinterpret_cast<char*>(&line->special), 2);
-        inFile.read(reinterpret_cast<char*>(&line->tag), 2);
+        std::memcpy(&value, data.data() + next, sizeof(T));
+        next += sizeof(T);
+    }
 
-        for (int32 j = 0; j < 2; ++j)
+    // A mobj pointer has to be to a mobj, and any other to a thinker
+    // that isn't one.
+    template<typename T>
+    void thinker(T*& object)
+    {
+        int32 n = 0;
+        (*this)(n);
+        if (n == -1)
         {
-            if (line->sidenum[j] == -1)
-                continue;
+            object = nullptr;
+            return;
+        }
 
-            auto* side = sides + line->sidenum[j];
+        if (n < 0 || n >= thinkertable.size() || std::is_same_v<T, mobj_t> != (thinkerclasses[n] == SaveThinker::MapObject))
+            I_Error("P_LoadSnapshot: bad thinker {}", n);
+        object = reinterpret_cast<T*>(thinkertable[n]);
+    }
 
-            side->textureoffset = 0;
-            inFile.read(reinterpret_cast<char*>(&side->textureoffset), 2);
-            side->textureoffset <<= FRACBITS;
+    template<typename T>
+    void index(T*& object, T* base, int32 count)
+    {
+        int32 n = 0;
+        (*this)(n);
+        if (n < -1 || n >= count)
+            I_Error("P_LoadSnapshot: bad index {} of {}", n, count);
+        object = n < 0 ? nullptr : base + n;
+    }
 
-            side->rowoffset = 0;
-            inFile.read(reinterpret_cast<char*>(&side->rowoffset), 2);
-            side->rowoffset <<= FRACBITS;
+private:
+    std::span<const byte> data;
+    size_t next = 0;
+};
 
-            inFile.read(reinterpret_cast<char*>(&side->toptexture), 2);
-            inFile.read(reinterpret_cast<char*>(&side->bottomtexture), 2);
-            inFile.read(reinterpret_cast<char*>(&side->midtexture), 2);
-        }
+SaveThinker ThinkerClass(const thinker_t* thinker)
+{
+    auto pool = P_ThinkerPool(thinker);
+    if (pool == P_ThinkerPoolFor<mobj_t>())
+        return SaveThinker::MapObject;
+    if (pool == P_ThinkerPoolFor<ceiling_t>())
+        return SaveThinker::Ceiling;
+    if (pool == P_ThinkerPoolFor<vldoor_t>())
+        return SaveThinker::Door;
+    if (pool == P_ThinkerPoolFor<floormove_t>())
+        return SaveThinker::Floor;
+    if (pool == P_ThinkerPoolFor<plat_t>())
+        return SaveThinker::Plat;
+    if (pool == P_ThinkerPoolFor<lightflash_t>())
+        return SaveThinker::Flash;
+    if (pool == P_ThinkerPoolFor<strobe_t>())
+        return SaveThinker::Strobe;
+    if (pool == P_ThinkerPoolFor<glow_t>())
+        return SaveThinker::Glow;
+    if (pool == P_ThinkerPoolFor<fireflicker_t>())
+        return SaveThinker::FireFlicker;
+
+    I_Error("P_SaveSnapshot: unknown thinker pool {}", pool);
+    return SaveThinker::Count;
+}
+
+actionf_p1 ThinkerFunction(SaveThinker type)
+{
+    switch (type)
+    {
+    case SaveThinker::MapObject: return (actionf_p1)P_MobjThinker;
+    case SaveThinker::Ceiling: return (actionf_p1)T_MoveCeiling;
+    case SaveThinker::Door: return (actionf_p1)T_VerticalDoor;
+    case SaveThinker::Floor: return (actionf_p1)T_MoveFloor;
+    case SaveThinker::Plat: return (actionf_p1)T_PlatRaise;
+    case SaveThinker::Flash: return (actionf_p1)T_LightFlash;
+    case SaveThinker::Strobe: return (actionf_p1)T_StrobeFlash;
+    case SaveThinker::Glow: return (actionf_p1)T_Glow;
+    case SaveThinker::FireFlicker: return (actionf_p1)T_FireFlicker;
+    default: break;
     }
+
+    I_Error("P_LoadSnapshot: unknown thinker class {}", nstd::to_underlying(type));
+    return nullptr;
 }
 
-// Thinkers
+template<typename T>
+thinker_t* NewThinker()
+{
+    auto* object = P_NewThinker<T>();
+    std::memset(object, 0, sizeof(T));
+    return &object->thinker;
+}
 
-void P_ArchiveThinkers(std::ofstream& outFile)
+thinker_t* NewThinker(SaveThinker type)
 {
-    // save off the current thinkers
-    for (auto* th = thinkercap.next; th != &thinkercap; th = th->next)
+    switch (type)
     {
-        if (th->function.acp1 == (actionf_p1)P_MobjThinker)
-        {
-            outFile << static_cast<uint8>(SaveFileMarker::MapObject);
+    case SaveThinker::MapObject: return NewThinker<mobj_t>();
+    case SaveThinker::Ceiling: return NewThinker<ceiling_t>();
+    case SaveThinker::Door: return NewThinker<vldoor_t>();
+    case SaveThinker::Floor: return NewThinker<floormove_t>();
+    case SaveThinker::Plat: return NewThinker<plat_t>();
+    case SaveThinker::Flash: return NewThinker<lightflash_t>();
+    case SaveThinker::Strobe: return NewThinker<strobe_t>();
+    case SaveThinker::Glow: return NewThinker<glow_t>();
+    case SaveThinker::FireFlicker: return NewThinker<fireflicker_t>();
+    default: break;
+    }
 
-            nstd::align(4, outFile);
+    I_Error("P_LoadSnapshot: unknown thinker class {}", nstd::to_underlying(type));
+    return nullptr;
+}
 
-            auto* mobj = reinterpret_cast<mobj_t*>(th)->GetSaveData();
-            outFile.write(reinterpret_cast<char*>(mobj), sizeof(mobj_t));
-            delete mobj;
+//
+// Everything below goes both ways: the same function writes the
+// fields and reads them back, so the two can't drift apart.
+//
 
-            continue;
-        }
+template<typename Archive>
+void ArchiveGlobals(Archive& ar)
+{
+    ar(leveltime);
+    ar(prndindex);
+    ar(rndindex);
+    ar(totalkills);
+    ar(totalitems);
+    ar(totalsecret);
+    ar(levelTimeCount);
+
+    ar(iquehead);
+    ar(iquetail);
+    ar(itemrespawnque);
+    ar(itemrespawntime);
+}
+
+template<typename Archive>
+void ArchivePlayer(Archive& ar, player_t& player)
+{
+    ar.thinker(player.mo);
+    ar(player.playerstate);
+    ar(player.cmd);
+    ar(player.viewz);
+    ar(player.viewheight);
+    ar(player.deltaviewheight);
+    ar(player.bob);
+    ar(player.health);
+    ar(player.armorpoints);
+    ar(player.armortype);
+    ar(player.powers);
+    ar(player.cards);
+    ar(player.backpack);
+    ar(player.frags);
+    ar(player.readyweapon);
+    ar(player.pendingweapon);
+    ar(player.weaponowned);
+    ar(player.ammo);
+    ar(player.maxammo);
+    ar(player.attackdown);
+    ar(player.usedown);
+    ar(player.cheats);
+    ar(player.refire);
+    ar(player.killcount);
+    ar(player.itemcount);
+    ar(player.secretcount);
+    ar(player.damagecount);
+    ar(player.bonuscount);
+    ar.thinker(player.attacker);
+    ar(player.extralight);
+    ar(player.fixedcolormap);
+    ar(player.colormap);
+    ar(player.didsecret);
+
+    for (auto& psprite : player.psprites)
+    {
+        ar.index(psprite.state, states, NUMSTATES);
+        ar(psprite.tics);
+        ar(psprite.sx);
+        ar(psprite.sy);
     }
 
-    // add a terminating marker
-    outFile << static_cast<uint8>(SaveFileMarker::ThinkersEnd);
+    if constexpr (Archive::loading)
+        player.message.clear();
 }
 
-void P_UnArchiveThinkers(std::ifstream& inFile)
+template<typename Archive>
+void ArchiveWorld(Archive& ar)
 {
-    // remove all the current thinkers
-    auto* currentthinker = thinkercap.next;
-    while (currentthinker != &thinkercap)
+    for (int32 i = 0; i < numsectors; ++i)
     {
-        auto* next = currentthinker->next;
+        auto& sector = sectors[i];
+        ar(sector.floorheight);
+        ar(sector.ceilingheight);
+        ar(sector.floorpic);
+        ar(sector.ceilingpic);
+        ar(sector.lightlevel);
+        ar(sector.special);
+        ar(sector.tag);
+        ar(sector.soundtraversed);
+        ar.thinker(sector.soundtarget);
+        ar.thinker(sector.thinglist);
+        ar.thinker(sector.specialdata);
+    }
 
-        if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
-            P_RemoveMobj((mobj_t*)currentthinker);
-        else
-            Z_Free(currentthinker);
+    for (int32 i = 0; i < numlines; ++i)
+    {
+        auto& line = lines[i];
+        ar(line.flags);
+        ar(line.special);
+        ar(line.tag);
+    }
 
-        currentthinker = next;
+    for (int32 i = 0; i < numsides; ++i)
+    {
+        auto& side = sides[i];
+        ar(side.textureoffset);
+        ar(side.rowoffset);
+        ar(side.toptexture);
+        ar(side.bottomtexture);
+        ar(side.midtexture);
     }
-    P_InitThinkers();
+}
 
-    // read in saved thinkers
-    for (;;)
+// The sector and block links are kept as they were, not linked again,
+// so the things are found in the same order as before.
+template<typename Archive>
+void ArchiveMobj(Archive& ar, mobj_t& mobj)
+{
+    ar(mobj.x);
+    ar(mobj.y);
+    ar(mobj.z);
+    ar.thinker(mobj.snext);
+    ar.thinker(mobj.sprev);
+    ar(mobj.angle);
+    ar(mobj.sprite);
+    ar(mobj.frame);
+    ar.thinker(mobj.bnext);
+    ar.thinker(mobj.bprev);
+    ar.index(mobj.subsector, subsectors, numsubsectors);
+    ar(mobj.floorz);
+    ar(mobj.ceilingz);
+    ar(mobj.radius);
+    ar(mobj.height);
+    ar(mobj.momx);
+    ar(mobj.momy);
+    ar(mobj.momz);
+    ar(mobj.type);
+    ar(mobj.tics);
+    ar.index(mobj.state, states, NUMSTATES);
+    ar(mobj.flags);
+    ar(mobj.health);
+    ar(mobj.movedir);
+    ar(mobj.movecount);
+    ar.thinker(mobj.target);
+    ar(mobj.reactiontime);
+    ar(mobj.threshold);
+    ar.index(mobj.player, players, MAXPLAYERS);
+    ar(mobj.lastlook);
+    ar(mobj.spawnpoint);
+    ar.thinker(mobj.tracer);
+
+    if constexpr (Archive::loading)
     {
-        SaveFileMarker tclass;
-        inFile.get(reinterpret_cast<char*>(&tclass), 1);
+        if (mobj.type < 0 || mobj.type >= NUMMOBJTYPES)
+            I_Error("P_LoadSnapshot: bad mobj type {}", static_cast<int32>(mobj.type));
 
-        if (tclass == SaveFileMarker::ThinkersEnd)
-            break;
+        mobj.info = &mobjinfo[mobj.type];
+        if (!mobj.subsector)
+            I_Error("P_LoadSnapshot: mobj without a subsector");
+    }
+}
 
-        if (tclass != SaveFileMarker::MapObject)
-            I_Error("Unknown tclass {} in savegame", tclass);
+template<typename Archive>
+void ArchiveCeiling(Archive& ar, ceiling_t& ceiling)
+{
+    ar(ceiling.type);
+    ar.index(ceiling.sector, sectors, numsectors);
+    ar(ceiling.bottomheight);
+    ar(ceiling.topheight);
+    ar(ceiling.speed);
+    ar(ceiling.crush);
+    ar(ceiling.direction);
+    ar(ceiling.tag);
+    ar(ceiling.olddirection);
+}
 
-        nstd::align(4, inFile);
+template<typename Archive>
+void ArchiveDoor(Archive& ar, vldoor_t& door)
+{
+    ar(door.type);
+    ar.index(door.sector, sectors, numsectors);
+    ar(door.topheight);
+    ar(door.speed);
+    ar(door.direction);
+    ar(door.topwait);
+    ar(door.topcountdown);
+}
 
-        auto* mobj = Z_Malloc<mobj_t>(sizeof(mobj_t), PU_LEVEL, nullptr);
-        inFile.read(reinterpret_cast<char*>(mobj), sizeof(mobj_t));
+template<typename Archive>
+void ArchiveFloor(Archive& ar, floormove_t& floor)
+{
+    ar(floor.type);
+    ar(floor.crush);
+    ar.index(floor.sector, sectors, numsectors);
+    ar(floor.direction);
+    ar(floor.newspecial);
+    ar(floor.texture);
+    ar(floor.floordestheight);
+    ar(floor.speed);
+}
 
-        mobj->state = states + reinterpret_cast<intptr_t>(mobj->state);
-        mobj->target = nullptr;
-        if (mobj->player)
-        {
-            mobj->player = players + reinterpret_cast<intptr_t>(mobj->player - 1);
-            mobj->player->mo = mobj;
-        }
-        P_SetThingPosition(mobj);
-        mobj->info = &mobjinfo[mobj->type];
-        mobj->floorz = mobj->subsector->sector->floorheight;
-        mobj->ceilingz = mobj->subsector->sector->ceilingheight;
-        mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
-        P_AddThinker(&mobj->thinker);
-    }
+template<typename Archive>
+void ArchivePlat(Archive& ar, plat_t& plat)
+{
+    ar.index(plat.sector, sectors, numsectors);
+    ar(plat.speed);
+    ar(plat.low);
+    ar(plat.high);
+    ar(plat.wait);
+    ar(plat.count);
+    ar(plat.status);
+    ar(plat.oldstatus);
+    ar(plat.crush);
+    ar(plat.tag);
+    ar(plat.type);
 }
 
-std::ostream& operator<<(std::ostream& os, SaveFileMarker sp)
+template<typename Archive>
+void ArchiveFlash(Archive& ar, lightflash_t& flash)
 {
-    os << nstd::to_underlying(sp);
-    return os;
+    ar.index(flash.sector, sectors, numsectors);
+    ar(flash.count);
+    ar(flash.maxlight);
+    ar(flash.minlight);
+    ar(flash.maxtime);
+    ar(flash.mintime);
 }
 
-// Things to handle:
-//
-// T_MoveCeiling, (ceiling_t: sector_t * swizzle), - active list
-// T_VerticalDoor, (vldoor_t: sector_t * swizzle),
-// T_MoveFloor, (floormove_t: sector_t * swizzle),
-// T_LightFlash, (lightflash_t: sector_t * swizzle),
-// T_StrobeFlash, (strobe_t: sector_t *),
-// T_Glow, (glow_t: sector_t *),
-// T_PlatRaise, (plat_t: sector_t *), - active list
-template<typename T>
-inline void writeObject(std::ofstream& outFile, thinker_t* object, SaveFileMarker marker)
+template<typename Archive>
+void ArchiveStrobe(Archive& ar, strobe_t& strobe)
 {
-    outFile << marker;
-    nstd::align(4, outFile);
+    ar.index(strobe.sector, sectors, numsectors);
+    ar(strobe.count);
+    ar(strobe.minlight);
+    ar(strobe.maxlight);
+    ar(strobe.darktime);
+    ar(strobe.brighttime);
+}
 
-    auto* data = GetSaveData(reinterpret_cast<T*>(object));
-    outFile.write(reinterpret_cast<char*>(data), sizeof(T));
-    delete data;
+template<typename Archive>
+void ArchiveGlow(Archive& ar, glow_t& glow)
+{
+    ar.index(glow.sector, sectors, numsectors);
+    ar(glow.minlight);
+    ar(glow.maxlight);
+    ar(glow.direction);
 }
 
-void P_ArchiveSpecials(std::ofstream& outFile)
+template<typename Archive>
+void ArchiveFireFlicker(Archive& ar, fireflicker_t& flicker)
 {
-    // save off the current thinkers
-    for (auto* th = thinkercap.next; th != &thinkercap; th = th->next)
+    ar.index(flicker.sector, sectors, numsectors);
+    ar(flicker.count);
+    ar(flicker.maxlight);
+    ar(flicker.minlight);
+}
+
+template<typename Archive>
+void ArchiveThinker(Archive& ar, SaveThinker type, thinker_t* thinker)
+{
+    switch (type)
     {
-        if (th->function.acv == (actionf_v)nullptr)
-        {
-            int32 i = 0;
-            for (; i < MAXCEILINGS; ++i)
-            {
-                if (activeceilings[i] == (ceiling_t*)th)
-                    break;
-            }
+    case SaveThinker::MapObject: ArchiveMobj(ar, *reinterpret_cast<mobj_t*>(thinker)); break;
+    case SaveThinker::Ceiling: ArchiveCeiling(ar, *reinterpret_cast<ceiling_t*>(thinker)); break;
+    case SaveThinker::Door: ArchiveDoor(ar, *reinterpret_cast<vldoor_t*>(thinker)); break;
+    case SaveThinker::Floor: ArchiveFloor(ar, *reinterpret_cast<floormove_t*>(thinker)); break;
+    case SaveThinker::Plat: ArchivePlat(ar, *reinterpret_cast<plat_t*>(thinker)); break;
+    case SaveThinker::Flash: ArchiveFlash(ar, *reinterpret_cast<lightflash_t*>(thinker)); break;
+    case SaveThinker::Strobe: ArchiveStrobe(ar, *reinterpret_cast<strobe_t*>(thinker)); break;
+    case SaveThinker::Glow: ArchiveGlow(ar, *reinterpret_cast<glow_t*>(thinker)); break;
+    case SaveThinker::FireFlicker: ArchiveFireFlicker(ar, *reinterpret_cast<fireflicker_t*>(thinker)); break;
+    default: break;
+    }
+}
 
-            if (i < MAXCEILINGS)
-                writeObject<ceiling_t>(outFile, th, SaveFileMarker::Ceiling);
+// The lists that point at thinkers, in the same slots as before.
+template<typename Archive>
+void ArchiveLists(Archive& ar)
+{
+    for (auto& ceiling : activeceilings)
+        ar.thinker(ceiling);
 
-            continue;
-        }
+    for (auto& plat : activeplats)
+        ar.thinker(plat);
 
-        if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
-            writeObject<ceiling_t>(outFile, th, SaveFileMarker::Ceiling);
-        else if (th->function.acp1 == (actionf_p1)T_VerticalDoor)
-            writeObject<vldoor_t>(outFile, th, SaveFileMarker::Door);
-        else if (th->function.acp1 == (actionf_p1)T_MoveFloor)
-            writeObject<floormove_t>(outFile, th, SaveFileMarker::Door);
-        else if (th->function.acp1 == (actionf_p1)T_PlatRaise)
-            writeObject<plat_t>(outFile, th, SaveFileMarker::Plat);
-        else if (th->function.acp1 == (actionf_p1)T_LightFlash)
-            writeObject<lightflash_t>(outFile, th, SaveFileMarker::Flash);
-        else if (th->function.acp1 == (actionf_p1)T_StrobeFlash)
-            writeObject<strobe_t>(outFile, th, SaveFileMarker::Strobe);
-        else if (th->function.acp1 == (actionf_p1)T_Glow)
-            writeObject<glow_t>(outFile, th, SaveFileMarker::Glow);
+    for (auto& button : buttonlist)
+    {
+        ar.index(button.line, lines, numlines);
+        ar(button.where);
+        ar(button.btexture);
+        ar(button.btimer);
+
+        if constexpr (Archive::loading)
+            button.soundorg = button.line ? reinterpret_cast<mobj_t*>(&button.line->frontsector->soundorg) : nullptr;
     }
 
-    // add a terminating marker
-    outFile << SaveFileMarker::End;
+    ar(bodyqueslot);
+    for (auto& body : bodyque)
+        ar.thinker(body);
+
+    ar(numbraintargets);
+    ar(braintargeton);
+    for (auto& target : braintargets)
+        ar.thinker(target);
 }
 
-template<typename T>
-T* ReadThinker(std::ifstream& inFile, actionf_p1 action)
+struct snapshotheader_t
 {
-    nstd::align(4, inFile);
-    auto* object = Z_Malloc<T>(sizeof(T), PU_LEVEL, nullptr);
-    inFile.read(reinterpret_cast<char*>(object), sizeof(T));
-    object->sector = sectors + reinterpret_cast<intptr_t>(object->sector);
-    object->sector->specialdata = object;
-    object->thinker.function.acp1 = action;
-    P_AddThinker(&object->thinker);
-    return object;
-}
+    uint32 magic;
+    uint32 version;
+    int32 gameversion;
+    skill_t skill;
+    int32 episode;
+    int32 map;
+    bool playeringame[MAXPLAYERS];
+    int32 numsectors;
+    int32 numlines;
+    int32 numsides;
+    int32 numthinkers;
+};
+
+} // namespace
 
-void P_UnArchiveSpecials(std::ifstream& inFile)
+//
+// P_SaveSnapshot
+//
+void P_SaveSnapshot(vector<byte>& buffer)
 {
-    // read in saved thinkers
-    while (!inFile.eof())
+    // Number the thinkers in the order they think.
+    thinkerclasses.clear();
+    for (auto* th = thinkercap.next; th != &thinkercap; th = th->next)
+        thinkerclasses.push_back(ThinkerClass(th));
+    NumberThinkers(thinkerclasses.size());
+
+    snapshotwriter ar{buffer};
+
+    snapshotheader_t header{SNAPSHOTMAGIC, SNAPSHOTVERSION, Doom::Version, gameskill, gameepisode, gamemap, {},
+        numsectors, numlines, numsides, thinkerclasses.size()};
+    std::copy_n(playeringame, MAXPLAYERS, header.playeringame);
+    ar(header);
+
+    // What each thinker is, so they can all be made before any of them
+    // is read and pointers to ones further on can be filled in.
+    int32 n = 0;
+    for (auto* th = thinkercap.next; th != &thinkercap; th = th->next, ++n)
     {
-        SaveFileMarker tclass = SaveFileMarker::Invalid;
-        inFile.get(reinterpret_cast<char*>(&tclass), 1);
+        auto state = th->function.acv == (actionf_v)(-1) ? SaveThinkerState::Removed
+            : th->function.acv == nullptr ? SaveThinkerState::Stasis
+            : SaveThinkerState::Thinking;
+        ar(thinkerclasses[n]);
+        ar(state);
+    }
 
-        if (tclass == SaveFileMarker::ThinkersEnd)
-            break;
+    ArchiveGlobals(ar);
+    for (auto& player : players)
+        ArchivePlayer(ar, player);
+    ArchiveWorld(ar);
 
-        switch (tclass)
-        {
-        case SaveFileMarker::End:
-            return;	// end of list
+    n = 0;
+    for (auto* th = thinkercap.next; th != &thinkercap; th = th->next, ++n)
+        ArchiveThinker(ar, thinkerclasses[n], th);
 
-        case SaveFileMarker::Ceiling:
-        {
-            auto* ceiling = ReadThinker<ceiling_t>(inFile, nullptr);
+    ArchiveLists(ar);
 
-            if (ceiling->thinker.function.acp1)
-                ceiling->thinker.function.acp1 = (actionf_p1)T_MoveCeiling;
+    // The heads of the blockmap's chains of things.
+    auto blocks = bmapwidth * bmapheight;
+    int32 linked = static_cast<int32>(std::count_if(blocklinks, blocklinks + blocks, [](auto* mobj){ return mobj != nullptr; }));
+    ar(linked);
+    for (int32 i = 0; i < blocks; ++i)
+    {
+        if (!blocklinks[i])
+            continue;
 
-            P_AddActiveCeiling(ceiling);
-            break;
-        }
+        ar(i);
+        ar.thinker(blocklinks[i]);
+    }
 
-        case SaveFileMarker::Door:
-            ReadThinker<ceiling_t>(inFile, (actionf_p1)T_VerticalDoor);
-            break;
+    ar(SNAPSHOTMAGIC);
+    ar.finish();
+}
 
-        case SaveFileMarker::Floor:
-            ReadThinker<floormove_t>(inFile, (actionf_p1)T_MoveFloor);
-            break;
+//
+// P_SnapshotInfo
+//
+std::optional<snapshotinfo_t> P_SnapshotInfo(std::span<const byte> snapshot)
+{
+    snapshotheader_t header;
+    if (snapshot.size() < sizeof(header))
+        return std::nullopt;
 
-        case SaveFileMarker::Plat:
-        {
-            auto* platform = ReadThinker<plat_t>(inFile, nullptr);
+    std::memcpy(&header, snapshot.data(), sizeof(header));
+    if (header.magic != SNAPSHOTMAGIC || header.version != SNAPSHOTVERSION || header.gameversion != Doom::Version)
+        return std::nullopt;
 
-            if (platform->thinker.function.acp1)
-                platform->thinker.function.acp1 = (actionf_p1)T_PlatRaise;
+    snapshotinfo_t info{header.skill, header.episode, header.map, {}};
+    std::copy_n(header.playeringame, MAXPLAYERS, info.playeringame);
+    return info;
+}
 
-            P_AddActivePlat(platform);
-            break;
-        }
+//
+// P_LoadSnapshot
+//
+void P_LoadSnapshot(std::span<const byte> snapshot)
+{
+    if (!P_SnapshotInfo(snapshot))
+        I_Error("P_LoadSnapshot: not a snapshot this version can load");
 
-        case SaveFileMarker::Flash:
-            ReadThinker<lightflash_t>(inFile, (actionf_p1)T_LightFlash);
-            break;
+    snapshotreader ar{snapshot};
 
-        case SaveFileMarker::Strobe:
-            ReadThinker<strobe_t>(inFile, (actionf_p1)T_StrobeFlash);
-            break;
+    snapshotheader_t header;
+    ar(header);
+    if (header.episode != gameepisode || header.map != gamemap
+        || header.numsectors != numsectors || header.numlines != numlines || header.numsides != numsides)
+    {
+        I_Error("P_LoadSnapshot: snapshot of E{}M{}, this is E{}M{}", header.episode, header.map, gameepisode, gamemap);
+    }
 
-        case SaveFileMarker::Glow:
-            ReadThinker<glow_t>(inFile, (actionf_p1)T_Glow);
-            break;
+    gameskill = header.skill;
+    std::copy_n(header.playeringame, MAXPLAYERS, playeringame);
 
-        default:
-            I_Error("P_UnarchiveSpecials:Unknown tclass {} in savegame", tclass);
-        }
+    // All the thinkers go back to their pools without being unlinked,
+    // the links are all replaced.
+    for (auto* th = thinkercap.next; th != &thinkercap;)
+    {
+        auto* next = th->next;
+        P_FreeThinker(th);
+        th = next;
     }
+    P_ReuseFreedThinkers();
+    P_InitThinkers();
+    std::fill_n(blocklinks, bmapwidth * bmapheight, nullptr);
+
+    thinkertable.clear();
+    thinkerclasses.clear();
+    for (int32 n = 0; n < header.numthinkers; ++n)
+    {
+        SaveThinker type;
+        SaveThinkerState state;
+        ar(type);
+        ar(state);
+
+        auto* thinker = NewThinker(type);
+        if (state == SaveThinkerState::Removed)
+            thinker->function.acv = (actionf_v)(-1);
+        else if (state == SaveThinkerState::Thinking)
+            thinker->function.acp1 = ThinkerFunction(type);
+
+        P_AddThinker(thinker);
+        thinkertable.push_back(thinker);
+        thinkerclasses.push_back(type);
+    }
+
+    ArchiveGlobals(ar);
+    for (auto& player : players)
+        ArchivePlayer(ar, player);
+    ArchiveWorld(ar);
+
+    for (int32 n = 0; n < thinkertable.size(); ++n)
+        ArchiveThinker(ar, thinkerclasses[n], thinkertable[n]);
+
+    ArchiveLists(ar);
+
+    auto blocks = bmapwidth * bmapheight;
+    int32 linked = 0;
+    ar(linked);
+    for (int32 n = 0; n < linked; ++n)
+    {
+        int32 i = 0;
+        ar(i);
+        if (i < 0 || i >= blocks)
+            I_Error("P_LoadSnapshot: bad block {}", i);
+        ar.thinker(blocklinks[i]);
+    }
+
+    uint32 magic = 0;
+    ar(magic);
+    if (magic != SNAPSHOTMAGIC)
+        I_Error("P_LoadSnapshot: snapshot doesn't end where it should");
 }
@@ -17,44 +17,43 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+#include "doomdef.h"
+
 import std;
 import nstd;
 
-enum class SaveFileMarker : uint8
-{
-    ThinkersEnd = 0,
-    MapObject,
-
-    Ceiling = 0,
-    Door,
-    Floor,
-    Plat,
-    Flash,
-    Strobe,
-    Glow,
-    End,
-
-    EndSave = 0x1d,
+// A snapshot is the whole state of the play simulation on a level:
+// the players, the sectors, lines and sides, every thinker in the
+// order they think in, with the ones removed this tic and the plats
+// and ceilings in stasis, the random number indices and the queues
+// and lists that point at thinkers. Pointers are stored as indices,
+// so a snapshot taken and loaded back plays on exactly as the game
+// would have. It's one block of memory, written and read front to
+// back, small enough and quick enough to take every tic.
+//
+// Savegames are a snapshot behind the description, see G_SaveGame.
 
-    Invalid = 0xff
-};
+// Bumped whenever the layout of a snapshot changes.
+constexpr uint32 SNAPSHOTVERSION = 1;
 
-template<>
-struct std::formatter<SaveFileMarker> : std::formatter<string>
+// The level a snapshot was taken on.
+struct snapshotinfo_t
 {
-    auto format(SaveFileMarker mark, std::format_context& ctx) const
-    {
-        return formatter<string>::format(std::format("{}", to_underlying(mark)), ctx);
-    }
+    skill_t skill;
+    int32 episode;
+    int32 map;
+    bool playeringame[MAXPLAYERS];
 };
 
-// Persistent storage/archiving.
-// These are the load / save game routines.
-void P_ArchivePlayers(std::ofstream& outFile);
-void P_UnArchivePlayers(std::ifstream& inFile);
-void P_ArchiveWorld(std::ofstream& outFile);
-void P_UnArchiveWorld(std::ifstream& inFile);
-void P_ArchiveThinkers(std::ofstream& outFile);
-void P_UnArchiveThinkers(std::ifstream& inFile);
-void P_ArchiveSpecials(std::ofstream& outFile);
-void P_UnArchiveSpecials(std::ifstream& inFile);
+// Appends a snapshot of the current level to buffer, which is only
+// grown when it hasn't the room, so a buffer that's kept around
+// isn't allocated again.
+void P_SaveSnapshot(vector<byte>& buffer);
+
+// The level of a snapshot, or nothing if it isn't a snapshot this
+// version can load.
+std::optional<snapshotinfo_t> P_SnapshotInfo(std::span<const byte> snapshot);
+
+// Puts the current level back the way it was in the snapshot, which
+// must have been taken on this level.
+void P_LoadSnapshot(std::span<const byte> snapshot);
@@ -30,6 +30,7 @@
 #include "r_things.h"
 
 import std;
+import config;
 
 
 extern Doom* g_doom;
@@ -413,30 +414,23 @@ void P_LoadBlockMap(intptr_t lump)
 
 // Builds sector line lists and subsector sector numbers.
 // Finds block bounding boxes for sectors.
+// Linear in lines: a counting pass, a prefix sum giving each sector its
+// slice of one buffer, and a scatter pass that fills the slices and
+// grows the bounding boxes. Each sector's lines stay in line order.
 void P_GroupLines()
 {
-    line_t** linebuffer;
-    int			i;
-    int			j;
-    int			total;
-    line_t* li;
-    sector_t* sector;
-    subsector_t* ss;
-    seg_t* seg;
-    int			block;
-
     // look up sector number for each subsector
-    ss = subsectors;
-    for (i = 0; i < numsubsectors; i++, ss++)
+    auto* ss = subsectors;
+    for (int32 i = 0; i < numsubsectors; i++, ss++)
     {
-        seg = &segs[ss->firstline];
+        auto* seg = &segs[ss->firstline];
         ss->sector = seg->sidedef->sector;
     }
 
     // count number of lines in each sector
-    li = lines;
-    total = 0;
-    for (i = 0; i < numlines; i++, li++)
+    auto* li = lines;
+    int32 total = 0;
+    for (int32 i = 0; i < numlines; i++, li++)
     {
         total++;
         li->frontsector->linecount++;
@@ -448,44 +442,58 @@ void P_GroupLines()
         }
     }
 
-    // build line tables for each sector	
-    linebuffer = Z_Malloc<line_t*>(total * sizeof(line_t*), PU_LEVEL, 0);
-    sector = sectors;
-    for (i = 0; i < numsectors; i++, sector++)
+    // give each sector its slice of the line buffer
+    auto* linebuffer = Z_Malloc<line_t*>(total * sizeof(line_t*), PU_LEVEL, 0);
+    vector<int32> filled(numsectors);
+    auto* sector = sectors;
+    for (int32 i = 0; i < numsectors; i++, sector++)
     {
-        bbox bounds;
         sector->lines = linebuffer;
-        li = lines;
-        for (j = 0; j < numlines; j++, li++)
-        {
-            if (li->frontsector == sector || li->backsector == sector)
-            {
-                *linebuffer++ = li;
-                bounds.add(li->v1->x, li->v1->y);
-                bounds.add(li->v2->x, li->v2->y);
-            }
-        }
-        if (linebuffer - sector->lines != sector->linecount)
+        linebuffer += sector->linecount;
+    }
+
+    // scatter the lines and find the bounding boxes
+    vector<bbox> bounds(numsectors);
+    auto add = [&](line_t* line, sector_t* sector)
+    {
+        auto n = sector - sectors;
+        sector->lines[filled[n]++] = line;
+        bounds[n].add(line->v1->x, line->v1->y);
+        bounds[n].add(line->v2->x, line->v2->y);
+    };
+
+    li = lines;
+    for (int32 i = 0; i < numlines; i++, li++)
+    {
+        add(li, li->frontsector);
+        if (li->backsector && li->backsector != li->frontsector)
+            add(li, li->backsector);
+    }
+
+    sector = sectors;
+    for (int32 i = 0; i < numsectors; i++, sector++)
+    {
+        if (filled[i] != sector->linecount)
             I_Error("P_GroupLines: miscounted");
 
         // set the degenmobj_t to the middle of the bounding box
-        sector->soundorg.x = bounds.midx();
-        sector->soundorg.y = bounds.midy();
+        sector->soundorg.x = bounds[i].midx();
+        sector->soundorg.y = bounds[i].midy();
 
         // adjust bounding box to map blocks
-        block = (bounds.top - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT;
+        auto block = (bounds[i].top - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT;
         block = block >= bmapheight ? bmapheight - 1 : block;
         sector->blockbox.top = block;
 
-        block = (bounds.bottom - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT;
+        block = (bounds[i].bottom - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT;
         block = block < 0 ? 0 : block;
         sector->blockbox.bottom = block;
 
-        block = (bounds.right - bmaporgx + MAXRADIUS) >> MAPBLOCKSHIFT;
+        block = (bounds[i].right - bmaporgx + MAXRADIUS) >> MAPBLOCKSHIFT;
         block = block >= bmapwidth ? bmapwidth - 1 : block;
         sector->blockbox.right = block;
 
-        block = (bounds.left - bmaporgx - MAXRADIUS) >> MAPBLOCKSHIFT;
+        block = (bounds[i].left - bmaporgx - MAXRADIUS) >> MAPBLOCKSHIFT;
         block = block < 0 ? 0 : block;
         sector->blockbox.left = block;
     }
@@ -522,6 +530,7 @@ void P_SetupLevel(int episode, int map, int /*playermask*/, skill_t /*skill*/)
         Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
 
 
+    P_ClearThinkerPools();
     P_InitThinkers();
 
     // find map name
@@ -535,23 +544,37 @@ void P_SetupLevel(int episode, int map, int /*playermask*/, skill_t /*skill*/)
 
     leveltime = 0;
 
+    // -setuptimes prints how long each step of the setup takes
+    auto showTimes = CommandLine::HasArg("-setuptimes");
+    auto setupStart = std::chrono::steady_clock::now();
+    auto timed = [showTimes](string_view step, auto&& run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        if (showTimes)
+            std::cout << std::format("  {:<16} {:8.3f} ms\n", step, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    };
+
+    if (showTimes)
+        std::cout << std::format("P_SetupLevel: {}\n", lumpname);
+
     // note: most of this ordering is important	
-    P_LoadBlockMap(lumpnum + ML_BLOCKMAP);
-    P_LoadVertexes(lumpnum + ML_VERTEXES);
-    P_LoadSectors(lumpnum + ML_SECTORS);
-    P_LoadSideDefs(lumpnum + ML_SIDEDEFS);
+    timed("P_LoadBlockMap", [&]{ P_LoadBlockMap(lumpnum + ML_BLOCKMAP); });
+    timed("P_LoadVertexes", [&]{ P_LoadVertexes(lumpnum + ML_VERTEXES); });
+    timed("P_LoadSectors", [&]{ P_LoadSectors(lumpnum + ML_SECTORS); });
+    timed("P_LoadSideDefs", [&]{ P_LoadSideDefs(lumpnum + ML_SIDEDEFS); });
 
-    P_LoadLineDefs(lumpnum + ML_LINEDEFS);
-    P_LoadSubsectors(lumpnum + ML_SSECTORS);
-    P_LoadNodes(lumpnum + ML_NODES);
-    P_LoadSegs(lumpnum + ML_SEGS);
+    timed("P_LoadLineDefs", [&]{ P_LoadLineDefs(lumpnum + ML_LINEDEFS); });
+    timed("P_LoadSubsectors", [&]{ P_LoadSubsectors(lumpnum + ML_SSECTORS); });
+    timed("P_LoadNodes", [&]{ P_LoadNodes(lumpnum + ML_NODES); });
+    timed("P_LoadSegs", [&]{ P_LoadSegs(lumpnum + ML_SEGS); });
 
     rejectmatrix = WadManager::GetLumpData<byte>(lumpnum + ML_REJECT);
-    P_GroupLines();
+    timed("P_GroupLines", [&]{ P_GroupLines(); });
 
     bodyqueslot = 0;
     deathmatch_p = deathmatchstarts;
-    P_LoadThings(lumpnum + ML_THINGS);
+    timed("P_LoadThings", [&]{ P_LoadThings(lumpnum + ML_THINGS); });
 
     // if deathmatch, randomly spawn the active players
     if (deathmatch)
@@ -569,14 +592,22 @@ void P_SetupLevel(int episode, int map, int /*playermask*/, skill_t /*skill*/)
     iquehead = iquetail = 0;
 
     // set up world state
-    P_SpawnSpecials();
+    timed("P_SpawnSpecials", [&]{ P_SpawnSpecials(); });
+    P_ResetInterpolation();
 
     // build subsector connect matrix
     //	UNUSED P_ConnectSubsectors ();
 
     // preload graphics
     if (precache)
-        R_PrecacheLevel();
+        timed("R_PrecacheLevel", [&]{ R_PrecacheLevel(); });
+
+    // build the multi-patch textures now rather than mid-frame
+    timed("R_GenerateLevelComposites", [&]{ R_GenerateLevelComposites(); });
+    timed("R_BuildTextureAtlas", [&]{ R_BuildTextureAtlas(); });
+
+    if (showTimes)
+        std::cout << std::format("  {:<16} {:8.3f} ms\n", "total", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setupStart).count());
 
     //printf ("free memory: 0x%x\n", Z_FreeMemory());
 
@@ -584,6 +615,8 @@ void P_SetupLevel(int episode, int map, int /*playermask*/, skill_t /*skill*/)
 
 void P_Init(Doom* doom)
 {
+    sightcache = CommandLine::HasArg("-sightcache");
+
     P_InitSwitchList();
     P_InitPicAnims();
     R_InitSprites(doom, spriteNames);
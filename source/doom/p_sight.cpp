@@ -22,6 +22,7 @@
 #include "r_main.h"
 
 import std;
+import bench;
 
 
 // P_CheckSight
@@ -34,7 +35,81 @@ divline_t	strace;			// from t1 to t2
 fixed_t		t2x;
 fixed_t		t2y;
 
-int		sightcounts[2];
+int		sightcounts[2];		// rejected, traced
+
+//
+// Sight cache (-sightcache)
+// Answers the same P_CheckSight question again without tracing it
+// when it comes up more than once in a tic. The key is everything the
+// answer depends on: both subsectors and positions, t1's eye height and
+// t2's z range, so a cached answer is the one P_CrossBSPNode would have
+// given and demos play back the same. A moving sector can open or block
+// any line of sight, so P_ChangeSector empties the cache, as does every
+// new tic.
+//
+#define SIGHTCACHESIZE	1024
+
+bool		sightcache;
+int		sightcachecounts[2];	// hits, misses
+
+struct sightkey_t
+{
+    subsector_t* ss1;
+    subsector_t* ss2;
+    fixed_t	x1;
+    fixed_t	y1;
+    fixed_t	eyez;
+    fixed_t	x2;
+    fixed_t	y2;
+    fixed_t	bottom;
+    fixed_t	top;
+
+    bool operator==(const sightkey_t&) const = default;
+};
+
+struct sightentry_t
+{
+    uint32	stamp;		// current while it matches sightstamp
+    sightkey_t	key;
+    bool	visible;
+};
+
+static sightentry_t sightentries[SIGHTCACHESIZE];
+static uint32 sightstamp = 1;
+
+void P_ClearSightCache()
+{
+    if (++sightstamp == 0)
+    {
+        std::memset(sightentries, 0, sizeof(sightentries));
+        sightstamp = 1;
+    }
+}
+
+// Reports the counters of the tic just run to -benchreport and starts
+// the next tic with them, and the cache, empty.
+void P_NewSightTic()
+{
+    bench::count("sight_rejected", sightcounts[0]);
+    bench::count("sight_traced", sightcounts[1]);
+    if (sightcache)
+    {
+        bench::count("sight_cache_hits", sightcachecounts[0]);
+        bench::count("sight_cache_misses", sightcachecounts[1]);
+    }
+
+    sightcounts[0] = sightcounts[1] = 0;
+    sightcachecounts[0] = sightcachecounts[1] = 0;
+    P_ClearSightCache();
+}
+
+static uint32 P_SightHash(const sightkey_t& key)
+{
+    uint32 hash = 2166136261u;
+    for (auto value : {key.x1, key.y1, key.eyez, key.x2, key.y2, key.bottom, key.top})
+        hash = (hash ^ static_cast<uint32>(value)) * 16777619u;
+    return hash ^ (hash >> 15);
+}
 
 
 //
@@ -297,6 +372,24 @@ bool P_CheckSight(mobj_t* t1, mobj_t* t2)
     // Now look from eyes of t1 to any part of t2.
     sightcounts[1]++;
 
+    sightentry_t* entry = nullptr;
+    if (sightcache)
+    {
+        sightkey_t key{t1->subsector, t2->subsector, t1->x, t1->y,
+            t1->z + t1->height - (t1->height >> 2), t2->x, t2->y, t2->z, t2->z + t2->height};
+
+        entry = &sightentries[P_SightHash(key) & (SIGHTCACHESIZE - 1)];
+        if (entry->stamp == sightstamp && entry->key == key)
+        {
+            sightcachecounts[0]++;
+            return entry->visible;
+        }
+
+        sightcachecounts[1]++;
+        entry->stamp = sightstamp;
+        entry->key = key;
+    }
+
     validcount++;
 
     sightzstart = t1->z + t1->height - (t1->height >> 2);
@@ -311,7 +404,11 @@ bool P_CheckSight(mobj_t* t1, mobj_t* t2)
     strace.dy = t2->y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode(numnodes - 1);
+    auto visible = P_CrossBSPNode(numnodes - 1);
+    if (entry)
+        entry->visible = visible;
+
+    return visible;
 }
 
 
@@ -1155,7 +1155,7 @@ int EV_DoDonut(line_t* line)
             s3 = s2->lines[i]->backsector;
 
             //	Spawn rising slime
-            floor = Z_Malloc<floormove_t>(sizeof(*floor), PU_LEVSPEC, 0);
+            floor = P_NewThinker<floormove_t>();
             P_AddThinker(&floor->thinker);
             s2->specialdata = floor;
             floor->thinker.function.acp1 = (actionf_p1)T_MoveFloor;
@@ -1169,7 +1169,7 @@ int EV_DoDonut(line_t* line)
             floor->floordestheight = s3->floorheight;
 
             //	Spawn lowering donut-hole
-            floor = Z_Malloc<floormove_t>(sizeof(*floor), PU_LEVSPEC, 0);
+            floor = P_NewThinker<floormove_t>();
             P_AddThinker(&floor->thinker);
             s1->specialdata = floor;
             floor->thinker.function.acp1 = (actionf_p1)T_MoveFloor;
@@ -29,16 +29,6 @@ extern	int	levelTimeCount;
 //      Define values for map objects
 #define MO_TELEPORTMAN          14
 
-template<typename T>
-byte* GetSaveData(const T* object)
-{
-    auto* out = new T;
-    memcpy(out, object, sizeof(T));
-
-    *reinterpret_cast<intptr_t*>(out->sector) = out->sector - sectors;
-    return reinterpret_cast<byte*>(out);
-}
-
 // at game start
 void    P_InitPicAnims();
 
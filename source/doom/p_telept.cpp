@@ -85,7 +85,10 @@ int EV_Teleport(line_t* line, int side, mobj_t* thing)
 
                 thing->z = thing->floorz;  //fixme: not needed?
                 if (thing->player)
+                {
                     thing->player->viewz = thing->z + thing->player->viewheight;
+                    thing->player->oldviewz = thing->player->viewz;
+                }
 
                 // spawn teleport fog at source and destination
                 fog = P_SpawnMobj(oldx, oldy, oldz, MT_TFOG);
@@ -103,6 +106,7 @@ int EV_Teleport(line_t* line, int side, mobj_t* thing)
 
                 thing->angle = m->angle;
                 thing->momx = thing->momy = thing->momz = 0;
+                thing->ResetInterpolation();
                 return 1;
             }
         }
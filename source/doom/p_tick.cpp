@@ -22,13 +22,15 @@ import std;
 #include "p_local.h"
 
 #include "doomstat.h"
+#include "r_state.h"
 
 
 int	leveltime;
+bool	interpolating;
 
 //
 // THINKERS
-// All thinkers should be allocated by Z_Malloc
+// All thinkers should be allocated by P_NewThinker
 // so they can be operated on uniformly.
 // The actual structures will vary in size,
 // but the first element must be thinker_t.
@@ -39,6 +41,44 @@ int	leveltime;
 // Both the head and tail of the thinker list.
 thinker_t	thinkercap;
 
+namespace
+{
+
+// Sits in front of every pooled thinker, the way memblock_t sits in
+// front of a zone block, so the object itself can be memset or read
+// from a savegame without losing track of its pool.
+struct thinkerslot_t
+{
+    thinkerslot_t* nextfree;
+    int32 pool;
+    int32 pad;
+};
+
+// Freed slots are handed out again oldest first, and none before the
+// tic it was freed in is over, so the puff or blood spawned right after
+// a mobj is removed doesn't land on it. Code that still reads a removed
+// mobj through a target or tracer finds what it left behind for a
+// while, as it did in freed zone memory.
+struct thinkerpool_t
+{
+    int32 stride;	// header and object, rounded up to 16 bytes
+    int32 perslab;
+    thinkerslot_t* free;
+    thinkerslot_t* freetail;
+    thinkerslot_t* freed;	// this tic, not handed out yet
+    thinkerslot_t* freedtail;
+};
+
+constexpr int32 SLABSIZE = 32 * 1024;
+
+vector<thinkerpool_t> thinkerpools;
+
+// Every thinker in the list, in list order, which is the order they
+// think in. P_RunThinkers walks this instead of chasing the links.
+vector<thinker_t*> thinkerorder;
+
+} // namespace
+
 
 //
 // P_InitThinkers
@@ -46,6 +86,7 @@ thinker_t	thinkercap;
 void P_InitThinkers()
 {
     thinkercap.prev = thinkercap.next = &thinkercap;
+    thinkerorder.clear();
 }
 
 
@@ -61,6 +102,8 @@ void P_AddThinker(thinker_t* thinker)
     thinker->next = &thinkercap;
     thinker->prev = thinkercap.prev;
     thinkercap.prev = thinker;
+
+    thinkerorder.push_back(thinker);
 }
 
 
@@ -77,34 +120,131 @@ void P_RemoveThinker(thinker_t* thinker)
 }
 
 //
-// P_AllocateThinker
-// Allocates memory and adds a new thinker at the end of the list.
+// P_RegisterThinkerPool
+// One pool per thinker type, see P_NewThinker.
+//
+int32 P_RegisterThinkerPool(int32 size)
+{
+    auto stride = nstd::size_cast<int32>((sizeof(thinkerslot_t) + size + 15) & ~15);
+    thinkerpools.push_back({stride, std::max(SLABSIZE / stride, 16), nullptr, nullptr, nullptr, nullptr});
+    return thinkerpools.size() - 1;
+}
+
+//
+// P_AllocThinker
+// Takes a slot from the pool, carving a new PU_LEVEL slab
+// out of the zone when it has none left.
+//
+void* P_AllocThinker(int32 pool)
+{
+    auto& p = thinkerpools[pool];
+    if (!p.free)
+    {
+        auto* slab = Z_Malloc(p.stride * p.perslab, PU_LEVEL, nullptr);
+
+        // Thread backwards so the slots are handed out in address order.
+        p.freetail = reinterpret_cast<thinkerslot_t*>(slab + (p.perslab - 1) * p.stride);
+        for (int32 n = p.perslab - 1; n >= 0; --n)
+        {
+            auto* slot = reinterpret_cast<thinkerslot_t*>(slab + n * p.stride);
+            slot->pool = pool;
+            slot->nextfree = p.free;
+            p.free = slot;
+        }
+    }
+
+    auto* slot = p.free;
+    p.free = slot->nextfree;
+    if (!p.free)
+        p.freetail = nullptr;
+    slot->nextfree = nullptr;
+    return slot + 1;
+}
+
+//
+// P_FreeThinker
+// Returns a thinker that is no longer in the list to its pool.
+//
+void P_FreeThinker(thinker_t* thinker)
+{
+    auto* slot = reinterpret_cast<thinkerslot_t*>(thinker) - 1;
+    auto& p = thinkerpools[slot->pool];
+    slot->nextfree = nullptr;
+    if (p.freedtail)
+        p.freedtail->nextfree = slot;
+    else
+        p.freed = slot;
+    p.freedtail = slot;
+}
+
+//
+// P_ReuseFreedThinkers
+// The slots freed since the last call go to the back of their pools.
+//
+void P_ReuseFreedThinkers()
+{
+    for (auto& p : thinkerpools)
+    {
+        if (!p.freed)
+            continue;
+
+        if (p.freetail)
+            p.freetail->nextfree = p.freed;
+        else
+            p.free = p.freed;
+        p.freetail = p.freedtail;
+        p.freed = p.freedtail = nullptr;
+    }
+}
+
+//
+// P_ThinkerPool
 //
-void P_AllocateThinker([[maybe_unused]] thinker_t* thinker)
-{}
+int32 P_ThinkerPool(const thinker_t* thinker)
+{
+    return (reinterpret_cast<const thinkerslot_t*>(thinker) - 1)->pool;
+}
+
+//
+// P_ClearThinkerPools
+// The slabs are PU_LEVEL blocks, call after Z_FreeTags.
+//
+void P_ClearThinkerPools()
+{
+    for (auto& p : thinkerpools)
+        p.free = p.freetail = p.freed = p.freedtail = nullptr;
+}
 
 //
 // P_RunThinkers
+// Same order and the same lazy removal as walking the list: a removed
+// thinker is unlinked and freed when its turn comes, and thinkers
+// added while running still get their turn this tic. Survivors are
+// compacted in place as the walk goes.
 //
 void P_RunThinkers()
 {
-    thinker_t* currentthinker = thinkercap.next;
-    while (currentthinker != &thinkercap)
+    int32 live = 0;
+    for (int32 n = 0; n < thinkerorder.size(); ++n)
     {
+        auto* currentthinker = thinkerorder[n];
         if (currentthinker->function.acv == (actionf_v)(-1))
         {
             // time to remove it
             currentthinker->next->prev = currentthinker->prev;
             currentthinker->prev->next = currentthinker->next;
-            Z_Free(currentthinker);
+            P_FreeThinker(currentthinker);
+            continue;
         }
-        else
-        {
-            if (currentthinker->function.acp1)
-                currentthinker->function.acp1(reinterpret_cast<mobj_t*>(currentthinker));
-        }
-        currentthinker = currentthinker->next;
+
+        // Store before thinking, the call can append and reallocate.
+        thinkerorder[live++] = currentthinker;
+        if (currentthinker->function.acp1)
+            currentthinker->function.acp1(reinterpret_cast<mobj_t*>(currentthinker));
     }
+    thinkerorder.resize(live);
+
+    P_ReuseFreedThinkers();
 }
 
 //
@@ -115,6 +255,11 @@ void P_Ticker()
 {
     int		i;
 
+    // Whatever moves this tic, -uncapped draws it from here. Done even
+    //  when paused, so the view stays put then.
+    if (interpolating)
+        P_ResetInterpolation();
+
     // run the tic
     if (paused)
         return;
@@ -129,6 +274,8 @@ void P_Ticker()
     }
 
 
+    P_NewSightTic();
+
     for (i = 0; i < MAXPLAYERS; i++)
         if (playeringame[i])
             P_PlayerThink(&players[i]);
@@ -140,3 +287,78 @@ void P_Ticker()
     // for par times
     leveltime++;
 }
+
+//
+// P_ResetInterpolation
+// Makes where everything is now where the -uncapped view interpolates
+// from, as at the start of each tic, and when a level starts or a game
+// is loaded, where nothing should be seen moving.
+//
+void P_ResetInterpolation()
+{
+    for (int32 i = 0; i < numsectors; ++i)
+    {
+        sectors[i].oldfloorheight = sectors[i].floorheight;
+        sectors[i].oldceilingheight = sectors[i].ceilingheight;
+    }
+
+    for (auto* th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        if (th->function.acp1 == P_MobjThinker)
+            reinterpret_cast<mobj_t*>(th)->ResetInterpolation();
+    }
+
+    for (auto& player : players)
+        player.oldviewz = player.viewz;
+}
+
+//
+// P_Checksum
+// Hashes the simulation state that demo sync depends on: random index,
+// level time, sector planes and every mobj. Used by the timedemo report
+// to compare runs.
+//
+extern int prndindex;
+
+uint32 P_Checksum()
+{
+    uint32 hash = 2166136261u;
+    auto mix = [&hash](int32 value)
+    {
+        for (int32 n = 0; n < 4; ++n, value >>= 8)
+            hash = (hash ^ (value & 0xff)) * 16777619u;
+    };
+
+    mix(prndindex);
+    mix(leveltime);
+
+    for (int32 i = 0; i < numsectors; ++i)
+    {
+        mix(sectors[i].floorheight);
+        mix(sectors[i].ceilingheight);
+        mix(sectors[i].lightlevel);
+        mix(sectors[i].special);
+    }
+
+    for (auto* th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        if (th->function.acp1 != P_MobjThinker)
+            continue;
+
+        auto* mo = reinterpret_cast<mobj_t*>(th);
+        mix(mo->type);
+        mix(mo->x);
+        mix(mo->y);
+        mix(mo->z);
+        mix(static_cast<int32>(mo->angle));
+        mix(mo->momx);
+        mix(mo->momy);
+        mix(mo->momz);
+        mix(mo->health);
+        mix(mo->flags);
+        mix(mo->tics);
+        mix(static_cast<int32>(mo->state - states));
+    }
+
+    return hash;
+}
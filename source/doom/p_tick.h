@@ -18,3 +18,6 @@
 // can call G_PlayerExited.
 // Carries out all thinking of monsters and players.
 void P_Ticker();
+
+// Hash of the current playsim state, for comparing demo runs.
+uint32 P_Checksum();
@@ -0,0 +1,98 @@
+export module traverse;
+
+import std;
+import nstd;
+
+export {
+
+// Visits intercepts the way P_TraverseIntercepts always has: the nearest one still unvisited is
+// picked by scanning them all, so a trace with n intercepts costs O(n^2). Ties go to the one
+// added first. The frac of each visited intercept is overwritten to take it out of the running.
+// Returns false if visit did.
+template<typename T, typename Visit>
+bool TraverseByScan(T* first, T* last, int32 maxfrac, Visit&& visit)
+{
+    for (auto count = last - first; count--; )
+    {
+        T* in = nullptr;
+        auto dist = std::numeric_limits<int32>::max();
+        for (auto* scan = first; scan < last; ++scan)
+        {
+            if (scan->frac < dist)
+            {
+                dist = scan->frac;
+                in = scan;
+            }
+        }
+
+        if (dist > maxfrac)
+            return true;
+
+        if (!visit(in))
+            return false;
+
+        in->frac = std::numeric_limits<int32>::max();
+    }
+    return true;
+}
+
+// Visits the same intercepts in the same order as TraverseByScan, ties included, without
+// rescanning for every one. Most traces stop at one of the first few (a hitscan at the first
+// wall), so those are still found by scanning. Whatever's left within maxfrac then goes into a
+// min-heap keyed on frac then index, built in O(n) and popped one at a time. heap is scratch
+// space kept by the caller so its capacity carries over between traces. Visited fracs are
+// overwritten in both phases, like TraverseByScan does. Returns false if visit did.
+template<typename T, typename Visit>
+bool TraverseInOrder(T* first, T* last, int32 maxfrac, vector<uint64>& heap, Visit&& visit)
+{
+    constexpr int32 Scans = 4;
+
+    for (int32 n = 0; n < Scans; ++n)
+    {
+        T* in = nullptr;
+        auto dist = std::numeric_limits<int32>::max();
+        for (auto* scan = first; scan < last; ++scan)
+        {
+            if (scan->frac < dist)
+            {
+                dist = scan->frac;
+                in = scan;
+            }
+        }
+
+        if (dist > maxfrac)
+            return true;
+
+        if (!visit(in))
+            return false;
+
+        in->frac = std::numeric_limits<int32>::max();
+    }
+
+    heap.clear();
+    for (auto* in = first; in < last; ++in)
+    {
+        if (in->frac > maxfrac)
+            continue;
+
+        // Flipping the sign bit makes the signed fracs order correctly as unsigned.
+        auto frac = static_cast<uint32>(in->frac) ^ 0x80000000u;
+        heap.push_back(static_cast<uint64>(frac) << 32 | static_cast<uint32>(in - first));
+    }
+
+    std::ranges::make_heap(heap, std::greater<>{});
+    while (!heap.empty())
+    {
+        std::ranges::pop_heap(heap, std::greater<>{});
+        auto index = static_cast<int32>(heap.back() & 0xffffffff);
+        heap.pop_back();
+
+        if (!visit(first + index))
+            return false;
+
+        first[index].frac = std::numeric_limits<int32>::max();
+    }
+    return true;
+}
+
+} // export
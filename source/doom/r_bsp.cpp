@@ -30,6 +30,7 @@ import std;
 // State.
 #include "doomstat.h"
 #include "r_state.h"
+#include "r_pipeline.h"
 
 
 seg_t* curline;
@@ -38,7 +39,7 @@ line_t* linedef;
 sector_t* frontsector;
 sector_t* backsector;
 
-drawseg_t	drawsegs[MAXDRAWSEGS];
+frame_arena<drawseg_t> drawsegs{MAXDRAWSEGS};
 drawseg_t* ds_p;
 
 
@@ -55,7 +56,7 @@ R_StoreWallRange
 //
 void R_ClearDrawSegs()
 {
-    ds_p = drawsegs;
+    ds_p = drawsegs.data();
 }
 
 
@@ -73,7 +74,9 @@ typedef	struct
 } cliprange_t;
 
 
-#define MAXSEGS		32
+// Solid segs alternate with gaps at least a column wide, so this many
+// always fit.
+#define MAXSEGS		(MAXWIDTH / 2 + 2)
 
 // newend is one past the last valid seg
 cliprange_t* newend;
@@ -297,7 +300,7 @@ void R_AddLine(seg_t* line)
     if (x1 == x2)
         return;
 
-    backsector = line->backsector;
+    backsector = R_ViewSector(line->backsector);
 
     // Single sided line?
     if (!backsector)
@@ -320,7 +323,7 @@ void R_AddLine(seg_t* line)
     if (backsector->ceilingpic == frontsector->ceilingpic
         && backsector->floorpic == frontsector->floorpic
         && backsector->lightlevel == frontsector->lightlevel
-        && curline->sidedef->midtexture == 0)
+        && R_ViewSide(curline->sidedef)->midtexture == 0)
     {
         return;
     }
@@ -461,7 +464,7 @@ void R_Subsector(int num)
 
     sscount++;
     sub = &subsectors[num];
-    frontsector = sub->sector;
+    frontsector = R_ViewSector(sub->sector);
     count = sub->numlines;
     line = &segs[sub->firstline];
 
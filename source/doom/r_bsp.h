@@ -17,6 +17,8 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+import arena;
+
 extern seg_t* curline;
 extern side_t* sidedef;
 extern line_t* linedef;
@@ -32,7 +34,7 @@ extern bool		segtextured;
 extern bool		markfloor;
 extern bool		markceiling;
 
-extern drawseg_t	drawsegs[MAXDRAWSEGS];
+extern frame_arena<drawseg_t> drawsegs;
 extern drawseg_t* ds_p;
 
 extern lighttable_t** hscalelight;
@@ -34,9 +34,13 @@ import std;
 #include "r_sky.h"
 
 #include "r_data.h"
+#include "r_pipeline.h"
 
 #include <malloc.h>
 
+import config;
+import jobs;
+
 
 // Graphics.
 // DOOM graphics for walls and sprites
@@ -121,6 +125,7 @@ int* texturecompositesize;
 short** texturecolumnlump;
 unsigned short** texturecolumnofs;
 byte** texturecomposite;
+byte** textureatlas;
 
 // for global animation
 int* flattranslation;
@@ -192,12 +197,14 @@ R_DrawColumnInCache
 
 
 //
-// R_GenerateComposite
+// R_DrawComposite
 // Using the texture definition,
-//  the composite texture is created from the patches,
-//  and each column is cached.
+//  the composite texture is drawn from the patches
+//  into a block of texturecompositesize bytes.
+// Only reads shared data, so several textures
+//  can be drawn at once on different threads.
 //
-void R_GenerateComposite(int texnum)
+static void R_DrawComposite(int texnum, byte* block)
 {
     texture_t* texture;
     texpatch_t* patch;
@@ -211,14 +218,10 @@ void R_GenerateComposite(int texnum)
 
     texture = textures[texnum];
 
-    auto block = static_cast<byte*>(Z_Malloc(texturecompositesize[texnum], PU_STATIC, &texturecomposite[texnum]));
-
     collump = texturecolumnlump[texnum];
     colofs = texturecolumnofs[texnum];
 
     // Composite the columns together.
-    patch = texture->patches;
-
     for (i = 0, patch = texture->patches;
         i < texture->patchcount;
         i++, patch++)
@@ -248,8 +251,18 @@ void R_GenerateComposite(int texnum)
                 patch->originy,
                 texture->height);
         }
-
     }
+}
+
+//
+// R_GenerateComposite
+// Builds a composite on first use and caches it.
+//
+void R_GenerateComposite(int texnum)
+{
+    auto block = static_cast<byte*>(Z_Malloc(texturecompositesize[texnum], PU_STATIC, &texturecomposite[texnum]));
+
+    R_DrawComposite(texnum, block);
 
     // Now that the texture has been built in column cache,
     //  it is purgable from zone memory.
@@ -320,6 +333,29 @@ void R_GenerateLookup(int texnum)
     }
 }
 
+// With -renderthreads the columns are only drawn once the whole view
+// has been queued, so a composite read by a queued column must not be
+// purged to make room for one built later in the frame. Every composite
+// used while queueing is held PU_STATIC until the strips are drawn.
+// The -pipeline composites aren't in the zone and are never purged.
+static bool compositepinning;
+static vector<bool> compositepinned;
+static vector<int32> pinnedcomposites;
+
+void R_PinComposites()
+{
+    compositepinning = !renderpipeline;
+    compositepinned.assign(numtextures, false);
+}
+
+void R_UnpinComposites()
+{
+    compositepinning = false;
+    for (auto texnum : pinnedcomposites)
+        Z_ChangeTag(texturecomposite[texnum], PU_CACHE);
+    pinnedcomposites.clear();
+}
+
 const byte* R_GetColumn(int tex, int col)
 {
     int		lump;
@@ -335,6 +371,13 @@ const byte* R_GetColumn(int tex, int col)
     if (!texturecomposite[tex])
         R_GenerateComposite(tex);
 
+    if (compositepinning && !compositepinned[tex])
+    {
+        compositepinned[tex] = true;
+        pinnedcomposites.push_back(tex);
+        Z_ChangeTag(texturecomposite[tex], PU_STATIC);
+    }
+
     return texturecomposite[tex] + ofs;
 }
 
@@ -348,10 +391,7 @@ void R_InitTextures()
     vector<int32> patchLookup(nummappatches);
 
     for (int i = 0; i < nummappatches; i++)
-    {
-        string name{name_p + i * 8, 8};
-        patchLookup[i] = WadManager::GetLumpId(name.trim().to_upper());
-    }
+        patchLookup[i] = WadManager::GetLumpId({name_p + i * 8, 8}, LumpNamespace::Patches);
 
     // Load the map texture definitions from textures.lmp.
     // The data is contained in one or two lumps, TEXTURE1 for shareware, plus TEXTURE2 for commercial.
@@ -382,6 +422,8 @@ void R_InitTextures()
     texturecolumnofs = Z_Malloc<unsigned short*>(numtextures * sizeof(unsigned short*), PU_STATIC, 0);
     texturecomposite = Z_Malloc<byte*>(numtextures * sizeof(byte*), PU_STATIC, 0);
     texturecompositesize = Z_Malloc<int>(numtextures * sizeof(int), PU_STATIC, 0);
+    textureatlas = Z_Malloc<byte*>(numtextures * sizeof(byte*), PU_STATIC, 0);
+    std::fill(textureatlas, textureatlas + numtextures, nullptr);
     texturewidthmask = Z_Malloc<int>(numtextures * sizeof(int), PU_STATIC, 0);
     textureheight = Z_Malloc<fixed_t>(numtextures * sizeof(fixed_t), PU_STATIC, 0);
 
@@ -531,7 +573,7 @@ void R_InitData()
 int32 R_FlatNumForName(string_view name)
 {
     name = name.substr(0, 8);
-    auto i = WadManager::GetLumpId(name);
+    auto i = WadManager::GetLumpId(name, LumpNamespace::Flats);
     if (i == INVALID_ID)
     {
         I_Error("R_FlatNumForName: {} not found", name);
@@ -571,6 +613,159 @@ int32 R_TextureNumForName(string_view name)
     return i;
 }
 
+// The wall textures the level's sidedefs use, and the sky.
+static vector<bool> R_LevelTextures()
+{
+    vector<bool> needed(numtextures);
+    for (int32 i = 0; i < numsides; i++)
+    {
+        needed[sides[i].toptexture] = true;
+        needed[sides[i].midtexture] = true;
+        needed[sides[i].bottomtexture] = true;
+    }
+    needed[skytexture] = true;
+    return needed;
+}
+
+// The composites with -pipeline, which the zone knows nothing of.
+static vector<vector<byte>> pipelinecomposites;
+
+//
+// R_GenerateLevelComposites
+// Builds every composite the level's sidedefs and sky use before the
+// first frame, instead of in R_GetColumn the first time each one is
+// seen. The blocks come from the zone here, one thread at a time, and
+// only the drawing is spread over a thread pool (-compositethreads,
+// the number of hardware threads by default). They take no more than
+// half of what the zone has free or purgable, so the rest of the level
+// still fits, and what doesn't fit is left to R_GetColumn.
+// With -pipeline the render thread can't go to the zone, so every
+// composite is built the first time, outside the zone, and stays for
+// good.
+//
+void R_GenerateLevelComposites()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    auto needed = R_LevelTextures();
+    auto budget = Z_FreeMemory() / 2;
+    vector<int32> pending;
+    int32 skipped = 0;
+    pipelinecomposites.resize(renderpipeline ? numtextures : 0);
+    for (int32 i = 0; i < numtextures; i++)
+    {
+        if (renderpipeline)
+        {
+            // One already in the zone, from before the first level, goes
+            //  too, or it could be purged under the render thread.
+            if (texturecompositesize[i] > 0 && pipelinecomposites[i].empty())
+            {
+                if (texturecomposite[i])
+                    Z_Free(texturecomposite[i]);
+                pending.push_back(i);
+            }
+        }
+        else if (needed[i] && texturecompositesize[i] > 0 && !texturecomposite[i])
+        {
+            auto size = static_cast<intptr_t>(texturecompositesize[i] + sizeof(memblock_t));
+            if (size > budget)
+            {
+                ++skipped;
+                continue;
+            }
+            budget -= size;
+            pending.push_back(i);
+        }
+    }
+
+    // PU_STATIC until they're all drawn,
+    //  so making room for one can't purge another.
+    for (auto texnum : pending)
+    {
+        if (renderpipeline)
+        {
+            pipelinecomposites[texnum].resize(texturecompositesize[texnum]);
+            texturecomposite[texnum] = pipelinecomposites[texnum].data();
+        }
+        else
+            Z_Malloc(texturecompositesize[texnum], PU_STATIC, &texturecomposite[texnum]);
+    }
+
+    auto threads = CommandLine::GetValue<int32>("-compositethreads", std::max(1u, std::thread::hardware_concurrency()));
+    jobs::thread_pool pool{std::min(threads, std::max(pending.size(), 1))};
+    pool.run(pending.size(), [&](int32 n)
+    {
+        R_DrawComposite(pending[n], texturecomposite[pending[n]]);
+    });
+
+    if (!renderpipeline)
+    {
+        for (auto texnum : pending)
+            Z_ChangeTag(texturecomposite[texnum], PU_CACHE);
+    }
+
+    if (CommandLine::HasArg("-setuptimes"))
+    {
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::format("R_GenerateLevelComposites: {} composites in {:.2f} ms ({} threads), {} left for later\n", pending.size(), ms, pool.size(), skipped);
+    }
+}
+
+//
+// R_BuildTextureAtlas
+// With -texatlas, every wall texture the level uses is expanded into
+// one block, ATLASCOLUMN bytes per column, so R_GetWallColumn finds a
+// column with a multiply-add and neighbouring columns sit next to each
+// other. A texture shorter than that is repeated down the column, where
+// the patch data used to run on into whatever followed it. Textures
+// that come into use later, from switches and animations, aren't in the
+// atlas and go through R_GetColumn.
+//
+static vector<byte> atlas;
+int		atlasmemory;
+
+void R_BuildTextureAtlas()
+{
+    std::fill(textureatlas, textureatlas + numtextures, nullptr);
+    atlas.clear();
+    atlasmemory = 0;
+
+    if (!CommandLine::HasArg("-texatlas"))
+        return;
+
+    auto needed = R_LevelTextures();
+    int32 count = 0;
+    for (int32 i = 0; i < numtextures; i++)
+    {
+        if (!needed[i])
+            continue;
+
+        atlasmemory += textures[i]->width * ATLASCOLUMN;
+        ++count;
+    }
+    atlas.resize(atlasmemory);
+
+    auto* block = atlas.data();
+    for (int32 i = 0; i < numtextures; i++)
+    {
+        if (!needed[i])
+            continue;
+
+        auto height = std::min(textureheight[i] >> FRACBITS, ATLASCOLUMN);
+        for (int32 col = 0; col < textures[i]->width; col++)
+        {
+            auto* source = R_GetColumn(i, col);
+            for (int32 row = 0; row < ATLASCOLUMN; row++)
+                block[col * ATLASCOLUMN + row] = source[row % height];
+        }
+
+        textureatlas[i] = block;
+        block += textures[i]->width * ATLASCOLUMN;
+    }
+
+    std::cout << std::format("R_BuildTextureAtlas: {} textures, {} KB\n", count, atlasmemory / 1024);
+}
+
 // Preloads all relevant graphics for the level.
 int		flatmemory;
 int		texturememory;
@@ -27,9 +27,33 @@ import nstd;
 // Retrieve column data for span blitting.
 const byte* R_GetColumn(int32 tex, int32 col);
 
+// Around a frame queued for -renderthreads, so the composites its
+// columns read stay put until they're drawn.
+void R_PinComposites();
+void R_UnpinComposites();
+
+// Bytes per column in the -texatlas atlas, all R_DrawColumn reads.
+constexpr int32 ATLASCOLUMN = 128;
+
+extern int* texturewidthmask;
+extern byte** textureatlas;
+
+// R_GetColumn for the solid wall and sky drawers, straight into the atlas
+// when the texture is in it. Masked midtextures need the posts around
+// what R_GetColumn returns, so they keep using that.
+inline const byte* R_GetWallColumn(int32 tex, int32 col)
+{
+    if (auto* block = textureatlas[tex])
+        return block + (col & texturewidthmask[tex]) * ATLASCOLUMN;
+
+    return R_GetColumn(tex, col);
+}
+
 // I/O, setting up the stuff.
 void R_InitData();
 void R_PrecacheLevel();
+void R_GenerateLevelComposites();
+void R_BuildTextureAtlas();
 
 // Retrieval.
 // Floor/ceiling opaque texture tiles, lookup by name. For animation?
@@ -36,6 +36,7 @@
 #define SIL_TOP			2
 #define SIL_BOTH		3
 
+// Starting capacity, the drawseg arena grows past it.
 #define MAXDRAWSEGS		256
 
 // INTERNAL MAP TYPES
@@ -106,6 +107,10 @@ typedef	struct
     int			linecount;
     struct line_s** lines;	// [linecount] size
 
+    // Plane heights before this tic, -uncapped draws them in between.
+    fixed_t	oldfloorheight;
+    fixed_t	oldceilingheight;
+
 } sector_t;
 
 // The SideDef.
@@ -320,10 +325,6 @@ struct patch_t
 // I.e. a sprite object that is partly visible.
 typedef struct vissprite_s
 {
-    // Doubly linked list.
-    struct vissprite_s* prev;
-    struct vissprite_s* next;
-
     int			x1;
     int			x2;
 
@@ -411,16 +412,15 @@ typedef struct
     int			minx;
     int			maxx;
 
-    // leave pads for [minx-1]/[maxx+1]
+    // next plane in the same R_FindPlane hash bucket, -1 ends the chain
+    int			next;
 
-    byte		pad1;
-    // Here lies the rub for all
-    //  dynamic resize/change of resolution.
-    byte		top[SCREENWIDTH];
-    byte		pad2;
-    byte		pad3;
-    // See above.
-    byte		bottom[SCREENWIDTH];
-    byte		pad4;
+    // a view width of columns each, from the per-frame column arena,
+    // with pads for [minx-1]/[maxx+1]
+    uint16*		top;
+    uint16*		bottom;
 
 } visplane_t;
+
+// top of a column the plane doesn't cover
+constexpr uint16 NOPLANECOLUMN = 0xffff;
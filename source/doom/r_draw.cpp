@@ -28,16 +28,17 @@
 #include "doomstat.h"
 #include "d_main.h"
 #include "r_main.h"
+#include "r_pipeline.h"
 
 import std;
+import jobs;
+import bench;
+import spans;
 
 
 extern Doom* g_doom;
 
 
-#define MAXWIDTH			1120
-#define MAXHEIGHT			832
-
 // status bar height at bottom of screen
 #define SBARHEIGHT		32
 
@@ -49,11 +50,22 @@ extern Doom* g_doom;
 byte* viewimage;
 int		viewwidth;
 int		scaledviewwidth;
+int		scaledviewheight;
 int		viewheight;
 int		viewwindowx;
 int		viewwindowy;
-byte* ylookup[MAXHEIGHT];
-int		columnofs[MAXWIDTH];
+vector<byte*>	ylookup;
+vector<int>	columnofs;
+
+// The render target. The whole 320x200 screen would be renderwidth by
+// renderheight pixels in it, the view is drawn at that scale. At
+// 320x200 that's screen 0 itself, anything bigger gets a buffer the size
+// of the view, which R_ResolveView scales down into the view window.
+int		renderwidth = SCREENWIDTH;
+int		renderheight = SCREENHEIGHT;
+int		viewpitch = SCREENWIDTH;
+static vector<byte> renderbuffer;
+static vector<int> resolvecolumns;
 
 // Color tables for different players,
 //  translate a limited part to another
@@ -63,15 +75,15 @@ byte		translations[3][256];
 
 
 // Source is the top of the column to scale.
-lighttable_t* dc_colormap;
-int			dc_x;
-int			dc_yl;
-int			dc_yh;
-fixed_t			dc_iscale;
-fixed_t			dc_texturemid;
+thread_local lighttable_t* dc_colormap;
+thread_local int			dc_x;
+thread_local int			dc_yl;
+thread_local int			dc_yh;
+thread_local fixed_t			dc_iscale;
+thread_local fixed_t			dc_texturemid;
 
 // first pixel in a column (possibly virtual) 
-const byte* dc_source;
+thread_local const byte* dc_source;
 
 // just for profiling 
 int			dccount;
@@ -89,7 +101,7 @@ void R_DrawColumn()
         return;
 
 #ifdef RANGECHECK 
-    if (dc_x >= SCREENWIDTH || dc_yl < 0 || dc_yh >= SCREENHEIGHT)
+    if (dc_x >= renderwidth || dc_yl < 0 || dc_yh >= renderheight)
         I_Error("R_DrawColumn: {} to {} at {}", dc_yl, dc_yh, dc_x);
 #endif 
 
@@ -102,14 +114,20 @@ void R_DrawColumn()
     auto fracstep = dc_iscale;
     auto frac = dc_texturemid + (dc_yl - centery) * fracstep;
 
+    // The dc_ state is thread local, keep it out of the loop.
+    auto* colormap = dc_colormap;
+    auto* source = dc_source;
+
+    auto pitch = viewpitch;
+
     // Inner loop that does the actual texture mapping, e.g. a DDA-lile scaling.
     // This is as fast as it gets.
     do
     {
         // Re-map color indices from wall texture column using a lighting/special effects LUT.
-        *dest = dc_colormap[dc_source[(frac >> FRACBITS) & 127]];
+        *dest = colormap[source[(frac >> FRACBITS) & 127]];
 
-        dest += SCREENWIDTH;
+        dest += pitch;
         frac += fracstep;
 
     }
@@ -125,7 +143,7 @@ void R_DrawColumnLow()
         return;
 
 #ifdef RANGECHECK 
-    if (dc_x >= SCREENWIDTH || dc_yl < 0 || dc_yh >= SCREENHEIGHT)
+    if (dc_x >= renderwidth || dc_yl < 0 || dc_yh >= renderheight)
         I_Error("R_DrawColumn: {} to {} at {}", dc_yl, dc_yh, dc_x);
 #endif
 
@@ -137,20 +155,24 @@ void R_DrawColumnLow()
 
     auto fracstep = dc_iscale;
     auto frac = dc_texturemid + (dc_yl - centery) * fracstep;
+    auto* colormap = dc_colormap;
+    auto* source = dc_source;
+    auto pitch = viewpitch;
 
     do
     {
-        *dest2 = *dest = dc_colormap[dc_source[(frac >> FRACBITS) & 127]];
+        *dest2 = *dest = colormap[source[(frac >> FRACBITS) & 127]];
 
-        dest += SCREENWIDTH;
-        dest2 += SCREENWIDTH;
+        dest += pitch;
+        dest2 += pitch;
         frac += fracstep;
     }
     while (count--);
 }
 
 // Spectre/Invisibility.
-static const int32 FUZZOFF = SCREENWIDTH;
+// In rows, times viewpitch when used.
+static const int32 FUZZOFF = 1;
 
 int32 fuzzoffset[] =
 {
@@ -163,7 +185,7 @@ int32 fuzzoffset[] =
     FUZZOFF, FUZZOFF,-FUZZOFF, FUZZOFF, FUZZOFF,-FUZZOFF, FUZZOFF
 };
 
-int	fuzzpos = 0;
+thread_local int	fuzzpos = 0;
 
 // Framebuffer postprocessing.
 // Creates a fuzzy image by copying pixels from adjacent ones to left and right.
@@ -186,7 +208,7 @@ void R_DrawFuzzColumn()
         return;
 
 #ifdef RANGECHECK 
-    if (dc_x >= SCREENWIDTH || dc_yl < 0 || dc_yh >= SCREENHEIGHT)
+    if (dc_x >= renderwidth || dc_yl < 0 || dc_yh >= renderheight)
         I_Error("R_DrawFuzzColumn: {} to {} at {}", dc_yl, dc_yh, dc_x);
 #endif
 
@@ -195,6 +217,9 @@ void R_DrawFuzzColumn()
     auto* dest = ylookup[dc_yl] + columnofs[x];
     auto* dest2 = ylookup[dc_yl] + columnofs[x + 1];
 
+    auto pos = fuzzpos;
+    auto pitch = viewpitch;
+
     // Looks like an attempt at dithering, using the colormap #6 (of 0-31, a bit brighter than
     // average).
     do
@@ -202,23 +227,25 @@ void R_DrawFuzzColumn()
         // Lookup framebuffer, and retrieve a pixel that is either one column left or right of
         // the current one.
         // Add index from colormap to index.
-        *dest = colormaps[6 * 256 + dest[fuzzoffset[fuzzpos]]];
+        *dest = colormaps[6 * 256 + dest[fuzzoffset[pos] * pitch]];
         if (detailshift)
-            *dest2 = colormaps[6 * 256 + dest2[fuzzoffset[fuzzpos]]];
+            *dest2 = colormaps[6 * 256 + dest2[fuzzoffset[pos] * pitch]];
 
         // Clamp table lookup index.
-        fuzzpos = (fuzzpos + 1) % std::size(fuzzoffset);
+        pos = (pos + 1) % std::size(fuzzoffset);
 
-        dest += SCREENWIDTH;
-        dest2 += SCREENWIDTH;
+        dest += pitch;
+        dest2 += pitch;
     }
     while (count--);
+
+    fuzzpos = pos;
 }
 
 // Used to draw player sprites with the green colorramp mapped to others.
 // Could be used with different translation tables, e.g. the lighter colored version of the
 // BaronOfHell, the HellKnight, uses identical sprites, kinda brightened up.
-byte* dc_translation;
+thread_local byte* dc_translation;
 byte* translationtables;
 
 void R_DrawTranslatedColumn()
@@ -228,7 +255,7 @@ void R_DrawTranslatedColumn()
         return;
 
 #ifdef RANGECHECK 
-    if (dc_x >= SCREENWIDTH || dc_yl < 0 || dc_yh >= SCREENHEIGHT)
+    if (dc_x >= renderwidth || dc_yl < 0 || dc_yh >= renderheight)
         I_Error("R_DrawTranslatedColumn: {} to {} at {}", dc_yl, dc_yh, dc_x);
 #endif 
 
@@ -242,6 +269,10 @@ void R_DrawTranslatedColumn()
     // Looks familiar.
     auto fracstep = dc_iscale;
     auto frac = dc_texturemid + (dc_yl - centery) * fracstep;
+    auto* colormap = dc_colormap;
+    auto* translation = dc_translation;
+    auto* source = dc_source;
+    auto pitch = viewpitch;
 
     // Here we do an additional index re-mapping.
     do
@@ -249,12 +280,12 @@ void R_DrawTranslatedColumn()
         // Translation tables are used to map certain colorramps to other ones, used with PLAY
         // sprites.
         // Thus the "green" ramp of the player 0 sprite is mapped to gray, red, black/indigo. 
-        *dest = dc_colormap[dc_translation[dc_source[frac >> FRACBITS]]];
+        *dest = colormap[translation[source[frac >> FRACBITS]]];
         if (detailshift)
-            *dest2 = dc_colormap[dc_translation[dc_source[frac >> FRACBITS]]];
+            *dest2 = colormap[translation[source[frac >> FRACBITS]]];
 
-        dest += SCREENWIDTH;
-        dest2 += SCREENWIDTH;
+        dest += pitch;
+        dest2 += pitch;
         frac += fracstep;
     }
     while (count--);
@@ -293,37 +324,42 @@ void R_InitTranslationTables()
 // but a few cases.
 // In consequence, flats are not stored by column (like walls), and the inner loop has to step in
 // texture space u and v.
-int			ds_y;
-int			ds_x1;
-int			ds_x2;
+thread_local int			ds_y;
+thread_local int			ds_x1;
+thread_local int			ds_x2;
 
-lighttable_t* ds_colormap;
+thread_local lighttable_t* ds_colormap;
 
-fixed_t			ds_xfrac;
-fixed_t			ds_yfrac;
-fixed_t			ds_xstep;
-fixed_t			ds_ystep;
+thread_local fixed_t			ds_xfrac;
+thread_local fixed_t			ds_yfrac;
+thread_local fixed_t			ds_xstep;
+thread_local fixed_t			ds_ystep;
 
 // start of a 64*64 tile image 
-const byte* ds_source;
+thread_local const byte* ds_source;
 
 // just for profiling
 int			dscount;
 
+// The kernel R_DrawSpan uses, see R_InitSpanDrawer.
+static spans::kernel spankernel = spans::kernel::scalar;
+static bool spancheck;
+
+void R_InitSpanDrawer(string_view kernel, bool check)
+{
+    spankernel = kernel == "scalar" ? spans::kernel::scalar : spans::best_kernel();
+    spancheck = check;
+    std::cout << std::format("R_InitSpanDrawer: {} spans{}\n", spans::name(spankernel), spancheck ? ", checked against scalar" : "");
+}
+
 // Draws the actual span.
 void R_DrawSpan()
 {
-    fixed_t		xfrac;
-    fixed_t		yfrac;
-    byte* dest;
-    int			count;
-    int			spot;
-
 #ifdef RANGECHECK 
     if (ds_x2 < ds_x1
         || ds_x1<0
-        || ds_x2 >= SCREENWIDTH
-        || (unsigned)ds_y>SCREENHEIGHT)
+        || ds_x2 >= renderwidth
+        || (unsigned)ds_y > (unsigned)renderheight)
     {
         I_Error("R_DrawSpan: {} to {} at {}",
             ds_x1, ds_x2, ds_y);
@@ -331,35 +367,26 @@ void R_DrawSpan()
     //	dscount++; 
 #endif 
 
-
-    xfrac = ds_xfrac;
-    yfrac = ds_yfrac;
-
-    dest = ylookup[ds_y] + columnofs[ds_x1];
+    auto* dest = ylookup[ds_y] + columnofs[ds_x1];
 
     // We do not check for zero spans here?
-    count = ds_x2 - ds_x1;
+    auto count = ds_x2 - ds_x1 + 1;
 
-    do
-    {
-        // Current texture index in u,v.
-        spot = ((yfrac >> (16 - 6)) & (63 * 64)) + ((xfrac >> 16) & 63);
+    spans::draw(spankernel, ds_source, ds_colormap, dest, ds_xfrac, ds_yfrac, ds_xstep, ds_ystep, count);
 
-        // Lookup pixel from flat texture tile,
-        //  re-index using light/colormap.
-        *dest++ = ds_colormap[ds_source[spot]];
-
-        // Next step in u,v.
-        xfrac += ds_xstep;
-        yfrac += ds_ystep;
-
-    } while (count--);
+    if (spancheck)
+    {
+        byte reference[MAXWIDTH];
+        spans::draw_scalar(ds_source, ds_colormap, reference, ds_xfrac, ds_yfrac, ds_xstep, ds_ystep, count);
+        if (std::memcmp(reference, dest, count) != 0)
+            I_Error("R_DrawSpan: {} span differs from scalar, {} to {} at {}", spans::name(spankernel), ds_x1, ds_x2, ds_y);
+    }
 }
 
 void R_DrawSpanLow()
 {
 #ifdef RANGECHECK 
-    if (ds_x2 < ds_x1 || ds_x1 < 0 || ds_x2 >= SCREENWIDTH || ds_y > SCREENHEIGHT)
+    if (ds_x2 < ds_x1 || ds_x1 < 0 || ds_x2 >= renderwidth || ds_y > renderheight)
         I_Error("R_DrawSpanLow: {} to {} at {}", ds_x1, ds_x2, ds_y);
 #endif 
 
@@ -373,40 +400,296 @@ void R_DrawSpanLow()
     auto dest = ylookup[ds_y] + columnofs[ds_x1];
 
     auto count = ds_x2 - ds_x1;
+    auto* colormap = ds_colormap;
+    auto* source = ds_source;
+    auto xstep = ds_xstep;
+    auto ystep = ds_ystep;
     do
     {
         auto spot = ((yfrac >> (16 - 6)) & (63 * 64)) + ((xfrac >> 16) & 63);
         // Lowres/blocky mode does it twice, while scale is adjusted appropriately.
-        *dest++ = ds_colormap[ds_source[spot]];
-        *dest++ = ds_colormap[ds_source[spot]];
+        *dest++ = colormap[source[spot]];
+        *dest++ = colormap[source[spot]];
 
-        xfrac += ds_xstep;
-        yfrac += ds_ystep;
+        xfrac += xstep;
+        yfrac += ystep;
 
     }
     while (count--);
 }
 
+// Queued drawing, for -renderthreads.
+// The refresh still runs on the main thread, but every column and span it would draw is recorded
+// instead, sorted into vertical strips of the view, and the strips are then drawn in parallel.
+// Each pixel gets the same drawer, the same inputs and the same order as when drawing directly,
+// so the frame is identical. Strips can't share pixels: columns, including the fuzz effect's
+// reads above and below, stay in their own x, and spans are cut at the strip edges.
+struct drawcommand_t
+{
+    void (*drawer)();
+    const byte* source;
+    lighttable_t* colormap;
+    byte* translation;
+
+    // Columns only use x1, yl, yh, and xfrac/xstep for texturemid/iscale.
+    int32 x1;
+    int32 x2;
+    int32 yl;
+    int32 yh;
+    fixed_t xfrac;
+    fixed_t yfrac;
+    fixed_t xstep;
+    fixed_t ystep;
+    int32 fuzzpos;
+    bool isSpan;
+};
+
+static std::unique_ptr<jobs::thread_pool> drawpool;
+static vector<vector<drawcommand_t>> drawstrips;
+static int32 stripwidth;
+
+// The real drawers, while the function pointers point at the recorders.
+static void (*drawbasecolfunc)();
+static void (*drawfuzzcolfunc)();
+static void (*drawtranscolfunc)();
+static void (*drawspanfunc)();
+
+static void R_QueueColumn(void (*drawer)())
+{
+    auto& cmd = drawstrips[dc_x / stripwidth].emplace_back();
+    cmd.drawer = drawer;
+    cmd.source = dc_source;
+    cmd.colormap = dc_colormap;
+    cmd.translation = dc_translation;
+    cmd.x1 = cmd.x2 = dc_x;
+    cmd.yl = dc_yl;
+    cmd.yh = dc_yh;
+    cmd.xfrac = dc_texturemid;
+    cmd.xstep = dc_iscale;
+    cmd.fuzzpos = fuzzpos;
+    cmd.isSpan = false;
+}
+
+static void R_QueueBaseColumn()
+{
+    if (dc_yl <= dc_yh)
+        R_QueueColumn(drawbasecolfunc);
+}
+
+static void R_QueueTranslatedColumn()
+{
+    if (dc_yl <= dc_yh)
+        R_QueueColumn(drawtranscolfunc);
+}
+
+// The fuzz table position carries over from one fuzz column to the next, so it has to be
+// advanced here exactly like R_DrawFuzzColumn would have.
+static void R_QueueFuzzColumn()
+{
+    if (!dc_yl)
+        dc_yl = 1;
+
+    if (dc_yh == viewheight - 1)
+        dc_yh = viewheight - 2;
+
+    if (dc_yl > dc_yh)
+        return;
+
+    R_QueueColumn(drawfuzzcolfunc);
+    fuzzpos = (fuzzpos + dc_yh - dc_yl + 1) % std::size(fuzzoffset);
+}
+
+static void R_QueueSpan()
+{
+    for (auto strip = ds_x1 / stripwidth; strip <= ds_x2 / stripwidth; ++strip)
+    {
+        auto& cmd = drawstrips[strip].emplace_back();
+        cmd.drawer = drawspanfunc;
+        cmd.source = ds_source;
+        cmd.colormap = ds_colormap;
+        cmd.translation = nullptr;
+        cmd.x1 = ds_x1;
+        cmd.x2 = ds_x2;
+        cmd.yl = cmd.yh = ds_y;
+        cmd.xfrac = ds_xfrac;
+        cmd.yfrac = ds_yfrac;
+        cmd.xstep = ds_xstep;
+        cmd.ystep = ds_ystep;
+        cmd.fuzzpos = 0;
+        cmd.isSpan = true;
+    }
+}
+
+static void R_DrawStrip(int32 strip)
+{
+    auto left = strip * stripwidth;
+    auto right = left + stripwidth - 1;
+
+    for (auto& cmd : drawstrips[strip])
+    {
+        if (cmd.isSpan)
+        {
+            // Start the span at the strip edge, where the full span would have stepped to.
+            auto x1 = std::max(cmd.x1, left);
+            auto skip = static_cast<uint32>(x1 - cmd.x1);
+
+            ds_y = cmd.yl;
+            ds_x1 = x1;
+            ds_x2 = std::min(cmd.x2, right);
+            ds_source = cmd.source;
+            ds_colormap = cmd.colormap;
+            ds_xfrac = static_cast<fixed_t>(static_cast<uint32>(cmd.xfrac) + skip * static_cast<uint32>(cmd.xstep));
+            ds_yfrac = static_cast<fixed_t>(static_cast<uint32>(cmd.yfrac) + skip * static_cast<uint32>(cmd.ystep));
+            ds_xstep = cmd.xstep;
+            ds_ystep = cmd.ystep;
+        }
+        else
+        {
+            dc_x = cmd.x1;
+            dc_yl = cmd.yl;
+            dc_yh = cmd.yh;
+            dc_source = cmd.source;
+            dc_colormap = cmd.colormap;
+            dc_translation = cmd.translation;
+            dc_texturemid = cmd.xfrac;
+            dc_iscale = cmd.xstep;
+            fuzzpos = cmd.fuzzpos;
+        }
+
+        cmd.drawer();
+    }
+}
+
+void R_InitDrawThreads(int32 count)
+{
+    drawpool.reset();
+    drawstrips.clear();
+
+    if (count <= 1)
+        return;
+
+    // A few strips per thread, so a strip full of sprites doesn't hold up the whole frame.
+    drawpool = std::make_unique<jobs::thread_pool>(count);
+    drawstrips.resize(count * 4);
+    std::cout << std::format("R_InitDrawThreads: {} threads, {} strips\n", count, drawstrips.size());
+}
+
+void R_BeginDrawQueue()
+{
+    if (!drawpool)
+        return;
+
+    stripwidth = (viewwidth + drawstrips.size() - 1) / drawstrips.size();
+    for (auto& strip : drawstrips)
+        strip.clear();
+    R_PinComposites();
+
+    drawbasecolfunc = basecolfunc;
+    drawfuzzcolfunc = fuzzcolfunc;
+    drawtranscolfunc = transcolfunc;
+    drawspanfunc = spanfunc;
+
+    colfunc = basecolfunc = R_QueueBaseColumn;
+    fuzzcolfunc = R_QueueFuzzColumn;
+    transcolfunc = R_QueueTranslatedColumn;
+    spanfunc = R_QueueSpan;
+}
+
+void R_FinishDrawQueue()
+{
+    if (!drawpool)
+        return;
+
+    colfunc = basecolfunc = drawbasecolfunc;
+    fuzzcolfunc = drawfuzzcolfunc;
+    transcolfunc = drawtranscolfunc;
+    spanfunc = drawspanfunc;
+
+    bench::scoped_sample drawSample("render_draw");
+    drawpool->run(drawstrips.size(), R_DrawStrip);
+    R_UnpinComposites();
+}
+
 // Creats lookup tables that avoid multiplies and other hazzles for getting the framebuffer
-// address of a pixel to draw.
+// address of a pixel to draw. width and height are the view in render pixels, the window it
+// goes in on screen is scaledviewwidth by scaledviewheight.
 void R_InitBuffer(int32 width, int32 height)
 {
     // Handle resize, e.g. smaller view windows with border and/or status bar.
-    viewwindowx = (SCREENWIDTH - width) >> 1;
-
-    // Column offset. For windows.
-    for (int32 i = 0; i < width; ++i)
-        columnofs[i] = viewwindowx + i;
+    viewwindowx = (SCREENWIDTH - scaledviewwidth) >> 1;
 
     // Samw with base row offset.
-    if (width == SCREENWIDTH)
+    if (scaledviewwidth == SCREENWIDTH)
         viewwindowy = 0;
     else
-        viewwindowy = (SCREENHEIGHT - SBARHEIGHT - height) >> 1;
+        viewwindowy = (SCREENHEIGHT - SBARHEIGHT - scaledviewheight) >> 1;
+
+    // One extra for the second column of the low detail drawers.
+    columnofs.resize(width + 1);
+    ylookup.resize(height);
+
+    // With -pipeline the view is always drawn into a buffer, the one the render thread is
+    // working on.
+    if (renderwidth == SCREENWIDTH && renderheight == SCREENHEIGHT && !renderpipeline)
+    {
+        renderbuffer.clear();
+        viewpitch = SCREENWIDTH;
+
+        // Column offset. For windows.
+        for (int32 i = 0; i <= width; ++i)
+            columnofs[i] = viewwindowx + i;
+
+        // Preclaculate all row offsets.
+        for (int32 i = 0; i < height; ++i)
+            ylookup[i] = g_doom->GetVideo()->GetScreen(0) + (i + viewwindowy) * SCREENWIDTH;
+        return;
+    }
+
+    viewpitch = width;
+
+    for (int32 i = 0; i <= width; ++i)
+        columnofs[i] = i;
+
+    // The render pixel under the middle of each screen pixel.
+    resolvecolumns.resize(scaledviewwidth);
+    for (int32 x = 0; x < scaledviewwidth; ++x)
+        resolvecolumns[x] = (2 * x + 1) * width / (2 * scaledviewwidth);
+
+    if (renderpipeline)
+        renderbuffer.clear();
+    else
+        R_SetViewBuffer(renderbuffer);
+}
+
+// Sizes buffer for the view and points the row offsets into it.
+void R_SetViewBuffer(vector<byte>& buffer)
+{
+    buffer.resize(viewpitch * ylookup.size());
+    for (int32 i = 0; i < ylookup.size(); ++i)
+        ylookup[i] = buffer.data() + i * viewpitch;
+}
+
+// Scales a view drawn into the render buffer down into its window on screen 0, nearest pixel.
+void R_ResolveView()
+{
+    if (renderbuffer.empty())
+        return;
 
-    // Preclaculate all row offsets.
-    for (int32 i = 0; i < height; ++i)
-        ylookup[i] = g_doom->GetVideo()->GetScreen(0) + (i + viewwindowy) * SCREENWIDTH;
+    R_ResolveViewBuffer(renderbuffer.data());
+}
+
+void R_ResolveViewBuffer(const byte* buffer)
+{
+    bench::scoped_sample resolveSample("render_resolve");
+
+    auto* window = g_doom->GetVideo()->GetScreen(0) + viewwindowy * SCREENWIDTH + viewwindowx;
+    for (int32 y = 0; y < scaledviewheight; ++y)
+    {
+        auto* source = buffer + (2 * y + 1) * viewheight / (2 * scaledviewheight) * viewpitch;
+        auto* dest = window + y * SCREENWIDTH;
+        for (int32 x = 0; x < scaledviewwidth; ++x)
+            dest[x] = source[resolvecolumns[x]];
+    }
 }
 
 // Fills the back screen with a pattern for variable screen sizes
@@ -457,14 +740,14 @@ void R_FillBackScreen()
     patch = WadManager::GetLumpData<patch_t>("BRDR_B");
 
     for (x = 0; x < scaledviewwidth; x += 8)
-        g_doom->GetVideo()->DrawPatch(viewwindowx + x, viewwindowy + viewheight, 1, patch);
+        g_doom->GetVideo()->DrawPatch(viewwindowx + x, viewwindowy + scaledviewheight, 1, patch);
     patch = WadManager::GetLumpData<patch_t>("BRDR_L");
 
-    for (y = 0; y < viewheight; y += 8)
+    for (y = 0; y < scaledviewheight; y += 8)
         g_doom->GetVideo()->DrawPatch(viewwindowx - 8, viewwindowy + y, 1, patch);
     patch = WadManager::GetLumpData<patch_t>("BRDR_R");
 
-    for (y = 0; y < viewheight; y += 8)
+    for (y = 0; y < scaledviewheight; y += 8)
         g_doom->GetVideo()->DrawPatch(viewwindowx + scaledviewwidth, viewwindowy + y, 1, patch);
 
     // Draw beveled edge. 
@@ -472,9 +755,9 @@ void R_FillBackScreen()
 
     g_doom->GetVideo()->DrawPatch(viewwindowx + scaledviewwidth, viewwindowy - 8, 1, WadManager::GetLumpData<patch_t>("BRDR_TR"));
 
-    g_doom->GetVideo()->DrawPatch(viewwindowx - 8, viewwindowy + viewheight, 1, WadManager::GetLumpData<patch_t>("BRDR_BL"));
+    g_doom->GetVideo()->DrawPatch(viewwindowx - 8, viewwindowy + scaledviewheight, 1, WadManager::GetLumpData<patch_t>("BRDR_BL"));
 
-    g_doom->GetVideo()->DrawPatch(viewwindowx + scaledviewwidth, viewwindowy + viewheight, 1, WadManager::GetLumpData<patch_t>("BRDR_BR"));
+    g_doom->GetVideo()->DrawPatch(viewwindowx + scaledviewwidth, viewwindowy + scaledviewheight, 1, WadManager::GetLumpData<patch_t>("BRDR_BR"));
 }
 
 // Copy a screen buffer.
@@ -500,21 +783,21 @@ void R_DrawViewBorder()
     if (scaledviewwidth == SCREENWIDTH)
         return;
 
-    top = ((SCREENHEIGHT - SBARHEIGHT) - viewheight) / 2;
+    top = ((SCREENHEIGHT - SBARHEIGHT) - scaledviewheight) / 2;
     side = (SCREENWIDTH - scaledviewwidth) / 2;
 
     // copy top and one line of left side 
     R_VideoErase(0, top * SCREENWIDTH + side);
 
     // copy one line of right side and bottom 
-    ofs = (viewheight + top) * SCREENWIDTH - side;
+    ofs = (scaledviewheight + top) * SCREENWIDTH - side;
     R_VideoErase(ofs, top * SCREENWIDTH + side);
 
     // copy sides using wraparound 
     ofs = top * SCREENWIDTH + SCREENWIDTH - side;
     side <<= 1;
 
-    for (i = 1; i < viewheight; i++)
+    for (i = 1; i < scaledviewheight; i++)
     {
         R_VideoErase(ofs, side);
         ofs += SCREENWIDTH;
@@ -17,15 +17,15 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
-extern lighttable_t* dc_colormap;
-extern int		dc_x;
-extern int		dc_yl;
-extern int		dc_yh;
-extern fixed_t		dc_iscale;
-extern fixed_t		dc_texturemid;
+extern thread_local lighttable_t* dc_colormap;
+extern thread_local int		dc_x;
+extern thread_local int		dc_yl;
+extern thread_local int		dc_yh;
+extern thread_local fixed_t		dc_iscale;
+extern thread_local fixed_t		dc_texturemid;
 
 // first pixel in a column
-extern const byte* dc_source;
+extern thread_local const byte* dc_source;
 
 
 // The span blitting interface.
@@ -49,22 +49,22 @@ R_VideoErase
 (unsigned	ofs,
     int		count);
 
-extern int		ds_y;
-extern int		ds_x1;
-extern int		ds_x2;
+extern thread_local int		ds_y;
+extern thread_local int		ds_x1;
+extern thread_local int		ds_x2;
 
-extern lighttable_t* ds_colormap;
+extern thread_local lighttable_t* ds_colormap;
 
-extern fixed_t		ds_xfrac;
-extern fixed_t		ds_yfrac;
-extern fixed_t		ds_xstep;
-extern fixed_t		ds_ystep;
+extern thread_local fixed_t		ds_xfrac;
+extern thread_local fixed_t		ds_yfrac;
+extern thread_local fixed_t		ds_xstep;
+extern thread_local fixed_t		ds_ystep;
 
 // start of a 64*64 tile image
-extern const byte* ds_source;
+extern thread_local const byte* ds_source;
 
 extern byte* translationtables;
-extern byte* dc_translation;
+extern thread_local byte* dc_translation;
 
 
 // Span blitting for rows, floor/ceiling.
@@ -74,12 +74,26 @@ void 	R_DrawSpan();
 // Low resolution mode, 160x200?
 void 	R_DrawSpanLow();
 
+// Picks the kernel R_DrawSpan uses: the fastest the CPU has, or the
+// reference one for "scalar". With check, every span is drawn with the
+// reference kernel as well and any difference is an error.
+void R_InitSpanDrawer(string_view kernel, bool check);
+
 
 void
 R_InitBuffer
 (int		width,
     int		height);
 
+// Above 320x200 the view is drawn into a buffer of its own, this
+// scales it into the view window on screen 0 once it's all drawn.
+void R_ResolveView();
+
+// The render thread draws each view into a buffer of the frame it
+// fills (-pipeline), the main thread resolves the finished ones.
+void R_SetViewBuffer(vector<byte>& buffer);
+void R_ResolveViewBuffer(const byte* buffer);
+
 
 // Initialize color translation tables,
 //  for player rendering etc.
@@ -87,6 +101,13 @@ void	R_InitTranslationTables();
 
 
 
+// Multithreaded drawing. With more than one thread, everything drawn between R_BeginDrawQueue
+// and R_FinishDrawQueue is queued up and drawn in parallel strips by the latter. Both are no-ops
+// when running single threaded.
+void R_InitDrawThreads(int32 count);
+void R_BeginDrawQueue();
+void R_FinishDrawQueue();
+
 // Rendering function.
 void R_FillBackScreen();
 
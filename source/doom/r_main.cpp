@@ -28,8 +28,10 @@
 #include "r_things.h"
 #include "r_bsp.h"
 #include "r_plane.h"
+#include "r_pipeline.h"
 
 import std;
+import config;
 
 
 extern Doom* g_doom;
@@ -42,6 +44,7 @@ int			viewangleoffset;
 
 // increment every time a check is made
 int			validcount = 1;
+int			viewvalidcount;
 
 
 lighttable_t* fixedcolormap;
@@ -89,7 +92,7 @@ int			viewangletox[FINEANGLES / 2];
 // The xtoviewangleangle[] table maps a screen pixel
 // to the lowest viewangle that maps back to x ranges
 // from clipangle to -clipangle.
-angle_t			xtoviewangle[SCREENWIDTH + 1];
+vector<angle_t>		xtoviewangle;
 
 
 // UNUSED.
@@ -105,6 +108,11 @@ const fixed_t* finecosine = &finesine[FINEANGLES / 4];
 lighttable_t* scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
 lighttable_t* scalelightfixed[MAXLIGHTSCALE];
 lighttable_t* zlight[LIGHTLEVELS][MAXLIGHTZ];
+fixed_t			lightscalenorm = FRACUNIT;
+
+// The most a wall is scaled up, 64 at 320 wide and as much more as the
+// render is wider, so walls right in front of the player aren't clamped.
+static fixed_t		maxwallscale = 64 * FRACUNIT;
 
 // bumped light from gun blasts
 int			extralight;
@@ -226,10 +234,12 @@ int32 R_PointOnSegSide(fixed_t x, fixed_t y, seg_t* line)
 // To get a global angle from Cartesian coordinates, the coordinates are flipped until they are in
 // the first octant of the coordinate system, then the y (<=x) is scaled and divided by x to get a
 // tangent (slope) value which is looked up in the tantoangle[] table.
-angle_t R_PointToAngle(fixed_t x, fixed_t y)
+// The play simulation calls this too, possibly while the view is drawn on the render thread, so
+// it leaves viewx and viewy alone.
+angle_t R_PointToAngle2(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2)
 {
-    x -= viewx;
-    y -= viewy;
+    auto x = x2 - x1;
+    auto y = y2 - y1;
 
     if ((!x) && (!y))
         return 0;
@@ -284,12 +294,9 @@ angle_t R_PointToAngle(fixed_t x, fixed_t y)
     }
 }
 
-angle_t R_PointToAngle2(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2)
+angle_t R_PointToAngle(fixed_t x, fixed_t y)
 {
-    viewx = x1;
-    viewy = y1;
-
-    return R_PointToAngle(x2, y2);
+    return R_PointToAngle2(viewx, viewy, x, y);
 }
 
 fixed_t R_PointToDist(fixed_t x, fixed_t y)
@@ -371,13 +378,13 @@ fixed_t R_ScaleFromGlobalAngle(angle_t visangle)
     {
         scale = FixedDiv(num, den);
 
-        if (scale > 64 * FRACUNIT)
-            scale = 64 * FRACUNIT;
+        if (scale > maxwallscale)
+            scale = maxwallscale;
         else if (scale < 256)
             scale = 256;
     }
     else
-        scale = 64 * FRACUNIT;
+        scale = maxwallscale;
 
     return scale;
 }
@@ -508,24 +515,48 @@ void Render::RequestSetViewSize(int32 inBlocks, int32 inDetail)
     requestedDetail = inDetail;
 }
 
+// Same as the view size, the new render size is picked up by the next refresh.
+// The view projects across and down with the same scale, so the screen keeps
+// its 320x200 shape, the largest (in steps of 8 wide) that fits the size asked.
+void Render::RequestRenderSize(int32 inWidth, int32 inHeight)
+{
+    auto width = std::clamp(inWidth, SCREENWIDTH, MAXWIDTH);
+    auto height = std::clamp(inHeight, SCREENHEIGHT, MAXHEIGHT);
+    requestedWidth = std::min(width, height * SCREENWIDTH / SCREENHEIGHT) & ~7;
+    requestedHeight = requestedWidth * SCREENHEIGHT / SCREENWIDTH;
+    RequestSetViewSize(screenBlocks, detailLevel);
+}
+
 bool Render::CheckSetViewSize()
 {
     if (!isSetSizeRequested)
         return false;
 
+    R_PausePipeline(false);
+
     if (requestedBlocks == 11)
     {
         scaledviewwidth = SCREENWIDTH;
-        viewheight = SCREENHEIGHT;
+        scaledviewheight = SCREENHEIGHT;
     }
     else
     {
         scaledviewwidth = requestedBlocks * 32;
-        viewheight = (requestedBlocks * 168 / 10) & ~7;
+        scaledviewheight = (requestedBlocks * 168 / 10) & ~7;
+    }
+
+    if (requestedWidth)
+    {
+        renderwidth = requestedWidth;
+        renderheight = requestedHeight;
     }
 
+    // The window at render size, an even width so low detail fills it.
+    auto width = (scaledviewwidth * renderwidth / SCREENWIDTH) & ~1;
+    viewheight = scaledviewheight * renderheight / SCREENHEIGHT;
+
     detailshift = requestedDetail;
-    viewwidth = scaledviewwidth >> detailshift;
+    viewwidth = width >> detailshift;
 
     centery = viewheight / 2;
     centerx = viewwidth / 2;
@@ -548,7 +579,12 @@ bool Render::CheckSetViewSize()
         spanfunc = R_DrawSpanLow;
     }
 
-    R_InitBuffer(scaledviewwidth, viewheight);
+    R_InitBuffer(width, viewheight);
+
+    // Everything sized by the view in render pixels.
+    xtoviewangle.resize(viewwidth + 1);
+    R_ResizeSprites(viewwidth, viewheight);
+    R_ResizePlanes(viewwidth, viewheight);
 
     R_InitTextureMapping();
 
@@ -556,10 +592,6 @@ bool Render::CheckSetViewSize()
     pspritescale = FRACUNIT * viewwidth / SCREENWIDTH;
     pspriteiscale = FRACUNIT * SCREENWIDTH / viewwidth;
 
-    // thing clipping
-    for (int32 i = 0; i < viewwidth; i++)
-        screenheightarray[i] = nstd::size_cast<int16>(viewheight);
-
     // planes
     for (int32 i = 0; i < viewheight; i++)
     {
@@ -580,7 +612,7 @@ bool Render::CheckSetViewSize()
         auto startmap = ((LIGHTLEVELS - 1 - i) * 2) * NUMCOLORMAPS / LIGHTLEVELS;
         for (int32 j = 0; j < MAXLIGHTSCALE; j++)
         {
-            auto level = startmap - j * SCREENWIDTH / (viewwidth << detailshift) / DISTMAP;
+            auto level = startmap - j * SCREENWIDTH / scaledviewwidth / DISTMAP;
 
             if (level < 0)
                 level = 0;
@@ -592,9 +624,18 @@ bool Render::CheckSetViewSize()
         }
     }
 
+    // The wall and sprite scales grow with the render size, lighting
+    // indexes by what they would be at 320 wide.
+    lightscalenorm = FixedDiv(SCREENWIDTH, renderwidth);
+    maxwallscale = static_cast<fixed_t>(int64{64 * FRACUNIT} * renderwidth / SCREENWIDTH);
+
     isSetSizeRequested = false;
     requestedBlocks = 0;
     requestedDetail = 0;
+    requestedWidth = 0;
+    requestedHeight = 0;
+
+    R_ResumePipeline();
     return true;
 }
 
@@ -609,6 +650,12 @@ void Render::Init()
     std::printf("\nR_InitTables");
 
     RequestSetViewSize(screenBlocks, detailLevel);
+
+    int32 width = 0;
+    int32 height = 0;
+    if (CommandLine::TryGetValues("-renderres", width, height))
+        RequestRenderSize(width, height);
+
     R_InitPlanes();
     std::printf("\nR_InitPlanes");
     R_InitLightTables();
@@ -617,8 +664,11 @@ void Render::Init()
     std::printf("\nR_InitSkyMap");
     R_InitTranslationTables();
     std::printf("\nR_InitTranslationsTables");
+    R_InitDrawThreads(CommandLine::GetValue<int32>("-renderthreads", 1));
+    R_InitSpanDrawer(CommandLine::GetValue<string_view>("-spankernel", "best"), CommandLine::HasArg("-spancheck"));
 
     framecount = 0;
+    R_InitPipeline(CommandLine::HasArg("-pipeline"));
 }
 
 subsector_t* R_PointInSubsector(fixed_t x, fixed_t	y)
@@ -675,12 +725,23 @@ void R_SetupFrame(player_t* player)
         fixedcolormap = 0;
 
     framecount++;
-    validcount++;
+
+    // The snapshot's sectors start out unmarked, and framecount is only
+    // ever counted up.
+    viewvalidcount = renderpipeline ? framecount : ++validcount;
+}
+
+// The render thread leaves the network to the main thread.
+static void R_NetUpdate()
+{
+    if (!renderpipeline)
+        NetUpdate();
 }
 
 void R_RenderPlayerView(player_t* player)
 {
     R_SetupFrame(player);
+    R_BeginDrawQueue();
 
     // Clear buffers.
     R_ClearClipSegs();
@@ -689,21 +750,24 @@ void R_RenderPlayerView(player_t* player)
     R_ClearSprites();
 
     // check for new console commands.
-    NetUpdate();
+    R_NetUpdate();
 
     // The head node is the last node output.
     R_RenderBSPNode(numnodes - 1);
 
     // Check for new console commands.
-    NetUpdate();
+    R_NetUpdate();
 
     R_DrawPlanes();
 
     // Check for new console commands.
-    NetUpdate();
+    R_NetUpdate();
 
     R_DrawMasked();
 
     // Check for new console commands.
-    NetUpdate();
+    R_NetUpdate();
+
+    R_FinishDrawQueue();
+    R_ResolveView();
 }
@@ -42,6 +42,11 @@ extern fixed_t		projection;
 
 extern int		validcount;
 
+// What R_AddSprites marks the sectors it's been to with, validcount
+// unless the render thread is drawing (-pipeline), the play simulation
+// has that one.
+extern int		viewvalidcount;
+
 extern int		linecount;
 extern int		loopcount;
 
@@ -66,6 +71,10 @@ extern lighttable_t* scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
 extern lighttable_t* scalelightfixed[MAXLIGHTSCALE];
 extern lighttable_t* zlight[LIGHTLEVELS][MAXLIGHTZ];
 
+// Scales a wall or sprite scale at the render size to what it would be
+// at 320 wide, before it picks a scalelight entry.
+extern fixed_t		lightscalenorm;
+
 extern int		extralight;
 extern lighttable_t* fixedcolormap;
 
@@ -88,6 +97,7 @@ extern	int		detailshift;
 extern void		(*colfunc) ();
 extern void		(*basecolfunc) ();
 extern void		(*fuzzcolfunc) ();
+extern void		(*transcolfunc) ();
 // No shadow effects on floors.
 extern void		(*spanfunc) ();
 
@@ -142,10 +152,16 @@ public:
     void Init();
 
     void RequestSetViewSize(int32 inBlocks, int32 inDetail);
+    // The size the whole 320x200 screen is drawn at, the view is scaled
+    // back down into its window once drawn. Clamped to MAXWIDTH/MAXHEIGHT,
+    // and shrunk to 16:10 inside the size asked for.
+    void RequestRenderSize(int32 inWidth, int32 inHeight);
     bool CheckSetViewSize();
 
 private:
     bool isSetSizeRequested = false;
     int32 requestedBlocks = 0;
     int32 requestedDetail = 0;
+    int32 requestedWidth = 0;
+    int32 requestedHeight = 0;
 };
@@ -0,0 +1,298 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Drawing the 3D view from copies of the level, on a thread of its own
+//	(-pipeline) or between tics (-uncapped).
+//
+//-----------------------------------------------------------------------------
+#include "doomdef.h"
+#include "doomstat.h"
+#include "p_local.h"
+#include "r_main.h"
+#include "r_draw.h"
+#include "r_pipeline.h"
+
+import std;
+import nstd;
+import jobs;
+import bench;
+
+bool renderpipeline;
+
+sector_t* viewsectors;
+side_t* viewsides;
+short* viewlineflags;
+int* viewtexturetranslation;
+int* viewflattranslation;
+vector<int32>* mappedlines;
+
+namespace {
+
+// Everything the view is drawn from, as it was after a batch of tics.
+// The things are copied sector by sector, each sector's thinglist
+// linking its copies in the same order.
+struct snapshot_t
+{
+    uint32 level = 0;
+    vector<sector_t> sectors;
+    vector<side_t> sides;
+    vector<short> lineflags;
+    vector<mobj_t> things;
+    vector<int> texturetranslation;
+    vector<int> flattranslation;
+    player_t player;
+    mobj_t playermobj;
+    bench::clock::time_point tic;
+};
+
+// A finished view, render pixels at the view size it was drawn at.
+struct viewframe_t
+{
+    vector<byte> pixels;
+    vector<int32> mappedlines;
+    uint32 generation = 0;
+    bench::clock::time_point tic;
+};
+
+jobs::triple_buffer<snapshot_t> snapshots;
+jobs::triple_buffer<viewframe_t> frames;
+
+// Bumped by every pause, views drawn before are at a stale size or of
+// an old level. level is bumped for new levels only, the snapshots of
+// the old one can't be drawn anymore.
+std::atomic<uint32> generation = 1;
+std::atomic<uint32> level = 1;
+uint32 publishedlevel = 0;
+
+// The render thread sets drawing before it checks paused, the main
+// thread sets paused before it checks drawing, so one of them always
+// sees the other.
+std::atomic<bool> paused;
+std::atomic<bool> drawing;
+
+// Bumped to wake the render thread, and by the render thread for every
+// view it finishes.
+std::atomic<uint32> wakeups;
+std::atomic<uint32> finished;
+
+std::jthread renderthread;
+
+// The sectors and the things in them, and the player, frac of the way
+// from where they were before the last tic to where they are now.
+void R_CopyLevel(snapshot_t& snapshot, player_t* player, fixed_t frac)
+{
+    auto lerp = [frac](auto from, auto to){ return static_cast<decltype(to)>(from + FixedMul(static_cast<fixed_t>(to - from), frac)); };
+
+    snapshot.sectors.assign(sectors, sectors + numsectors);
+
+    int32 count = 0;
+    for (int32 i = 0; i < numsectors; ++i)
+    {
+        for (auto* thing = sectors[i].thinglist; thing; thing = thing->snext)
+            ++count;
+    }
+
+    // Sized first, the copies are linked to each other.
+    snapshot.things.resize(count);
+    count = 0;
+    for (int32 i = 0; i < numsectors; ++i)
+    {
+        auto& sector = snapshot.sectors[i];
+        sector.validcount = 0;
+        sector.floorheight = lerp(sector.oldfloorheight, sector.floorheight);
+        sector.ceilingheight = lerp(sector.oldceilingheight, sector.ceilingheight);
+
+        auto** link = &sector.thinglist;
+        for (auto* thing = sectors[i].thinglist; thing; thing = thing->snext)
+        {
+            auto& copy = snapshot.things[count++];
+            copy = *thing;
+            copy.x = lerp(copy.oldx, copy.x);
+            copy.y = lerp(copy.oldy, copy.y);
+            copy.z = lerp(copy.oldz, copy.z);
+            copy.angle = lerp(copy.oldangle, copy.angle);
+            *link = &copy;
+            link = &copy.snext;
+        }
+        *link = nullptr;
+    }
+
+    snapshot.player = *player;
+    snapshot.player.viewz = lerp(player->oldviewz, player->viewz);
+    snapshot.playermobj = *player->mo;
+    snapshot.playermobj.x = lerp(player->mo->oldx, player->mo->x);
+    snapshot.playermobj.y = lerp(player->mo->oldy, player->mo->y);
+    snapshot.playermobj.z = lerp(player->mo->oldz, player->mo->z);
+    snapshot.playermobj.angle = lerp(player->mo->oldangle, player->mo->angle);
+    snapshot.player.mo = &snapshot.playermobj;
+}
+
+void R_DrawSnapshot(snapshot_t& snapshot, viewframe_t& frame)
+{
+    viewsectors = snapshot.sectors.data();
+    viewsides = snapshot.sides.data();
+    viewlineflags = snapshot.lineflags.data();
+    viewtexturetranslation = snapshot.texturetranslation.data();
+    viewflattranslation = snapshot.flattranslation.data();
+
+    frame.mappedlines.clear();
+    mappedlines = &frame.mappedlines;
+
+    R_SetViewBuffer(frame.pixels);
+    R_RenderPlayerView(&snapshot.player);
+    frame.tic = snapshot.tic;
+}
+
+void R_RenderThread(std::stop_token stop)
+{
+    std::stop_callback wake{stop, []
+    {
+        ++wakeups;
+        wakeups.notify_all();
+    }};
+
+    uint32 drawn = 0;
+    while (!stop.stop_requested())
+    {
+        auto wake = wakeups.load();
+        drawing = true;
+
+        if (!paused)
+        {
+            auto fresh = snapshots.update();
+            auto& snapshot = snapshots.front();
+            auto current = generation.load();
+
+            if (snapshot.level == level && (fresh || drawn != current))
+            {
+                auto& frame = frames.back();
+                R_DrawSnapshot(snapshot, frame);
+                frame.generation = current;
+                frames.publish();
+                drawn = current;
+
+                drawing = false;
+                drawing.notify_all();
+                ++finished;
+                finished.notify_all();
+                continue;
+            }
+        }
+
+        drawing = false;
+        drawing.notify_all();
+        wakeups.wait(wake);
+    }
+}
+
+} // namespace
+
+void R_InitPipeline(bool enable)
+{
+    renderpipeline = enable;
+    if (renderpipeline)
+        renderthread = std::jthread(R_RenderThread);
+}
+
+void R_ShutdownPipeline()
+{
+    renderthread = {};
+}
+
+void R_PublishSnapshot(player_t* player, fixed_t frac)
+{
+    if (!renderpipeline || !player->mo)
+        return;
+
+    auto& snapshot = snapshots.back();
+    snapshot.level = level;
+    snapshot.tic = bench::clock::now();
+
+    R_CopyLevel(snapshot, player, frac);
+
+    snapshot.sides.assign(sides, sides + numsides);
+    snapshot.lineflags.resize(numlines);
+    for (int32 i = 0; i < numlines; ++i)
+        snapshot.lineflags[i] = lines[i].flags;
+
+    snapshot.texturetranslation.assign(texturetranslation, texturetranslation + numtextures + 1);
+    snapshot.flattranslation.assign(flattranslation, flattranslation + numflats + 1);
+
+    snapshots.publish();
+    publishedlevel = level;
+
+    ++wakeups;
+    wakeups.notify_one();
+}
+
+void R_RenderInterpolatedView(player_t* player, fixed_t frac)
+{
+    static snapshot_t interpolated;
+    R_CopyLevel(interpolated, player, frac);
+
+    viewsectors = interpolated.sectors.data();
+    R_RenderPlayerView(&interpolated.player);
+    viewsectors = nullptr;
+}
+
+void R_PausePipeline(bool newlevel)
+{
+    if (!renderpipeline)
+        return;
+
+    paused = true;
+    while (drawing)
+        drawing.wait(true);
+
+    ++generation;
+    if (newlevel)
+        ++level;
+}
+
+void R_ResumePipeline()
+{
+    if (!renderpipeline)
+        return;
+
+    paused = false;
+    ++wakeups;
+    wakeups.notify_one();
+}
+
+std::optional<bench::clock::time_point> R_PresentView()
+{
+    // The first view of a level or a view size is waited for, if the
+    // render thread has something to draw it from.
+    auto current = generation.load();
+    for (;;)
+    {
+        auto done = finished.load();
+        frames.update();
+        if (frames.front().generation == current || publishedlevel != level)
+            break;
+
+        finished.wait(done);
+    }
+
+    auto& frame = frames.front();
+    if (frame.generation != current)
+        return std::nullopt;
+
+    for (auto line : frame.mappedlines)
+        lines[line].flags |= ML_MAPPED;
+    frame.mappedlines.clear();
+
+    R_ResolveViewBuffer(frame.pixels.data());
+    return frame.tic;
+}
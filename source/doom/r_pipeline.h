@@ -0,0 +1,96 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Drawing the 3D view from copies of the level, on a thread of its own
+//	(-pipeline) or between tics (-uncapped).
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include "d_player.h"
+#include "r_defs.h"
+#include "r_state.h"
+
+import std;
+import nstd;
+
+// With -pipeline the play simulation hands a copy of everything the
+// view is drawn from (the sectors with the things in them, the sides,
+// the line flags, the animated texture translations and the player) to
+// a render thread after its tics, and goes on with the next ones while
+// the view is drawn. The main thread shows the newest finished view
+// instead of drawing one itself.
+extern bool renderpipeline;
+
+// What the renderer reads the level state through. All nullptr, the
+// live level, unless the render thread is drawing a snapshot.
+extern sector_t* viewsectors;
+extern side_t* viewsides;
+extern short* viewlineflags;
+extern int* viewtexturetranslation;
+extern int* viewflattranslation;
+
+// Lines the render thread would have marked ML_MAPPED, the main thread
+// marks them once it takes the view. nullptr when not pipelined.
+extern vector<int32>* mappedlines;
+
+inline sector_t* R_ViewSector(sector_t* sector)
+{
+    return viewsectors && sector ? viewsectors + (sector - sectors) : sector;
+}
+
+inline side_t* R_ViewSide(side_t* side)
+{
+    return viewsides ? viewsides + (side - sides) : side;
+}
+
+inline int R_LineFlags(const line_t* line)
+{
+    return viewlineflags ? viewlineflags[line - lines] : line->flags;
+}
+
+inline int R_TextureTranslation(int texture)
+{
+    return viewtexturetranslation ? viewtexturetranslation[texture] : texturetranslation[texture];
+}
+
+inline int R_FlatTranslation(int flat)
+{
+    return viewflattranslation ? viewflattranslation[flat] : flattranslation[flat];
+}
+
+// Starts the render thread when enabled.
+void R_InitPipeline(bool enable);
+void R_ShutdownPipeline();
+
+// Copies the level as it is after this batch of tics for the render
+// thread, seen from player. With -uncapped the heights and positions
+// are frac of the way from the previous tic to the last one.
+void R_PublishSnapshot(player_t* player, fixed_t frac);
+
+// -uncapped without -pipeline: draws the view from a copy of the
+// sectors and things frac of the way from the previous tic to the last.
+void R_RenderInterpolatedView(player_t* player, fixed_t frac);
+
+// Waits for the render thread to finish the view it's drawing and keeps
+// it from starting another, while the view size or the level changes
+// under it. Views drawn before are thrown away, and with newlevel the
+// snapshots of the old level too.
+void R_PausePipeline(bool newlevel);
+void R_ResumePipeline();
+
+// Puts the newest finished view in its window on screen 0. Returns when
+// the play simulation finished the tics it shows, or nothing if there's
+// no view for the current level and view size yet.
+std::optional<std::chrono::steady_clock::time_point> R_PresentView();
@@ -30,8 +30,10 @@
 #include "r_draw.h"
 #include "r_bsp.h"
 #include "r_things.h"
+#include "r_pipeline.h"
 
 import std;
+import bench;
 
 
 planefunction_t		floorfunc;
@@ -42,16 +44,36 @@ planefunction_t		ceilingfunc;
 //
 
 // Here comes the obnoxious "visplane".
+// Starting capacity, the arena grows past it.
 #define MAXVISPLANES	128
-visplane_t		visplanes[MAXVISPLANES];
+frame_arena<visplane_t> visplanes{MAXVISPLANES};
 visplane_t* lastvisplane;
 visplane_t* floorplane;
 visplane_t* ceilingplane;
 
-// ?
-#define MAXOPENINGS	SCREENWIDTH*64
-short			openings[MAXOPENINGS];
-short* lastopening;
+// The top and bottom columns of the visplanes, they don't move when
+// the visplane arena grows. Each plane takes two view widths and the
+// pads, out of blocks big enough for the widest view.
+#define PLANECOLUMNS	(MAXWIDTH * 2 + 4)
+block_arena<uint16> planecolumns{PLANECOLUMNS * 16};
+int32		planewidth;
+
+// (height, picnum, lightlevel) to the first visplane R_FindPlane made
+// for it this frame, chained through visplane_t::next. A bucket
+// stamped with an older frame is empty, so clearing is one increment.
+#define PLANEHASHSIZE	256
+struct planebucket_t
+{
+    uint32	frame;
+    int32	first;
+};
+planebucket_t	planehash[PLANEHASHSIZE];
+uint32		planeframe;
+
+// The sprite clips and masked texture columns of the drawsegs, which
+// point into it, so the runs don't move as it grows. A run is at most
+// a view width.
+block_arena<short>	openings{MAXWIDTH * 64};
 
 
 //
@@ -59,15 +81,14 @@ short* lastopening;
 //  floorclip starts out SCREENHEIGHT
 //  ceilingclip starts out -1
 //
-short			floorclip[SCREENWIDTH];
-short			ceilingclip[SCREENWIDTH];
+vector<short>		floorclip;
+vector<short>		ceilingclip;
 
 //
 // spanstart holds the start of a plane span
 // initialized to 0 at start
 //
-int			spanstart[SCREENHEIGHT];
-int			spanstop[SCREENHEIGHT];
+vector<int>		spanstart;
 
 //
 // texture mapping
@@ -75,21 +96,37 @@ int			spanstop[SCREENHEIGHT];
 lighttable_t** planezlight;
 fixed_t			planeheight;
 
-fixed_t			yslope[SCREENHEIGHT];
-fixed_t			distscale[SCREENWIDTH];
+vector<fixed_t>		yslope;
+vector<fixed_t>		distscale;
 fixed_t			basexscale;
 fixed_t			baseyscale;
 
-fixed_t			cachedheight[SCREENHEIGHT];
-fixed_t			cacheddistance[SCREENHEIGHT];
-fixed_t			cachedxstep[SCREENHEIGHT];
-fixed_t			cachedystep[SCREENHEIGHT];
+vector<fixed_t>		cachedheight;
+vector<fixed_t>		cacheddistance;
+vector<fixed_t>		cachedxstep;
+vector<fixed_t>		cachedystep;
 
 // Only at game startup.
 void R_InitPlanes()
 {
 }
 
+// When the view size changes.
+void R_ResizePlanes(int32 width, int32 height)
+{
+    planewidth = width;
+    floorclip.resize(width);
+    ceilingclip.resize(width);
+    distscale.resize(width);
+
+    spanstart.resize(height);
+    yslope.resize(height);
+    cachedheight.resize(height);
+    cacheddistance.resize(height);
+    cachedxstep.resize(height);
+    cachedystep.resize(height);
+}
+
 // Uses global vars:
 //  planeheight
 //  ds_source
@@ -161,11 +198,17 @@ void R_ClearPlanes()
         ceilingclip[i] = -1;
     }
 
-    lastvisplane = visplanes;
-    lastopening = openings;
+    lastvisplane = visplanes.data();
+    openings.reset();
+    planecolumns.reset();
+    if (++planeframe == 0)
+    {
+        std::memset(planehash, 0, sizeof(planehash));
+        planeframe = 1;
+    }
 
     // texture calculation
-    std::memset(cachedheight, 0, sizeof(cachedheight));
+    std::fill(cachedheight.begin(), cachedheight.end(), 0);
 
     // left to right mapping
     angle_t	angle = (viewangle - ANG90) >> ANGLETOFINESHIFT;
@@ -175,42 +218,65 @@ void R_ClearPlanes()
     baseyscale = -FixedDiv(finesine[angle], centerxfrac);
 }
 
-visplane_t* R_FindPlane(fixed_t height, int32 picnum, int32 lightlevel)
+//
+// R_NewPlane
+// Takes the next visplane, growing the arena if it's full, and gives
+// it empty columns. pl is moved along with the arena.
+//
+static visplane_t* R_NewPlane(visplane_t*& pl, fixed_t height, int32 picnum, int32 lightlevel)
 {
-    visplane_t* check;
+    if (lastvisplane == visplanes.end())
+        visplanes.grow(lastvisplane, pl, floorplane, ceilingplane);
+
+    auto* plane = lastvisplane++;
+    plane->height = height;
+    plane->picnum = picnum;
+    plane->lightlevel = lightlevel;
+    plane->next = -1;
+
+    // leave pads for [minx-1]/[maxx+1]
+    auto* columns = planecolumns.allocate(planewidth * 2 + 4);
+    plane->top = columns + 1;
+    plane->bottom = columns + planewidth + 3;
+    std::fill_n(plane->top, planewidth, NOPLANECOLUMN);
+
+    return plane;
+}
 
+visplane_t* R_FindPlane(fixed_t height, int32 picnum, int32 lightlevel)
+{
     if (picnum == skyflatnum)
     {
         height = 0;			// all skys map together
         lightlevel = 0;
     }
 
-    for (check = visplanes; check < lastvisplane; check++)
+    auto hash = (static_cast<uint32>(height) * 0x9e3779b1u) ^ (static_cast<uint32>(picnum) * 0x85ebca6bu) ^ static_cast<uint32>(lightlevel);
+    auto& bucket = planehash[(hash ^ (hash >> 16)) & (PLANEHASHSIZE - 1)];
+    if (bucket.frame != planeframe)
     {
+        bucket.frame = planeframe;
+        bucket.first = -1;
+    }
+
+    for (auto index = bucket.first; index != -1; index = visplanes[index].next)
+    {
+        auto* check = &visplanes[index];
         if (height == check->height
             && picnum == check->picnum
             && lightlevel == check->lightlevel)
         {
-            break;
+            return check;
         }
     }
 
-
-    if (check < lastvisplane)
-        return check;
-
-    if (lastvisplane - visplanes == MAXVISPLANES)
-        I_Error("R_FindPlane: no more visplanes");
-
-    lastvisplane++;
-
-    check->height = height;
-    check->picnum = picnum;
-    check->lightlevel = lightlevel;
-    check->minx = SCREENWIDTH;
+    visplane_t* none = nullptr;
+    auto* check = R_NewPlane(none, height, picnum, lightlevel);
+    check->minx = planewidth;
     check->maxx = -1;
 
-    std::memset(check->top, 0xff, sizeof(check->top));
+    check->next = bucket.first;
+    bucket.first = static_cast<int32>(check - visplanes.data());
 
     return check;
 }
@@ -246,7 +312,7 @@ visplane_t* R_CheckPlane(visplane_t* pl, int32 start, int32 stop)
     }
 
     for (x = intrl; x <= intrh; x++)
-        if (pl->top[x] != 0xff)
+        if (pl->top[x] != NOPLANECOLUMN)
             break;
 
     if (x > intrh)
@@ -258,17 +324,11 @@ visplane_t* R_CheckPlane(visplane_t* pl, int32 start, int32 stop)
         return pl;
     }
 
-    // make a new visplane
-    lastvisplane->height = pl->height;
-    lastvisplane->picnum = pl->picnum;
-    lastvisplane->lightlevel = pl->lightlevel;
-
-    pl = lastvisplane++;
+    // make a new visplane, R_FindPlane keeps finding the first one
+    pl = R_NewPlane(pl, pl->height, pl->picnum, pl->lightlevel);
     pl->minx = start;
     pl->maxx = stop;
 
-    memset(pl->top, 0xff, sizeof(pl->top));
-
     return pl;
 }
 
@@ -316,21 +376,10 @@ void R_DrawPlanes()
     int			stop;
     int			angle;
 
-#ifdef RANGECHECK
-    if (ds_p - drawsegs > MAXDRAWSEGS)
-        I_Error("R_DrawPlanes: drawsegs overflow ({})",
-            ds_p - drawsegs);
-
-    if (lastvisplane - visplanes > MAXVISPLANES)
-        I_Error("R_DrawPlanes: visplane overflow ({})",
-            lastvisplane - visplanes);
-
-    if (lastopening - openings > MAXOPENINGS)
-        I_Error("R_DrawPlanes: opening overflow ({})",
-            lastopening - openings);
-#endif
+    bench::peak("visplanes", lastvisplane - visplanes.data());
+    bench::peak("openings", openings.size());
 
-    for (pl = visplanes; pl < lastvisplane; pl++)
+    for (pl = visplanes.data(); pl < lastvisplane; pl++)
     {
         if (pl->minx > pl->maxx)
             continue;
@@ -356,7 +405,7 @@ void R_DrawPlanes()
                 {
                     angle = (viewangle + xtoviewangle[x]) >> ANGLETOSKYSHIFT;
                     dc_x = x;
-                    dc_source = R_GetColumn(skytexture, angle);
+                    dc_source = R_GetWallColumn(skytexture, angle);
                     colfunc();
                 }
             }
@@ -364,7 +413,7 @@ void R_DrawPlanes()
         }
 
         // regular flat
-        ds_source = WadManager::GetLumpData<byte>(firstflat + flattranslation[pl->picnum]);
+        ds_source = WadManager::GetLumpData<byte>(firstflat + R_FlatTranslation(pl->picnum));
 
         planeheight = std::abs(pl->height - viewz);
         light = (pl->lightlevel >> LIGHTSEGSHIFT) + extralight;
@@ -377,8 +426,8 @@ void R_DrawPlanes()
 
         planezlight = zlight[light];
 
-        pl->top[pl->maxx + 1] = 0xff;
-        pl->top[pl->minx - 1] = 0xff;
+        pl->top[pl->maxx + 1] = NOPLANECOLUMN;
+        pl->top[pl->minx - 1] = NOPLANECOLUMN;
 
         stop = pl->maxx + 1;
 
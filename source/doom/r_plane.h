@@ -19,9 +19,11 @@
 
 #include "r_data.h"
 
+import arena;
+
 
 // Visplane related.
-extern  short* lastopening;
+extern  block_arena<short> openings;
 
 
 typedef void (*planefunction_t) (int top, int bottom);
@@ -29,13 +31,16 @@ typedef void (*planefunction_t) (int top, int bottom);
 extern planefunction_t	floorfunc;
 extern planefunction_t	ceilingfunc_t;
 
-extern short		floorclip[SCREENWIDTH];
-extern short		ceilingclip[SCREENWIDTH];
+extern vector<short>	floorclip;
+extern vector<short>	ceilingclip;
 
-extern fixed_t		yslope[SCREENHEIGHT];
-extern fixed_t		distscale[SCREENWIDTH];
+extern vector<fixed_t>	yslope;
+extern vector<fixed_t>	distscale;
 
 void R_InitPlanes();
+// Sizes the per column and per row tables for a view width by height
+// render pixels.
+void R_ResizePlanes(int32 width, int32 height);
 void R_ClearPlanes();
 
 void
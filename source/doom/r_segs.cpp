@@ -27,6 +27,7 @@
 #include "r_things.h"
 #include "r_draw.h"
 #include "r_data.h"
+#include "r_pipeline.h"
 
 import std;
 
@@ -106,9 +107,9 @@ R_RenderMaskedSegRange
     //   for horizontal / vertical / diagonal. Diagonal?
     // OPTIMIZE: get rid of LIGHTSEGSHIFT globally
     curline = ds->curline;
-    frontsector = curline->frontsector;
-    backsector = curline->backsector;
-    texnum = texturetranslation[curline->sidedef->midtexture];
+    frontsector = R_ViewSector(curline->frontsector);
+    backsector = R_ViewSector(curline->backsector);
+    texnum = R_TextureTranslation(R_ViewSide(curline->sidedef)->midtexture);
 
     lightnum = (frontsector->lightlevel >> LIGHTSEGSHIFT) + extralight;
 
@@ -132,7 +133,7 @@ R_RenderMaskedSegRange
     mceilingclip = ds->sprtopclip;
 
     // find positioning
-    if (curline->linedef->flags & ML_DONTPEGBOTTOM)
+    if (R_LineFlags(curline->linedef) & ML_DONTPEGBOTTOM)
     {
         dc_texturemid = frontsector->floorheight > backsector->floorheight
             ? frontsector->floorheight : backsector->floorheight;
@@ -144,7 +145,7 @@ R_RenderMaskedSegRange
             ? frontsector->ceilingheight : backsector->ceilingheight;
         dc_texturemid = dc_texturemid - viewz;
     }
-    dc_texturemid += curline->sidedef->rowoffset;
+    dc_texturemid += R_ViewSide(curline->sidedef)->rowoffset;
 
     if (fixedcolormap)
         dc_colormap = fixedcolormap;
@@ -157,7 +158,7 @@ R_RenderMaskedSegRange
         {
             if (!fixedcolormap)
             {
-                index = spryscale >> LIGHTSCALESHIFT;
+                index = FixedMul(spryscale, lightscalenorm) >> LIGHTSCALESHIFT;
 
                 if (index >= MAXLIGHTSCALE)
                     index = MAXLIGHTSCALE - 1;
@@ -248,7 +249,7 @@ void R_RenderSegLoop()
             texturecolumn = rw_offset - FixedMul(finetangent[angle], rw_distance);
             texturecolumn >>= FRACBITS;
             // calculate lighting
-            index = rw_scale >> LIGHTSCALESHIFT;
+            index = FixedMul(rw_scale, lightscalenorm) >> LIGHTSCALESHIFT;
 
             if (index >= MAXLIGHTSCALE)
                 index = MAXLIGHTSCALE - 1;
@@ -265,7 +266,7 @@ void R_RenderSegLoop()
             dc_yl = yl;
             dc_yh = yh;
             dc_texturemid = rw_midtexturemid;
-            dc_source = R_GetColumn(midtexture, texturecolumn);
+            dc_source = R_GetWallColumn(midtexture, texturecolumn);
             colfunc();
             ceilingclip[rw_x] = viewheight;
             floorclip[rw_x] = -1;
@@ -287,7 +288,7 @@ void R_RenderSegLoop()
                     dc_yl = yl;
                     dc_yh = mid;
                     dc_texturemid = rw_toptexturemid;
-                    dc_source = R_GetColumn(toptexture, texturecolumn);
+                    dc_source = R_GetWallColumn(toptexture, texturecolumn);
                     colfunc();
                     ceilingclip[rw_x] = mid;
                 }
@@ -316,7 +317,7 @@ void R_RenderSegLoop()
                     dc_yl = mid;
                     dc_yh = yh;
                     dc_texturemid = rw_bottomtexturemid;
-                    dc_source = R_GetColumn(bottomtexture, texturecolumn);
+                    dc_source = R_GetWallColumn(bottomtexture, texturecolumn);
                     colfunc();
                     floorclip[rw_x] = mid;
                 }
@@ -347,20 +348,24 @@ void R_RenderSegLoop()
 // A wall segment will be drawn between start and stop pixels (inclusive).
 void R_StoreWallRange(int32 start, int32 stop)
 {
-    // don't overflow and crash
-    if (ds_p == &drawsegs[MAXDRAWSEGS])
-        return;
+    // don't overflow, make room
+    if (ds_p == drawsegs.end())
+        drawsegs.grow(ds_p);
 
 #ifdef RANGECHECK
     if (start >= viewwidth || start > stop)
         I_Error("Bad R_RenderWallRange: {} to {}", start, stop);
 #endif
 
-    sidedef = curline->sidedef;
+    sidedef = R_ViewSide(curline->sidedef);
     linedef = curline->linedef;
+    auto lineflags = R_LineFlags(linedef);
 
     // mark the segment as visible for auto map
-    linedef->flags |= ML_MAPPED;
+    if (!mappedlines)
+        linedef->flags |= ML_MAPPED;
+    else if (!(lineflags & ML_MAPPED))
+        mappedlines->push_back(linedef - lines);
 
     // calculate rw_distance for scale calculation
     rw_normalangle = curline->angle + ANG90;
@@ -404,11 +409,11 @@ void R_StoreWallRange(int32 start, int32 stop)
     if (!backsector)
     {
         // single sided line
-        midtexture = texturetranslation[sidedef->midtexture];
+        midtexture = R_TextureTranslation(sidedef->midtexture);
 
         // a single sided line is terminal, so it must mark ends
         markfloor = markceiling = true;
-        if (linedef->flags & ML_DONTPEGBOTTOM)
+        if (lineflags & ML_DONTPEGBOTTOM)
         {
             auto vtop = frontsector->floorheight + textureheight[sidedef->midtexture];
             // bottom of texture at bottom
@@ -422,8 +427,8 @@ void R_StoreWallRange(int32 start, int32 stop)
         rw_midtexturemid += sidedef->rowoffset;
 
         ds_p->silhouette = SIL_BOTH;
-        ds_p->sprtopclip = screenheightarray;
-        ds_p->sprbottomclip = negonearray;
+        ds_p->sprtopclip = screenheightarray.data();
+        ds_p->sprbottomclip = negonearray.data();
         ds_p->bsilheight = std::numeric_limits<int>::max();
         ds_p->tsilheight = std::numeric_limits<int>::min();
     }
@@ -459,14 +464,14 @@ void R_StoreWallRange(int32 start, int32 stop)
 
         if (backsector->ceilingheight <= frontsector->floorheight)
         {
-            ds_p->sprbottomclip = negonearray;
+            ds_p->sprbottomclip = negonearray.data();
             ds_p->bsilheight = std::numeric_limits<int>::max();
             ds_p->silhouette |= SIL_BOTTOM;
         }
 
         if (backsector->floorheight >= frontsector->ceilingheight)
         {
-            ds_p->sprtopclip = screenheightarray;
+            ds_p->sprtopclip = screenheightarray.data();
             ds_p->tsilheight = std::numeric_limits<int>::min();
             ds_p->silhouette |= SIL_TOP;
         }
@@ -517,8 +522,8 @@ void R_StoreWallRange(int32 start, int32 stop)
         if (worldhigh < worldtop)
         {
             // top texture
-            toptexture = texturetranslation[sidedef->toptexture];
-            if (linedef->flags & ML_DONTPEGTOP)
+            toptexture = R_TextureTranslation(sidedef->toptexture);
+            if (lineflags & ML_DONTPEGTOP)
             {
                 // top of texture at top
                 rw_toptexturemid = worldtop;
@@ -536,9 +541,9 @@ void R_StoreWallRange(int32 start, int32 stop)
         if (worldlow > worldbottom)
         {
             // bottom texture
-            bottomtexture = texturetranslation[sidedef->bottomtexture];
+            bottomtexture = R_TextureTranslation(sidedef->bottomtexture);
 
-            if (linedef->flags & ML_DONTPEGBOTTOM)
+            if (lineflags & ML_DONTPEGBOTTOM)
             {
                 // bottom of texture at bottom
                 // top of texture at top
@@ -555,8 +560,7 @@ void R_StoreWallRange(int32 start, int32 stop)
         {
             // masked midtexture
             maskedtexture = 1;
-            ds_p->maskedtexturecol = maskedtexturecol = lastopening - rw_x;
-            lastopening += rw_stopx - rw_x;
+            ds_p->maskedtexturecol = maskedtexturecol = openings.allocate(rw_stopx - rw_x) - rw_x;
         }
     }
 
@@ -665,17 +669,17 @@ void R_StoreWallRange(int32 start, int32 stop)
     if (((ds_p->silhouette & SIL_TOP) || maskedtexture)
         && !ds_p->sprtopclip)
     {
-        std::memcpy(lastopening, ceilingclip + start, 2 * (rw_stopx - start));
-        ds_p->sprtopclip = lastopening - start;
-        lastopening += rw_stopx - start;
+        auto* clip = openings.allocate(rw_stopx - start);
+        std::memcpy(clip, ceilingclip.data() + start, 2 * (rw_stopx - start));
+        ds_p->sprtopclip = clip - start;
     }
 
     if (((ds_p->silhouette & SIL_BOTTOM) || maskedtexture)
         && !ds_p->sprbottomclip)
     {
-        std::memcpy(lastopening, floorclip + start, 2 * (rw_stopx - start));
-        ds_p->sprbottomclip = lastopening - start;
-        lastopening += rw_stopx - start;
+        auto* clip = openings.allocate(rw_stopx - start);
+        std::memcpy(clip, floorclip.data() + start, 2 * (rw_stopx - start));
+        ds_p->sprbottomclip = clip - start;
     }
 
     if (maskedtexture && !(ds_p->silhouette & SIL_TOP))
@@ -21,6 +21,8 @@
 #include "d_player.h"
 #include "r_data.h"
 
+import nstd;
+
 // Refresh internal data structures,
 //  for rendering.
 
@@ -35,11 +37,23 @@ extern fixed_t* spritetopoffset;
 
 extern lighttable_t* colormaps;
 
+// viewwidth and viewheight are in render pixels, the scaled ones
+// are the size of the view window on the 320x200 screen.
 extern int		viewwidth;
 extern int		scaledviewwidth;
 extern int		viewheight;
+extern int		scaledviewheight;
+
+// The size the whole screen would be drawn at, -renderres.
+#define MAXWIDTH			3840
+#define MAXHEIGHT			2400
+
+extern int		renderwidth;
+extern int		renderheight;
 
 extern int		firstflat;
+extern int		numflats;
+extern int		numtextures;
 
 // for global animation
 extern int* flattranslation;
@@ -96,7 +110,7 @@ extern player_t* viewplayer;
 extern angle_t		clipangle;
 
 extern int		viewangletox[FINEANGLES / 2];
-extern angle_t		xtoviewangle[SCREENWIDTH + 1];
+extern vector<angle_t>	xtoviewangle;
 //extern fixed_t		finetangent[FINEANGLES/2];
 
 extern fixed_t		rw_distance;
@@ -30,8 +30,10 @@
 #include "r_draw.h"
 #include "r_segs.h"
 #include "r_bsp.h"
+#include "r_pipeline.h"
 
 import std;
+import bench;
 
 
 #define MINZ				(FRACUNIT*4)
@@ -56,8 +58,8 @@ int32 pspriteiscale;
 lighttable_t** spritelights;
 
 // constant arrays used for psprite clipping and initializing clipping
-int16 negonearray[SCREENWIDTH];
-int16 screenheightarray[SCREENWIDTH];
+vector<int16> negonearray;
+vector<int16> screenheightarray;
 
 // INITIALIZATION FUNCTIONS
 
@@ -146,7 +148,7 @@ void R_InitSpriteDefs(Doom* doom, const vector<string_view>& names)
             {
                 int frame = lump.name[4] - 'A';
                 int rotation = lump.name[5] - '0';
-                int patched = doom->IsModified() ? W_GetNumForName(lump.name) : l;
+                int patched = doom->IsModified() ? WadManager::GetLumpId(lump.name, LumpNamespace::Sprites) : l;
 
                 R_InstallSpriteLump(name, patched, frame, rotation, false);
 
@@ -200,37 +202,37 @@ void R_InitSpriteDefs(Doom* doom, const vector<string_view>& names)
 //
 // GAME FUNCTIONS
 //
-vissprite_t	vissprites[MAXVISSPRITES];
+frame_arena<vissprite_t> vissprites{MAXVISSPRITES};
 vissprite_t* vissprite_p;
 int		newvissprite;
 
+// Called when the view size changes.
+void R_ResizeSprites(int32 width, int32 height)
+{
+    negonearray.assign(width, -1);
+    screenheightarray.assign(width, nstd::size_cast<int16>(height));
+}
+
 // Called at program start.
 void R_InitSprites(Doom* doom, const vector<string_view>& names)
 {
-    for (int i = 0; i < SCREENWIDTH; i++)
-    {
-        negonearray[i] = -1;
-    }
-
     R_InitSpriteDefs(doom, names);
 }
 
 // Called at frame start.
 void R_ClearSprites()
 {
-    vissprite_p = vissprites;
+    vissprite_p = vissprites.data();
 }
 
 
 //
 // R_NewVisSprite
 //
-vissprite_t	overflowsprite;
-
 vissprite_t* R_NewVisSprite()
 {
-    if (vissprite_p == &vissprites[MAXVISSPRITES])
-        return &overflowsprite;
+    if (vissprite_p == vissprites.end())
+        vissprites.grow(vissprite_p);
 
     vissprite_p++;
     return vissprite_p - 1;
@@ -307,7 +309,7 @@ void R_DrawVisSprite(vissprite_t* vis, [[maybe_unused]] int x1, [[maybe_unused]]
     }
     else if (vis->mobjflags & MF_TRANSLATION)
     {
-        colfunc = R_DrawTranslatedColumn;
+        colfunc = transcolfunc;
         dc_translation = translationtables - 256 +
             ((vis->mobjflags & MF_TRANSLATION) >> (MF_TRANSSHIFT - 8));
     }
@@ -450,7 +452,7 @@ void R_ProjectSprite(mobj_t* thing)
     else
     {
         // diminished light
-        auto index = xscale >> (LIGHTSCALESHIFT - detailshift);
+        auto index = FixedMul(xscale, lightscalenorm) >> (LIGHTSCALESHIFT - detailshift);
 
         if (index >= MAXLIGHTSCALE)
             index = MAXLIGHTSCALE - 1;
@@ -469,11 +471,11 @@ void R_AddSprites(sector_t* sec)
     // A sector might have been split into several
     //  subsectors during BSP building.
     // Thus we check whether its already added.
-    if (sec->validcount == validcount)
+    if (sec->validcount == viewvalidcount)
         return;
 
     // Well, now it will be done.
-    sec->validcount = validcount;
+    sec->validcount = viewvalidcount;
 
     lightnum = (sec->lightlevel >> LIGHTSEGSHIFT) + extralight;
 
@@ -581,7 +583,7 @@ void R_DrawPlayerSprites()
 
     // get light level
     lightnum =
-        (viewplayer->mo->subsector->sector->lightlevel >> LIGHTSEGSHIFT)
+        (R_ViewSector(viewplayer->mo->subsector->sector)->lightlevel >> LIGHTSEGSHIFT)
         + extralight;
 
     if (lightnum < 0)
@@ -592,8 +594,8 @@ void R_DrawPlayerSprites()
         spritelights = scalelight[lightnum];
 
     // clip to screen bounds
-    mfloorclip = screenheightarray;
-    mceilingclip = negonearray;
+    mfloorclip = screenheightarray.data();
+    mceilingclip = negonearray.data();
 
     // add all active psprites
     for (i = 0, psp = viewplayer->psprites;
@@ -607,56 +609,83 @@ void R_DrawPlayerSprites()
 
 //
 // R_SortVisSprites
+// Back to front is by increasing scale, sprites of the same scale
+// in the order they were projected. Each key is the scale over the
+// vissprite's index, so a plain sort of the keys is a stable one.
 //
-vissprite_t	vsprsortedhead;
+vector<uint64> vsprkeys;
+vector<int32> vsprsorted;
 
 void R_SortVisSprites()
 {
-    fixed_t		bestscale;
+    int32 count = vissprite_p - vissprites.data();
+
+    vsprkeys.resize(count);
+    for (int32 i = 0; i < count; i++)
+    {
+        // flipping the sign bit orders signed scales as unsigned
+        auto scale = static_cast<uint32>(vissprites[i].scale) ^ 0x80000000u;
+        vsprkeys[i] = (static_cast<uint64>(scale) << 32) | static_cast<uint32>(i);
+    }
 
-    int count = vissprite_p - vissprites;
+    std::sort(vsprkeys.begin(), vsprkeys.end());
 
-    vissprite_t unsorted;
-    unsorted.next = unsorted.prev = &unsorted;
+    vsprsorted.resize(count);
+    for (int32 i = 0; i < count; i++)
+        vsprsorted[i] = static_cast<int32>(vsprkeys[i] & 0xffffffff);
+}
 
-    if (!count)
-        return;
+//
+// R_BinDrawSegs
+// The drawsegs that can clip or mask a sprite, binned by the columns
+// they cover once the BSP walk is done, so a sprite only looks at the
+// drawsegs next to it instead of all of them. Each bin is in drawing
+// order.
+//
+#define DSBINSHIFT		5
 
-    for (vissprite_t* ds = vissprites; ds < vissprite_p; ds++)
-    {
-        ds->next = ds + 1;
-        ds->prev = ds - 1;
-    }
+vector<vector<int32>> drawsegbins;
+vector<int32> spritedrawsegs;
 
-    vissprites[0].prev = &unsorted;
-    unsorted.next = &vissprites[0];
-    (vissprite_p - 1)->next = &unsorted;
-    unsorted.prev = vissprite_p - 1;
+void R_BinDrawSegs()
+{
+    auto bins = (viewwidth >> DSBINSHIFT) + 1;
+    if (drawsegbins.size() < bins)
+        drawsegbins.resize(bins);
+
+    for (auto& bin : drawsegbins)
+        bin.clear();
 
-    // pull the vissprites out by scale
-    //best = 0;		// shut up the compiler warning
-    vissprite_t* best = nullptr;
-    vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
-    for (int i = 0; i < count; i++)
+    int32 count = ds_p - drawsegs.data();
+    for (int32 i = 0; i < count; i++)
     {
-        bestscale = std::numeric_limits<decltype(bestscale)>::max();
-        for (vissprite_t* ds = unsorted.next; ds != &unsorted; ds = ds->next)
-        {
-            if (ds->scale < bestscale)
-            {
-                bestscale = ds->scale;
-                best = ds;
-            }
-        }
-        best->next->prev = best->prev;
-        best->prev->next = best->next;
-        best->next = &vsprsortedhead;
-        best->prev = vsprsortedhead.prev;
-        vsprsortedhead.prev->next = best;
-        vsprsortedhead.prev = best;
+        auto* ds = &drawsegs[i];
+        if (!ds->silhouette && !ds->maskedtexturecol)
+            continue;
+
+        for (auto bin = ds->x1 >> DSBINSHIFT; bin <= ds->x2 >> DSBINSHIFT; bin++)
+            drawsegbins[bin].push_back(i);
     }
 }
 
+// The drawsegs in the bins the sprite covers, in drawing order.
+const vector<int32>& R_SpriteDrawSegs(vissprite_t* spr)
+{
+    auto first = spr->x1 >> DSBINSHIFT;
+    auto last = spr->x2 >> DSBINSHIFT;
+    if (first == last)
+        return drawsegbins[first];
+
+    spritedrawsegs.clear();
+    for (auto bin = first; bin <= last; bin++)
+        spritedrawsegs.insert(spritedrawsegs.end(), drawsegbins[bin].begin(), drawsegbins[bin].end());
+
+    // a drawseg over several bins is in each of them
+    std::sort(spritedrawsegs.begin(), spritedrawsegs.end());
+    spritedrawsegs.erase(std::unique(spritedrawsegs.begin(), spritedrawsegs.end()), spritedrawsegs.end());
+    return spritedrawsegs;
+}
+
 
 
 //
@@ -665,8 +694,8 @@ void R_SortVisSprites()
 void R_DrawSprite(vissprite_t* spr)
 {
     drawseg_t* ds;
-    short		clipbot[SCREENWIDTH];
-    short		cliptop[SCREENWIDTH];
+    short		clipbot[MAXWIDTH];
+    short		cliptop[MAXWIDTH];
     int			x;
     int			r1;
     int			r2;
@@ -680,8 +709,11 @@ void R_DrawSprite(vissprite_t* spr)
     // Scan drawsegs from end to start for obscuring segs.
     // The first drawseg that has a greater scale
     //  is the clip seg.
-    for (ds = ds_p - 1; ds >= drawsegs; ds--)
+    auto& nearby = R_SpriteDrawSegs(spr);
+    for (auto n = nearby.size() - 1; n >= 0; n--)
     {
+        ds = &drawsegs[nearby[n]];
+
         // determine if the drawseg obscures the sprite
         if (ds->x1 > spr->x2
             || ds->x2 < spr->x1
@@ -780,25 +812,21 @@ void R_DrawSprite(vissprite_t* spr)
 //
 void R_DrawMasked()
 {
-    vissprite_t* spr;
+    bench::scoped_sample maskedSample("masked");
     drawseg_t* ds;
 
     R_SortVisSprites();
+    R_BinDrawSegs();
 
-    if (vissprite_p > vissprites)
-    {
-        // draw all vissprites back to front
-        for (spr = vsprsortedhead.next;
-            spr != &vsprsortedhead;
-            spr = spr->next)
-        {
+    bench::peak("drawsegs", ds_p - drawsegs.data());
+    bench::peak("vissprites", vissprite_p - vissprites.data());
 
-            R_DrawSprite(spr);
-        }
-    }
+    // draw all vissprites back to front
+    for (auto index : vsprsorted)
+        R_DrawSprite(&vissprites[index]);
 
     // render any remaining masked mid textures
-    for (ds = ds_p - 1; ds >= drawsegs; ds--)
+    for (ds = ds_p - 1; ds >= drawsegs.data(); ds--)
         if (ds->maskedtexturecol)
             R_RenderMaskedSegRange(ds, ds->x1, ds->x2);
 
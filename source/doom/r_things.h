@@ -18,18 +18,22 @@
 #pragma once
 
 import nstd;
+import arena;
 
 class Doom;
 
+// Starting capacity, the vissprite arena grows past it.
 #define MAXVISSPRITES  	128
 
-extern vissprite_t	vissprites[MAXVISSPRITES];
+extern frame_arena<vissprite_t> vissprites;
 extern vissprite_t* vissprite_p;
-extern vissprite_t	vsprsortedhead;
+
+// The vissprites back to front, as indices, after R_SortVisSprites.
+extern vector<int32> vsprsorted;
 
 // Constant arrays used for psprite clipping and initializing clipping.
-extern int16 negonearray[SCREENWIDTH];
-extern int16 screenheightarray[SCREENWIDTH];
+extern vector<int16> negonearray;
+extern vector<int16> screenheightarray;
 
 // vars for R_DrawMaskedColumn
 extern short* mfloorclip;
@@ -50,6 +54,8 @@ void R_AddSprites(sector_t* sec);
 void R_AddPSprites();
 void R_DrawSprites();
 void R_InitSprites(Doom* doom, const vector<string_view>& names);
+// Sizes the clipping arrays for a view width by height render pixels.
+void R_ResizeSprites(int32 width, int32 height);
 void R_ClearSprites();
 void R_DrawMasked();
 
@@ -266,11 +266,7 @@ void S_Start()
 {
     // kill all playing sounds at start of level
     //  (trust me - a good idea)
-    for (int32 cnum = 0; cnum < numChannels; cnum++)
-    {
-        if (channels[cnum].sfxinfo)
-            S_StopChannel(cnum);
-    }
+    S_StopSounds();
 
     // start new music for the level
     mus_paused = false;
@@ -423,6 +419,15 @@ void S_StopSound(void* origin)
     }
 }
 
+void S_StopSounds()
+{
+    for (int32 cnum = 0; cnum < numChannels; cnum++)
+    {
+        if (channels[cnum].sfxinfo)
+            S_StopChannel(cnum);
+    }
+}
+
 // Stop and resume music, during game PAUSE.
 void S_PauseSound()
 {
@@ -37,6 +37,10 @@ void S_StartSoundAtVolume(void* origin, int32 sound_id, int32 volume);
 // Stop sound for thing at <origin>
 void S_StopSound(void* origin);
 
+// Stops every sound playing, for when the things they come from are
+// gone at once.
+void S_StopSounds();
+
 // Start music using <music_id> from sounds.h
 void S_StartMusic(int music_id);
 
@@ -262,3 +262,63 @@ void V_GetBlock(int x, int y, int scrn, int width, int height, byte* dest)
         dest += width;
     }
 }
+
+void Video::SetPalette(const byte* inPalette)
+{
+    auto* p = inPalette;
+    for (int32 n = 0; n < 256; ++n, p += 3)
+    {
+        palette[n] = 0xff'00'00'00 | (*(p + 2) << 16) | (*(p + 1) << 8) | (*(p + 0) << 0);
+    }
+
+    isPaletteDirty = true;
+}
+
+// Masks a column based masked pic to the screen. 
+void Video::DrawPatch(int32 x, int32 y, int32 screen, const patch_t* patch)
+{
+    y -= patch->topoffset;
+    x -= patch->leftoffset;
+#ifdef RANGECHECK 
+    if (x<0
+        || x + (patch->width) >SCREENWIDTH
+        || y<0
+        || y + (patch->height)>SCREENHEIGHT
+        || screen > 4)
+    {
+        std::cerr << std::format("Patch at {},{} exceeds LFB\n", x, y);
+        // No I_Error abort - what is up with TNT.WAD?
+        std::cerr << "Video::DrawPatch: bad patch (ignored)\n";
+        return;
+    }
+#endif 
+
+    auto* desttop = screens[screen] + y * SCREENWIDTH + x;
+    auto w = patch->width;
+    for (int32 col = 0; col < w; x++, col++, desttop++)
+    {
+        auto* column = (column_t*)((byte*)patch + (patch->columnofs[col]));
+
+        // step through the posts in a column 
+        while (column->topdelta != 0xff)
+        {
+            auto* source = (byte*)column + 3;
+            auto* dest = desttop + column->topdelta * SCREENWIDTH;
+            auto count = column->length;
+
+            while (count--)
+            {
+                *dest = *source++;
+                dest += SCREENWIDTH;
+            }
+            column = (column_t*)((byte*)column + column->length + 4);
+        }
+    }
+}
+
+byte* Video::CopyScreen(int32 dest) const
+{
+    assert(dest > 0 && dest < std::size(screens));
+    memcpy(screens[dest], screens[0], SCREENWIDTH * SCREENHEIGHT);
+    return screens[dest];
+}
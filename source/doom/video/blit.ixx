@@ -0,0 +1,97 @@
+module;
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC lets any function use AVX2 intrinsics, GCC and Clang want it enabled per function.
+#if defined(__GNUC__)
+#define BLIT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BLIT_TARGET_AVX2
+#endif
+
+export module blit;
+
+import std;
+import nstd;
+
+// Converts rows of 8 bit palette indices into 32 bit RGBA for presenting the screen.
+export namespace blit {
+
+enum class kernel : uint8
+{
+    scalar,
+    avx2,
+};
+
+constexpr string_view name(kernel k)
+{
+    switch (k)
+    {
+    case kernel::avx2: return "avx2";
+    case kernel::scalar:
+    default: return "scalar";
+    }
+}
+
+// The fastest kernel the CPU (and OS) supports.
+kernel best_kernel()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return kernel::scalar;
+
+    // AVX state has to be enabled by the OS too.
+    __cpuid(info, 1);
+    auto osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6)
+        return kernel::scalar;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) ? kernel::avx2 : kernel::scalar;
+#elif defined(__GNUC__)
+    return __builtin_cpu_supports("avx2") ? kernel::avx2 : kernel::scalar;
+#else
+    return kernel::scalar;
+#endif
+}
+
+void convert_scalar(const byte* src, const uint32* palette, uint32* dest, int32 count)
+{
+    for (int32 n = 0; n < count; ++n)
+        dest[n] = palette[src[n]];
+}
+
+// Widens 16 indices at a time to 32 bits and looks them up with two 8 lane gathers. SSE4.1 has
+// no gather, and a pshufb table only covers 16 entries, so anything below AVX2 uses the scalar
+// loop.
+BLIT_TARGET_AVX2 void convert_avx2(const byte* src, const uint32* palette, uint32* dest, int32 count)
+{
+    auto* table = reinterpret_cast<const int*>(palette);
+
+    int32 n = 0;
+    for (; n + 16 <= count; n += 16)
+    {
+        auto indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+        auto lo = _mm256_cvtepu8_epi32(indices);
+        auto hi = _mm256_cvtepu8_epi32(_mm_srli_si128(indices, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + n), _mm256_i32gather_epi32(table, lo, 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + n + 8), _mm256_i32gather_epi32(table, hi, 4));
+    }
+
+    convert_scalar(src + n, palette, dest + n, count - n);
+}
+
+void convert(kernel k, const byte* src, const uint32* palette, uint32* dest, int32 count)
+{
+    if (k == kernel::avx2)
+        convert_avx2(src, palette, dest, count);
+    else
+        convert_scalar(src, palette, dest, count);
+}
+
+} // export namespace blit
@@ -0,0 +1,126 @@
+module;
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC lets any function use AVX2 intrinsics, GCC and Clang want it enabled per function.
+#if defined(__GNUC__)
+#define SPANS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SPANS_TARGET_AVX2
+#endif
+
+export module spans;
+
+import std;
+import nstd;
+
+// Draws a horizontal run of a 64x64 flat, as R_DrawSpan does for floors and ceilings: the flat
+// position steps by a fixed amount per pixel, and each texel goes through the light level's
+// colormap. Every kernel writes exactly what the scalar one does.
+export namespace spans {
+
+enum class kernel : uint8
+{
+    scalar,
+    avx2,
+};
+
+constexpr string_view name(kernel k)
+{
+    switch (k)
+    {
+    case kernel::avx2: return "avx2";
+    case kernel::scalar:
+    default: return "scalar";
+    }
+}
+
+// The fastest kernel the CPU (and OS) supports.
+kernel best_kernel()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return kernel::scalar;
+
+    // AVX state has to be enabled by the OS too.
+    __cpuid(info, 1);
+    auto osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6)
+        return kernel::scalar;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) ? kernel::avx2 : kernel::scalar;
+#elif defined(__GNUC__)
+    return __builtin_cpu_supports("avx2") ? kernel::avx2 : kernel::scalar;
+#else
+    return kernel::scalar;
+#endif
+}
+
+// xfrac and yfrac are 16.16, wrapping like the original fixed_t arithmetic. Only bits 16 to 21
+// of each pick the texel, so shifting them as unsigned gives the same spot.
+void draw_scalar(const byte* source, const byte* colormap, byte* dest, uint32 xfrac, uint32 yfrac, uint32 xstep, uint32 ystep, int32 count)
+{
+    for (int32 n = 0; n < count; ++n)
+    {
+        auto spot = ((yfrac >> (16 - 6)) & (63 * 64)) + ((xfrac >> 16) & 63);
+        dest[n] = colormap[source[spot]];
+        xfrac += xstep;
+        yfrac += ystep;
+    }
+}
+
+// 8 pixels at a time: the positions of all 8 are stepped in a vector, and the texels and then
+// the colormap entries fetched with byte offset gathers. A gather loads a whole int32, so each
+// one reads the three bytes before the wanted one and keeps the top byte. Those are always
+// readable: flats come from the WAD data, which starts after the WAD header, and the colormaps
+// from inside the zone.
+SPANS_TARGET_AVX2 void draw_avx2(const byte* source, const byte* colormap, byte* dest, uint32 xfrac, uint32 yfrac, uint32 xstep, uint32 ystep, int32 count)
+{
+    auto* texels = reinterpret_cast<const int*>(source - 3);
+    auto* lights = reinterpret_cast<const int*>(colormap - 3);
+
+    auto lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    auto x = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(xfrac)), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(static_cast<int>(xstep))));
+    auto y = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(yfrac)), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(static_cast<int>(ystep))));
+    auto xstep8 = _mm256_set1_epi32(static_cast<int>(xstep * 8));
+    auto ystep8 = _mm256_set1_epi32(static_cast<int>(ystep * 8));
+    auto xmask = _mm256_set1_epi32(63);
+    auto ymask = _mm256_set1_epi32(63 * 64);
+
+    int32 n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        auto spot = _mm256_add_epi32(
+            _mm256_and_si256(_mm256_srli_epi32(y, 16 - 6), ymask),
+            _mm256_and_si256(_mm256_srli_epi32(x, 16), xmask));
+        auto texel = _mm256_srli_epi32(_mm256_i32gather_epi32(texels, spot, 1), 24);
+        auto pixel = _mm256_srli_epi32(_mm256_i32gather_epi32(lights, texel, 1), 24);
+
+        // Narrow to bytes, each 128 bit half ends up with its 4 pixels in the low dword.
+        auto words = _mm256_packus_epi32(pixel, pixel);
+        auto bytes = _mm256_packus_epi16(words, words);
+        auto out = _mm_unpacklo_epi32(_mm256_castsi256_si128(bytes), _mm256_extracti128_si256(bytes, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + n), out);
+
+        x = _mm256_add_epi32(x, xstep8);
+        y = _mm256_add_epi32(y, ystep8);
+    }
+
+    draw_scalar(source, colormap, dest + n, xfrac + n * xstep, yfrac + n * ystep, xstep, ystep, count - n);
+}
+
+void draw(kernel k, const byte* source, const byte* colormap, byte* dest, uint32 xfrac, uint32 yfrac, uint32 xstep, uint32 ystep, int32 count)
+{
+    if (k == kernel::avx2)
+        draw_avx2(source, colormap, dest, xfrac, yfrac, xstep, ystep, count);
+    else
+        draw_scalar(source, colormap, dest, xfrac, yfrac, xstep, ystep, count);
+}
+
+} // export namespace spans
@@ -16,6 +16,7 @@
 //
 //-----------------------------------------------------------------------------
 import std;
+import config;
 
 #include "i_system.h"
 #include "m_swap.h"
@@ -27,7 +28,50 @@ vector<filesys::path> WadManager::loadList;
 vector<FileInfo> WadManager::files;
 vector<WadInfo> WadManager::wads;
 vector<LumpInfo> WadManager::lumps;
-std::map<string, int32> WadManager::lumpDirectory;
+LumpTable WadManager::lumpDirectory;
+bool WadManager::useMapping = true;
+
+FileInfo::~FileInfo()
+{
+    if (!data)
+        return;
+
+    if (isMapped)
+        I_UnmapFile(data, size);
+    else
+        delete[] data;
+}
+
+bool FileInfo::MapFile()
+{
+    int64 mappedSize = 0;
+    data = I_MapFile(path, mappedSize);
+    if (!data)
+        return false;
+
+    if (mappedSize > std::numeric_limits<int32>::max())
+        I_Error("FileInfo::MapFile: {} is too big", path);
+
+    size = static_cast<int32>(mappedSize);
+    isMapped = true;
+    return true;
+}
+
+bool FileInfo::ReadFile()
+{
+    std::ifstream file{path, std::ios_base::binary};
+    if (!file.is_open())
+        return false;
+
+    file.seekg(0, std::ios_base::end);
+    size = static_cast<int32>(file.tellg());
+    auto* buffer = new byte[size];
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer), size);
+    data = buffer;
+    isMapped = false;
+    return true;
+}
 
 // LUMP BASED ROUTINES.
 
@@ -40,18 +84,16 @@ void WadManager::LoadFile(const filesys::path& path)
     std::cout << "Checking for " << path << " ... " << filesys::exists(path) << "\n";
 
     // open the file and add to directory
-    std::ifstream file{path, std::ios_base::binary};
-    if (!file.is_open())
+    FileInfo info;
+    info.path = path;
+    if (!(useMapping && info.MapFile()) && !info.ReadFile())
     {
         std::cout << " couldn't open" << path << "\n";
         return;
     }
 
-    std::cout << " adding " << path << "\n";
+    std::cout << " adding " << path << (info.isMapped ? " (mapped)" : "") << "\n";
 
-    FileInfo info;
-    info.path = path;
-    info.ReadFile(file);
     info.id = files.size();
 
     if (path.extension().string().to_lower() == ".wad")
@@ -67,10 +109,26 @@ void WadManager::LoadFile(const filesys::path& path)
         wad.id = wads.size();
         wads.push_back(wad);
 
-        auto* entry = reinterpret_cast<LumpHeader*>(info.data + wad.directoryOffset);
+        auto ns = LumpNamespace::Global;
+        auto* entry = reinterpret_cast<const LumpHeader*>(info.data + wad.directoryOffset);
         for (int32 n = 0; n < wad.lumpCount; ++n, ++entry)
         {
-            StoreLump(info.id, {entry->name, 8}, entry->size, info.data + entry->offset, wad.id);
+            string_view name{entry->name, 8};
+
+            // The markers themselves stay global.
+            auto isMarker = true;
+            switch (PackLumpName(name))
+            {
+            case PackLumpName("S_START"): case PackLumpName("SS_START"): ns = LumpNamespace::Sprites; break;
+            case PackLumpName("F_START"): case PackLumpName("FF_START"): ns = LumpNamespace::Flats; break;
+            case PackLumpName("P_START"): case PackLumpName("PP_START"): ns = LumpNamespace::Patches; break;
+            case PackLumpName("S_END"): case PackLumpName("SS_END"):
+            case PackLumpName("F_END"): case PackLumpName("FF_END"):
+            case PackLumpName("P_END"): case PackLumpName("PP_END"): ns = LumpNamespace::Global; break;
+            default: isMarker = false; break;
+            }
+
+            StoreLump(info.id, name, entry->size, info.data + entry->offset, wad.id, isMarker ? LumpNamespace::Global : ns);
         }
     }
     else
@@ -81,7 +139,7 @@ void WadManager::LoadFile(const filesys::path& path)
     files.push_back(std::move(info));
 }
 
-void WadManager::StoreLump(int32 fileId, string_view name, int32 size, byte* data, int32 wadId /*= INVALID_ID*/)
+void WadManager::StoreLump(int32 fileId, string_view name, int32 size, const byte* data, int32 wadId /*= INVALID_ID*/, LumpNamespace ns /*= LumpNamespace::Global*/)
 {
     LumpInfo lump;
     lump.fileId = fileId;
@@ -89,9 +147,14 @@ void WadManager::StoreLump(int32 fileId, string_view name, int32 size, byte* dat
     lump.name = name.trim().to_upper();
     lump.size = size;
     lump.data = data;
+    lump.ns = ns;
     lump.id = lumps.size();
     lumps.push_back(lump);
-    lumpDirectory[lump.name] = lump.id;
+
+    auto key = PackLumpName(lump.name);
+    lumpDirectory.Add(key, LumpNamespace::Global, lump.id);
+    if (ns != LumpNamespace::Global)
+        lumpDirectory.Add(key, ns, lump.id);
 }
 
 // Pass a null terminated list of files to use.
@@ -104,11 +167,21 @@ void WadManager::LoadAllFiles()
 {
     std::cout << "Current path: " << filesys::current_path() << "\n";
 
+    useMapping = !CommandLine::HasArg("-nommap");
+
+    auto start = std::chrono::steady_clock::now();
+    auto startResident = I_GetResidentBytes();
+
     for (auto& file : loadList)
         LoadFile(file);
 
     if (lumps.empty())
         I_Error("WadManager::LoadAllFiles: no files found");
+
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    auto residentMB = (I_GetResidentBytes() - startResident) / (1024.0 * 1024.0);
+    std::cout << std::format("WadManager::LoadAllFiles: {} files {} in {:.2f} ms, resident memory grew {:.2f} MB\n",
+        files.size(), useMapping ? "mapped" : "read", ms, residentMB);
 }
 
 // Calls WadManager::GetLumpId, but bombs out if not found.
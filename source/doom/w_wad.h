@@ -19,6 +19,7 @@
 
 import std;
 import nstd;
+import lumptable;
 
 import <cassert>;
 
@@ -33,25 +34,23 @@ struct FileInfo
         , path{other.path}
         , size{other.size}
         , data{other.data}
+        , isMapped{other.isMapped}
     {
         other.data = nullptr;
     }
 
-    ~FileInfo() { delete[] data; }
+    ~FileInfo();
 
-    void ReadFile(std::ifstream& file)
-    {
-        file.seekg(0, std::ios_base::end);
-        size = static_cast<int32>(file.tellg());
-        data = new byte[size];
-        file.seekg(0);
-        file.read(reinterpret_cast<char*>(data), size);
-    }
+    // Maps the file into memory, nothing is read until a lump is used.
+    bool MapFile();
+    // Reads the whole file into memory, used when it can't be mapped or with -nommap.
+    bool ReadFile();
 
     int32 id = INVALID_ID;
     filesys::path path;
     int32 size = 0;
-    byte* data = nullptr;
+    const byte* data = nullptr;
+    bool isMapped = false;
 };
 
 struct WadInfo
@@ -59,8 +58,8 @@ struct WadInfo
     WadInfo(const FileInfo& info)
         : fileId{info.id}
         , tag{info.data, 4}
-        , lumpCount{*reinterpret_cast<int32*>(info.data + 4)}
-        , directoryOffset{*reinterpret_cast<int32*>(info.data + 8)}
+        , lumpCount{*reinterpret_cast<const int32*>(info.data + 4)}
+        , directoryOffset{*reinterpret_cast<const int32*>(info.data + 8)}
     {        
     }
 
@@ -91,10 +90,11 @@ struct LumpInfo
 
     string name;
     int32 size = 0;
-    byte* data = nullptr;
+    const byte* data = nullptr;
+    LumpNamespace ns = LumpNamespace::Global;
 
     template<typename T = void>
-    const T* as() const { return reinterpret_cast<T*>(data); }
+    const T* as() const { return reinterpret_cast<const T*>(data); }
 };
 
 class WadManager
@@ -104,13 +104,21 @@ public:
 
     static void AddFile(const filesys::path& path) { loadList.push_back(path); }
 
-    static int32 GetLumpId(string_view name)
+    // Only the first 8 characters of the name count, case doesn't.
+    static int32 GetLumpId(string_view name) { return lumpDirectory.Get(PackLumpName(name)); }
+
+    // The last lump of that name, so a later file still wins: PWADs often leave their patches
+    // and sprites outside any markers. Only when that lump is in another namespace (a flat with
+    // a patch's name) is the last one in this namespace taken instead.
+    static int32 GetLumpId(string_view name, LumpNamespace ns)
     {
-        auto it = lumpDirectory.find(string{name});
-        if (it == lumpDirectory.end())
-            return INVALID_ID;
+        auto key = PackLumpName(name);
+        auto id = lumpDirectory.Get(key);
+        if (id == INVALID_ID || lumps[id].ns == LumpNamespace::Global || lumps[id].ns == ns)
+            return id;
 
-        return it->second;
+        auto nsid = lumpDirectory.Get(key, ns);
+        return nsid != INVALID_ID ? nsid : id;
     }
 
     static const LumpInfo* FindLump(string_view name) { return FindLump(GetLumpId(name)); }
@@ -126,11 +134,12 @@ public:
 
 private:
     static void LoadFile(const filesys::path& path);
-    static void StoreLump(int32 fileId, string_view name, int32 size, byte* data, int32 wadId = INVALID_ID);
+    static void StoreLump(int32 fileId, string_view name, int32 size, const byte* data, int32 wadId = INVALID_ID, LumpNamespace ns = LumpNamespace::Global);
 
     static vector<filesys::path> loadList;
     static vector<FileInfo> files;
     static vector<WadInfo> wads;
     static vector<LumpInfo> lumps;
-    static std::map<string, int32> lumpDirectory;
+    static LumpTable lumpDirectory;
+    static bool useMapping;
 };
@@ -0,0 +1,106 @@
+export module lumptable;
+
+import std;
+import nstd;
+
+export {
+
+// Lumps between S_START/S_END, F_START/F_END and P_START/P_END (or the SS_, FF_ and PP_ variants
+// PWADs use). Everything is also in Global, which is what a plain name lookup searches.
+enum class LumpNamespace : uint8
+{
+    Global,
+    Sprites,
+    Flats,
+    Patches,
+};
+
+// A lump name as the 8 bytes of a uint64, upper cased and zero padded, the same way it's stored
+// in a WAD directory. Anything past 8 characters or the first zero is ignored.
+constexpr uint64 PackLumpName(string_view name)
+{
+    uint64 key = 0;
+    for (int32 n = 0; n < 8 && std::cmp_less(n, name.size()) && name[n]; ++n)
+    {
+        auto c = name[n];
+        if (c >= 'a' && c <= 'z')
+            c -= 'a' - 'A';
+
+        key |= static_cast<uint64>(static_cast<uint8>(c)) << (n * 8);
+    }
+    return key;
+}
+
+// Open addressing (linear probing) map from packed lump name and namespace to lump id. Adding a
+// name again replaces the id, so the lump from the last file loaded wins.
+class LumpTable
+{
+public:
+    void Add(uint64 name, LumpNamespace ns, int32 id)
+    {
+        if ((count + 1) * 2 > slots.size())
+            Grow();
+
+        auto& slot = Find(name, ns);
+        if (slot.id == INVALID_ID)
+        {
+            slot.name = name;
+            slot.ns = ns;
+            ++count;
+        }
+        slot.id = id;
+    }
+
+    int32 Get(uint64 name, LumpNamespace ns = LumpNamespace::Global) const
+    {
+        if (slots.empty())
+            return INVALID_ID;
+
+        return Find(name, ns).id;
+    }
+
+    int32 GetCount() const { return count; }
+
+private:
+    struct Slot
+    {
+        uint64 name = 0;
+        int32 id = INVALID_ID;
+        LumpNamespace ns = LumpNamespace::Global;
+    };
+
+    // Either the slot holding the key, or the empty one where it would go.
+    template<typename Self>
+    static auto& Find(Self& self, uint64 name, LumpNamespace ns)
+    {
+        auto mask = self.slots.size() - 1;
+        auto hash = (name ^ static_cast<uint64>(ns)) * 0x9e37'79b9'7f4a'7c15ull;
+        for (auto n = static_cast<int32>(hash >> 32) & mask; ; n = (n + 1) & mask)
+        {
+            auto& slot = self.slots[n];
+            if (slot.id == INVALID_ID || (slot.name == name && slot.ns == ns))
+                return slot;
+        }
+    }
+
+    Slot& Find(uint64 name, LumpNamespace ns) { return Find(*this, name, ns); }
+    const Slot& Find(uint64 name, LumpNamespace ns) const { return Find(*this, name, ns); }
+
+    void Grow()
+    {
+        auto old = std::move(slots);
+        slots = vector<Slot>(std::max(old.size() * 2, 256));
+        count = 0;
+
+        for (auto& slot : old)
+        {
+            if (slot.id != INVALID_ID)
+                Add(slot.name, slot.ns, slot.id);
+        }
+    }
+
+    vector<Slot> slots;
+    int32 count = 0;
+};
+
+} // export
@@ -16,6 +16,7 @@
 //
 //-----------------------------------------------------------------------------
 import std;
+import config;
 
 #include "z_zone.h"
 #include "i_system.h"
@@ -48,6 +49,251 @@ typedef struct
 
 memzone_t* mainzone;
 
+#define MINFRAGMENT		64
+
+//
+// Size class allocator (-zoneclasses)
+// Uses the same zone, block headers and physical block list as the first fit allocator below,
+// so Z_CheckHeap and the heap dumps work on both. On top of that, every free block is kept in a
+// free list for its size class (one class per power of two), and every block in use in a list
+// for its tag. Allocating takes the first free block that fits from the smallest class that can
+// have one, and Z_FreeTags only visits the blocks that have the tags. Purgable blocks are only
+// thrown out when no free block is big enough, least recently tagged first.
+//
+static bool usesizeclasses = false;
+
+#define NUMSIZECLASSES	64
+#define NUMZONETAGS		(PU_CACHE + 1)
+
+static memblock_t freelists[NUMSIZECLASSES];
+static uint64 freeclasses;
+static memblock_t taglists[NUMZONETAGS];
+
+static int32 ZC_SizeClass(intptr_t size)
+{
+    return std::bit_width(static_cast<uint64>(size)) - 1;
+}
+
+static void ZC_Unlink(memblock_t* block)
+{
+    block->listprev->listnext = block->listnext;
+    block->listnext->listprev = block->listprev;
+}
+
+static void ZC_Link(memblock_t* list, memblock_t* block)
+{
+    block->listnext = list;
+    block->listprev = list->listprev;
+    list->listprev->listnext = block;
+    list->listprev = block;
+}
+
+static memblock_t* ZC_TagList(int32 tag)
+{
+    if (tag < 0 || tag >= NUMZONETAGS)
+        I_Error("Z_Malloc: bad tag {}", tag);
+
+    return &taglists[tag];
+}
+
+static void ZC_AddFree(memblock_t* block)
+{
+    auto sizeclass = ZC_SizeClass(block->size);
+    ZC_Link(&freelists[sizeclass], block);
+    freeclasses |= 1ull << sizeclass;
+}
+
+static void ZC_RemoveFree(memblock_t* block)
+{
+    auto sizeclass = ZC_SizeClass(block->size);
+    ZC_Unlink(block);
+    if (freelists[sizeclass].listnext == &freelists[sizeclass])
+        freeclasses &= ~(1ull << sizeclass);
+}
+
+static void ZC_Init()
+{
+    for (auto& list : freelists)
+        list.listnext = list.listprev = &list;
+    for (auto& list : taglists)
+        list.listnext = list.listprev = &list;
+    freeclasses = 0;
+
+    ZC_AddFree(mainzone->blocklist.next);
+}
+
+// Returns the free block the space ended up in after merging with its neighbours.
+static memblock_t* ZC_Free(memblock_t* block)
+{
+    if (block->user > (void**)0x100)
+        *block->user = 0;
+
+    ZC_Unlink(block);
+
+    // mark as free
+    block->user = nullptr;
+    block->tag = 0;
+    block->id = 0;
+
+    memblock_t* other = block->prev;
+    if (!other->user)
+    {
+        // merge with previous free block
+        ZC_RemoveFree(other);
+        other->size += block->size;
+        other->next = block->next;
+        other->next->prev = other;
+        block = other;
+    }
+
+    other = block->next;
+    if (!other->user)
+    {
+        // merge the next free block onto the end
+        ZC_RemoveFree(other);
+        block->size += other->size;
+        block->next = other->next;
+        block->next->prev = block;
+    }
+
+    ZC_AddFree(block);
+    return block;
+}
+
+static memblock_t* ZC_FindFree(intptr_t size)
+{
+    // Blocks in the size's own class can still be too small...
+    auto sizeclass = ZC_SizeClass(size);
+    for (auto* block = freelists[sizeclass].listnext; block != &freelists[sizeclass]; block = block->listnext)
+    {
+        if (block->size >= size)
+            return block;
+    }
+
+    // ...any block in a bigger one fits.
+    auto bigger = sizeclass + 1 < NUMSIZECLASSES ? freeclasses & (~0ull << (sizeclass + 1)) : 0;
+    if (!bigger)
+        return nullptr;
+
+    return freelists[std::countr_zero(bigger)].listnext;
+}
+
+static void* ZC_Malloc(intptr_t size, int32 tag, void* user)
+{
+    size = (size + 3) & ~3;
+    size += sizeof(memblock_t);
+
+    if (!user && tag >= PU_PURGELEVEL)
+        I_Error("Z_Malloc: an owner is required for purgable blocks");
+
+    auto* list = ZC_TagList(tag);
+    auto* base = ZC_FindFree(size);
+
+    // Nothing fits, throw out purgable blocks until the space they leave does.
+    for (int32 purgetag = PU_PURGELEVEL; !base && purgetag < NUMZONETAGS; ++purgetag)
+    {
+        auto* purgelist = &taglists[purgetag];
+        while (!base && purgelist->listnext != purgelist)
+        {
+            auto* space = ZC_Free(purgelist->listnext);
+            if (space->size >= size)
+                base = space;
+        }
+    }
+
+    if (!base)
+        I_Error("Z_Malloc: failed on allocation of {} bytes", static_cast<int64>(size));
+
+    ZC_RemoveFree(base);
+
+    auto extra = base->size - size;
+    if (extra > MINFRAGMENT)
+    {
+        // there will be a free fragment after the allocated block
+        memblock_t* newblock = (memblock_t*)((byte*)base + size);
+        newblock->size = extra;
+        newblock->user = nullptr;
+        newblock->tag = 0;
+        newblock->id = 0;
+        newblock->prev = base;
+        newblock->next = base->next;
+        newblock->next->prev = newblock;
+        ZC_AddFree(newblock);
+
+        base->next = newblock;
+        base->size = size;
+    }
+
+    if (user)
+    {
+        base->user = reinterpret_cast<void**>(user);
+        *(void**)user = (void*)((byte*)base + sizeof(memblock_t));
+    }
+    else
+    {
+        base->user = reinterpret_cast<void**>(2);
+    }
+    base->tag = tag;
+    base->id = ZONEID;
+    ZC_Link(list, base);
+
+    return (void*)((byte*)base + sizeof(memblock_t));
+}
+
+static void ZC_CheckLists()
+{
+    intptr_t freeblocks = 0;
+    intptr_t usedblocks = 0;
+    for (auto* block = mainzone->blocklist.next; block != &mainzone->blocklist; block = block->next)
+    {
+        if (block->user)
+            ++usedblocks;
+        else
+            ++freeblocks;
+    }
+
+    for (int32 sizeclass = 0; sizeclass < NUMSIZECLASSES; ++sizeclass)
+    {
+        auto* list = &freelists[sizeclass];
+        if ((list->listnext != list) != ((freeclasses >> sizeclass) & 1))
+            I_Error("Z_CheckHeap: size class {} doesn't match the class mask\n", sizeclass);
+
+        for (auto* block = list->listnext; block != list; block = block->listnext, --freeblocks)
+        {
+            if (block->user)
+                I_Error("Z_CheckHeap: block in use on a free list\n");
+
+            if (ZC_SizeClass(block->size) != sizeclass)
+                I_Error("Z_CheckHeap: free block of {} bytes in size class {}\n", static_cast<int64>(block->size), sizeclass);
+
+            if (block->listnext->listprev != block)
+                I_Error("Z_CheckHeap: free list doesn't have proper back link\n");
+        }
+    }
+
+    for (int32 tag = 0; tag < NUMZONETAGS; ++tag)
+    {
+        auto* list = &taglists[tag];
+        for (auto* block = list->listnext; block != list; block = block->listnext, --usedblocks)
+        {
+            if (!block->user || block->id != ZONEID)
+                I_Error("Z_CheckHeap: free block on a tag list\n");
+
+            if (block->tag != tag)
+                I_Error("Z_CheckHeap: block with tag {} on the list for tag {}\n", block->tag, tag);
+
+            if (block->listnext->listprev != block)
+                I_Error("Z_CheckHeap: tag list doesn't have proper back link\n");
+        }
+    }
+
+    if (freeblocks != 0)
+        I_Error("Z_CheckHeap: {} free blocks missing from the free lists\n", static_cast<int64>(freeblocks));
+
+    if (usedblocks != 0)
+        I_Error("Z_CheckHeap: {} blocks in use missing from the tag lists\n", static_cast<int64>(usedblocks));
+}
+
 void Z_ClearZone(memzone_t* zone)
 {
     // set the entire zone to one free block
@@ -84,6 +330,13 @@ void Z_Init()
     block->user = nullptr;
 
     block->size = mainzone->size - sizeof(memzone_t);
+
+    usesizeclasses = CommandLine::HasArg("-zoneclasses");
+    if (usesizeclasses)
+    {
+        ZC_Init();
+        std::cout << "Z_Init: using size class free lists.\n";
+    }
 }
 
 //
@@ -96,6 +349,12 @@ void Z_Free(void* p)
     if (block->id != ZONEID)
         I_Error("Z_Free: freed a pointer without ZONEID");
 
+    if (usesizeclasses)
+    {
+        ZC_Free(block);
+        return;
+    }
+
     if (block->user > (void**)0x100)
     {
         // smaller values are not pointers
@@ -142,10 +401,11 @@ void Z_Free(void* p)
 // Z_Malloc
 // You can pass a nullptr user if the tag is < PU_PURGELEVEL.
 //
-#define MINFRAGMENT		64
-
 void* Z_Malloc_internal(intptr_t size, int tag, void* user)
 {
+    if (usesizeclasses)
+        return ZC_Malloc(size, tag, user);
+
     size = (size + 3) & ~3;
 
     // scan through the block list,
@@ -243,6 +503,17 @@ void* Z_Malloc_internal(intptr_t size, int tag, void* user)
 
 void Z_FreeTags(int lowtag, int hightag)
 {
+    if (usesizeclasses)
+    {
+        for (auto tag = std::max(lowtag, 0); tag <= std::min(hightag, NUMZONETAGS - 1); ++tag)
+        {
+            auto* list = &taglists[tag];
+            while (list->listnext != list)
+                ZC_Free(list->listnext);
+        }
+        return;
+    }
+
     memblock_t* next = nullptr;
     for (memblock_t* block = mainzone->blocklist.next; block != &mainzone->blocklist; block = next)
     {
@@ -331,6 +602,9 @@ void Z_CheckHeap()
         if (!block->user && !block->next->user)
             I_Error("Z_CheckHeap: two consecutive free blocks\n");
     }
+
+    if (usesizeclasses)
+        ZC_CheckLists();
 }
 
 void Z_ChangeTag2(void* p, int32 tag)
@@ -343,6 +617,12 @@ void Z_ChangeTag2(void* p, int32 tag)
     if (tag >= PU_PURGELEVEL && reinterpret_cast<intptr_t>(block->user) < 0x100)
         I_Error("Z_ChangeTag: an owner is required for purgable blocks");
 
+    if (usesizeclasses)
+    {
+        ZC_Unlink(block);
+        ZC_Link(ZC_TagList(tag), block);
+    }
+
     block->tag = tag;
 }
 
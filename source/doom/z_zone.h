@@ -65,6 +65,10 @@ struct memblock_t
     int id;	// should be ZONEID
     memblock_t* next;
     memblock_t* prev;
+    // Only used by the -zoneclasses allocator: the size class free list while the block is free,
+    // the list for its tag while it is in use.
+    memblock_t* listnext;
+    memblock_t* listprev;
 };
 
 // This is used to get the local FILE:LINE info from CPP
@@ -2,9 +2,15 @@ import std;
 import nstd;
 
 extern bool test_enum();
+extern bool test_spans();
+extern bool test_triple_buffer();
+extern bool test_fixed();
 
 int  main()
 {
     std::cout << "Running tests...\n";
     test_enum();
+    test_spans();
+    test_triple_buffer();
+    test_fixed();
 }
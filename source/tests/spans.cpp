@@ -0,0 +1,52 @@
+import std;
+import nstd;
+import spans;
+
+// Every span kernel the CPU has has to draw exactly what the scalar one does, for random flats,
+// colormaps, positions, steps (including negative ones and ones that wrap) and lengths.
+bool test_spans()
+{
+    std::mt19937 random{1993};
+
+    // Room before and after, the gather kernels read a little outside the flat and colormap.
+    vector<byte> flat(64 * 64 + 64);
+    vector<byte> colormaps(256 * 34 + 64);
+    for (auto& b : flat)
+        b = static_cast<byte>(random());
+    for (auto& b : colormaps)
+        b = static_cast<byte>(random());
+
+    byte expected[1120];
+    byte actual[1120];
+
+    for (auto k : {spans::kernel::avx2})
+    {
+        if (k > spans::best_kernel())
+        {
+            std::cout << std::format("test_spans: {} not supported here, skipped\n", spans::name(k));
+            continue;
+        }
+
+        for (int32 n = 0; n < 100000; ++n)
+        {
+            auto* colormap = colormaps.data() + 32 + 256 * (random() % 34);
+            auto xfrac = static_cast<uint32>(random());
+            auto yfrac = static_cast<uint32>(random());
+            auto xstep = static_cast<uint32>(static_cast<int32>(random() % (1 << 21)) - (1 << 20));
+            auto ystep = static_cast<uint32>(static_cast<int32>(random() % (1 << 21)) - (1 << 20));
+            auto count = 1 + static_cast<int32>(random() % 1120);
+
+            spans::draw_scalar(flat.data() + 32, colormap, expected, xfrac, yfrac, xstep, ystep, count);
+            spans::draw(k, flat.data() + 32, colormap, actual, xfrac, yfrac, xstep, ystep, count);
+            if (std::memcmp(expected, actual, count) != 0)
+            {
+                std::cout << std::format("test_spans: {} differs from scalar, {} pixels from {:#x}, {:#x} by {:#x}, {:#x}\n",
+                    spans::name(k), count, xfrac, yfrac, xstep, ystep);
+                return false;
+            }
+        }
+    }
+
+    std::cout << "test_spans: ok\n";
+    return true;
+}
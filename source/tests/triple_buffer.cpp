@@ -0,0 +1,47 @@
+import std;
+import nstd;
+import jobs;
+
+// A consumer on another thread only ever sees whole values, each one newer than the last, and
+// ends up with the final one.
+bool test_triple_buffer()
+{
+    struct value
+    {
+        int32 serial = 0;
+        int32 check[15] = {};
+    };
+
+    constexpr int32 Count = 1000000;
+    jobs::triple_buffer<value> buffer;
+
+    std::jthread producer([&]
+    {
+        for (int32 n = 1; n <= Count; ++n)
+        {
+            auto& v = buffer.back();
+            v.serial = n;
+            for (auto& c : v.check)
+                c = n;
+            buffer.publish();
+        }
+    });
+
+    int32 last = 0;
+    int32 updates = 0;
+    bool ok = true;
+    while (ok && last != Count)
+    {
+        if (!buffer.update())
+            continue;
+
+        auto& v = buffer.front();
+        ok = v.serial > last && std::ranges::all_of(v.check, [&](int32 c){ return c == v.serial; });
+        last = v.serial;
+        ++updates;
+    }
+    producer.join();
+
+    std::cout << std::format("test_triple_buffer: {} ({} of {} values seen)\n", ok ? "ok" : "FAILED", updates, Count);
+    return ok;
+}